@@ -100,6 +100,9 @@ public:
   inline uint32_t sp() const { return gp.sp; }
   inline void setSP(uint32_t sp) { gp.sp = sp; }
 
+  // The frame pointer is r7 in Thumb code and r11 in ARM code.
+  inline uint32_t fp() const { return isThumb() ? gp.r7 : gp.r11; }
+
   inline uint32_t retval() const { return gp.r0; }
 
   inline bool isThumb() const { return (gp.cpsr & (1 << 5)) != 0; }
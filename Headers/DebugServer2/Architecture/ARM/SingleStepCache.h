@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Architecture/ARM/Branching.h"
+
+#include <cstddef>
+#include <map>
+
+namespace ds2 {
+namespace Architecture {
+namespace ARM {
+
+//
+// SingleStepCache remembers how the instruction at a given PC and mode was
+// decoded by the software single-step code, so that stepping through the same
+// code again doesn't have to read and decode it again. Only what depends on
+// the instruction bytes is cached; branch targets computed from registers or
+// memory are still evaluated on every step. The owner must invalidate the
+// ranges it writes to, and clear the cache when code may have been unmapped
+// or when the inferior runs code other than the stepped instruction.
+//
+class SingleStepCache {
+public:
+  struct Entry {
+    bool branch;
+    BranchInfo info;
+    // Address of the next sequential instruction; for an IT instruction, the
+    // address of the first instruction past the IT block.
+    uint32_t nextPC;
+  };
+
+public:
+  static size_t const kMaxEntries = 4096;
+
+private:
+  std::map<uint64_t, Entry> _entries;
+  uint64_t _librariesSignature;
+
+public:
+  SingleStepCache() : _librariesSignature(0) {}
+
+public:
+  inline void clear() { _entries.clear(); }
+
+public:
+  Entry const *find(uint32_t pc, bool thumb) const;
+  void insert(uint32_t pc, bool thumb, Entry const &entry);
+  // Drops the entries decoded from bytes in [address, address + length).
+  void invalidate(uint64_t address, size_t length);
+  // Clears the cache if the signature of the loaded libraries changed since
+  // the last call.
+  void updateLibraries(uint64_t signature);
+};
+} // namespace ARM
+} // namespace Architecture
+} // namespace ds2
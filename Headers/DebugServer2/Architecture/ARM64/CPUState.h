@@ -61,6 +61,8 @@ struct CPUState64 {
   inline uint64_t sp() const { return gp.sp; }
   inline void setSP(uint64_t sp) { gp.sp = sp; }
 
+  inline uint64_t fp() const { return gp.fp; }
+
   inline uint64_t retval() const { return gp.x0; }
 
 public:
@@ -176,6 +178,10 @@ struct CPUState {
       state64.setSP(sp);
   }
 
+  inline uint64_t fp() const {
+    return isA32 ? static_cast<uint64_t>(state32.fp()) : state64.fp();
+  }
+
   inline uint64_t retval() const {
     return isA32 ? static_cast<uint64_t>(state32.retval()) : state64.retval();
   }
@@ -138,6 +138,8 @@ public:
   inline uint32_t sp() const { return gp.esp; }
   inline void setSP(uint32_t sp) { gp.esp = sp; }
 
+  inline uint32_t fp() const { return gp.ebp; }
+
   inline uint32_t retval() const { return gp.eax; }
 
 public:
@@ -134,6 +134,10 @@ struct CPUState64 {
     } eavx;
   };
 
+  struct {
+    uint64_t regs[8];
+  } kmask;
+
   struct {
     uint64_t xfeatures_mask;
   } xsave_header;
@@ -160,6 +164,7 @@ public:
     std::memset(&x87, 0, sizeof(x87));
     std::memset(&xsave_header, 0, sizeof(xsave_header));
     std::memset(&eavx, 0, sizeof(eavx));
+    std::memset(&kmask, 0, sizeof(kmask));
     std::memset(&dr, 0, sizeof(dr));
     std::memset(&xcr0, 0, sizeof(xcr0));
 #if defined(OS_LINUX)
@@ -177,6 +182,8 @@ public:
   inline uint64_t sp() const { return gp.rsp; }
   inline void setSP(uint64_t sp) { gp.rsp = sp; }
 
+  inline uint64_t fp() const { return gp.rbp; }
+
   inline uint64_t retval() const { return gp.rax; }
 
 public:
@@ -458,22 +465,64 @@ public:
       _GETREG2(avx, ymm14, regs[14]);
       _GETREG2(avx, ymm15, regs[15]);
 
-      _GETREG2(sse, xmm0, regs[16]);
-      _GETREG2(sse, xmm1, regs[17]);
-      _GETREG2(sse, xmm2, regs[18]);
-      _GETREG2(sse, xmm3, regs[19]);
-      _GETREG2(sse, xmm4, regs[20]);
-      _GETREG2(sse, xmm5, regs[21]);
-      _GETREG2(sse, xmm6, regs[22]);
-      _GETREG2(sse, xmm7, regs[23]);
-      _GETREG2(sse, xmm8, regs[24]);
-      _GETREG2(sse, xmm9, regs[25]);
-      _GETREG2(sse, xmm10, regs[26]);
-      _GETREG2(sse, xmm11, regs[27]);
-      _GETREG2(sse, xmm12, regs[28]);
-      _GETREG2(sse, xmm13, regs[29]);
-      _GETREG2(sse, xmm14, regs[30]);
-      _GETREG2(sse, xmm15, regs[31]);
+      _GETREG2(sse, xmm0, regs[0]);
+      _GETREG2(sse, xmm1, regs[1]);
+      _GETREG2(sse, xmm2, regs[2]);
+      _GETREG2(sse, xmm3, regs[3]);
+      _GETREG2(sse, xmm4, regs[4]);
+      _GETREG2(sse, xmm5, regs[5]);
+      _GETREG2(sse, xmm6, regs[6]);
+      _GETREG2(sse, xmm7, regs[7]);
+      _GETREG2(sse, xmm8, regs[8]);
+      _GETREG2(sse, xmm9, regs[9]);
+      _GETREG2(sse, xmm10, regs[10]);
+      _GETREG2(sse, xmm11, regs[11]);
+      _GETREG2(sse, xmm12, regs[12]);
+      _GETREG2(sse, xmm13, regs[13]);
+      _GETREG2(sse, xmm14, regs[14]);
+      _GETREG2(sse, xmm15, regs[15]);
+
+      _GETREG2(eavx, zmm0, regs[0]);
+      _GETREG2(eavx, zmm1, regs[1]);
+      _GETREG2(eavx, zmm2, regs[2]);
+      _GETREG2(eavx, zmm3, regs[3]);
+      _GETREG2(eavx, zmm4, regs[4]);
+      _GETREG2(eavx, zmm5, regs[5]);
+      _GETREG2(eavx, zmm6, regs[6]);
+      _GETREG2(eavx, zmm7, regs[7]);
+      _GETREG2(eavx, zmm8, regs[8]);
+      _GETREG2(eavx, zmm9, regs[9]);
+      _GETREG2(eavx, zmm10, regs[10]);
+      _GETREG2(eavx, zmm11, regs[11]);
+      _GETREG2(eavx, zmm12, regs[12]);
+      _GETREG2(eavx, zmm13, regs[13]);
+      _GETREG2(eavx, zmm14, regs[14]);
+      _GETREG2(eavx, zmm15, regs[15]);
+      _GETREG2(eavx, zmm16, regs[16]);
+      _GETREG2(eavx, zmm17, regs[17]);
+      _GETREG2(eavx, zmm18, regs[18]);
+      _GETREG2(eavx, zmm19, regs[19]);
+      _GETREG2(eavx, zmm20, regs[20]);
+      _GETREG2(eavx, zmm21, regs[21]);
+      _GETREG2(eavx, zmm22, regs[22]);
+      _GETREG2(eavx, zmm23, regs[23]);
+      _GETREG2(eavx, zmm24, regs[24]);
+      _GETREG2(eavx, zmm25, regs[25]);
+      _GETREG2(eavx, zmm26, regs[26]);
+      _GETREG2(eavx, zmm27, regs[27]);
+      _GETREG2(eavx, zmm28, regs[28]);
+      _GETREG2(eavx, zmm29, regs[29]);
+      _GETREG2(eavx, zmm30, regs[30]);
+      _GETREG2(eavx, zmm31, regs[31]);
+
+      _GETREG2(kmask, k0, regs[0]);
+      _GETREG2(kmask, k1, regs[1]);
+      _GETREG2(kmask, k2, regs[2]);
+      _GETREG2(kmask, k3, regs[3]);
+      _GETREG2(kmask, k4, regs[4]);
+      _GETREG2(kmask, k5, regs[5]);
+      _GETREG2(kmask, k6, regs[6]);
+      _GETREG2(kmask, k7, regs[7]);
 
     default:
       return false;
@@ -609,10 +658,20 @@ struct CPUState {
       state64.setSP(sp);
   }
 
+  inline uint64_t fp() const {
+    return is32 ? static_cast<uint64_t>(state32.fp()) : state64.fp();
+  }
+
   inline uint64_t retval() const {
     return is32 ? static_cast<uint64_t>(state32.retval()) : state64.retval();
   }
 
+  // xcr0 always has the x87 bit set once the XSAVE area has been read; a
+  // state without it only holds the general purpose and debug registers.
+  inline bool hasExtendedState() const {
+    return (is32 ? state32.xcr0 : state64.xcr0) != 0;
+  }
+
 public:
   inline void getGPState(GPRegisterValueVector &regs) const {
     if (is32) {
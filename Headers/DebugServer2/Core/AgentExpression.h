@@ -0,0 +1,31 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Target/ProcessDecl.h"
+
+namespace ds2 {
+
+//
+// Interpreter for the GDB agent expression bytecode, as sent in the condition
+// list of Z packets. Only the subset needed to evaluate conditions is
+// supported: arithmetic, comparisons, control flow, register and memory
+// references. Tracing opcodes are accepted but collect nothing; floating
+// point, trace state variables and printf are rejected.
+//
+class AgentExpression {
+public:
+  // Evaluates `bytecode` in the context of the stopped `thread`. Register
+  // numbers are GDB register numbers.
+  static ErrorCode Evaluate(ByteVector const &bytecode, Target::Thread *thread,
+                            uint64_t &result);
+};
+} // namespace ds2
@@ -14,6 +14,7 @@
 #include "DebugServer2/Utils/Enums.h"
 
 #include <functional>
+#include <vector>
 
 namespace ds2 {
 
@@ -43,6 +44,9 @@ public:
     Lifetime lifetime;
     Mode mode;
     size_t size;
+    // Agent expression bytecode; the site only triggers if one of them
+    // evaluates to non-zero.
+    std::vector<ByteVector> conditions;
 
   public:
     bool operator==(Site const &other) const {
@@ -77,6 +81,11 @@ public:
 public:
   virtual bool has(Address const &address) const;
 
+public:
+  ErrorCode setConditions(Address const &address,
+                          std::vector<ByteVector> const &conditions);
+  bool hasConditions() const;
+
 public:
   virtual void enumerate(std::function<void(Site const &)> const &cb) const;
 
@@ -100,6 +109,12 @@ public:
   virtual void enable(Target::Thread *thread = nullptr);
   virtual void disable(Target::Thread *thread = nullptr);
 
+public:
+  // Temporarily lift a single site while the manager is enabled, e.g. to let
+  // a thread execute the original instruction.
+  ErrorCode enableSite(Address const &address);
+  ErrorCode disableSite(Address const &address);
+
 protected:
   virtual ErrorCode enableLocation(Site const &site,
                                    Target::Thread *thread = nullptr) = 0;
@@ -54,7 +54,9 @@ protected:
   size_t chooseBreakpointSize() const override;
 
 protected:
-  virtual int getAvailableLocation();
+  virtual int getAvailableLocation(Mode mode);
+  // Range of `_locations` usable by a site of the given mode.
+  void getLocationRange(Mode mode, size_t &begin, size_t &end) const;
 
 protected:
   virtual void
@@ -78,6 +80,21 @@ protected:
                                        int size);
 #endif
 
+#if defined(ARCH_ARM) || defined(ARCH_ARM64)
+protected:
+  // ARM has separate breakpoint and watchpoint slots; `_locations` holds the
+  // watchpoints first, then the breakpoints.
+  size_t _maxWatchpoints;
+  size_t _maxBreakpoints;
+  size_t _maxWatchpointSize;
+
+protected:
+  // Computes the address and control value to program for a site; the
+  // address may differ from the site's when it has to be aligned.
+  ErrorCode getStoppointData(Site const &site, uint64_t &address,
+                             uint32_t &ctrl) const;
+#endif
+
 public:
   virtual bool fillStopInfo(Target::Thread *thread,
                             StopInfo &stopInfo) override;
@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Target/ProcessDecl.h"
+
+#include <map>
+
+namespace ds2 {
+
+//
+// MemoryArena hands out blocks of inferior memory with a given protection.
+// Allocating memory in the inferior means injecting a syscall and running
+// the inferior, so the arena maps large chunks and sub-allocates from them;
+// freed blocks are coalesced with their neighbours and recycled. Chunks are
+// never given back to the inferior, they go away with the process.
+//
+class MemoryArena {
+public:
+  static size_t const kDefaultChunkSize = 256 * 1024;
+  static size_t const kAlignment = 16;
+
+private:
+  Target::ProcessBase *_process;
+  uint32_t _protection;
+  size_t _chunkSize;
+  std::map<uint64_t, size_t> _free;      // address -> size
+  std::map<uint64_t, size_t> _allocated; // address -> size
+
+public:
+  MemoryArena(Target::ProcessBase *process, uint32_t protection,
+              size_t chunkSize = kDefaultChunkSize);
+
+public:
+  ErrorCode allocate(size_t size, uint64_t &address);
+  ErrorCode deallocate(uint64_t address);
+
+public:
+  inline bool owns(uint64_t address) const {
+    return _allocated.find(address) != _allocated.end();
+  }
+
+private:
+  ErrorCode grow(size_t size);
+  void release(uint64_t address, size_t size);
+};
+} // namespace ds2
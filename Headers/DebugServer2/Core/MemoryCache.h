@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Types.h"
+
+#include <map>
+
+namespace ds2 {
+
+//
+// MemoryCache keeps copies of whole pages of inferior memory. It knows
+// nothing about the inferior: its owner fills it, forwards every write to
+// it, and clears it whenever the inferior may have run since the pages were
+// read.
+//
+class MemoryCache {
+public:
+  static size_t const kMaxPages = 256;
+
+private:
+  size_t _pageSize;
+  std::map<uint64_t, ByteVector> _pages;
+
+public:
+  MemoryCache();
+
+public:
+  inline size_t pageSize() const { return _pageSize; }
+  inline bool empty() const { return _pages.empty(); }
+  inline void clear() { _pages.clear(); }
+
+public:
+  // Copies [address, address + length) out of the cache; fails unless every
+  // page of the range is cached.
+  bool read(uint64_t address, void *data, size_t length) const;
+  // Caches the pages fully contained in [address, address + length); address
+  // must be page-aligned.
+  void insert(uint64_t address, void const *data, size_t length);
+  // Applies a write to the cached pages it overlaps.
+  void update(uint64_t address, void const *data, size_t length);
+  // Drops the cached pages overlapping [address, address + length).
+  void invalidate(uint64_t address, size_t length);
+};
+} // namespace ds2
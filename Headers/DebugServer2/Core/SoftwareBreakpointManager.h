@@ -41,6 +41,12 @@ public:
   void enable(Target::Thread *thread = nullptr) override;
   void disable(Target::Thread *thread = nullptr) override;
 
+public:
+  // Takes over the sites of `parent` in a process created by fork(2), and
+  // removes the breakpoint instructions that came with the copy of its
+  // memory.
+  void inherit(SoftwareBreakpointManager const &parent);
+
 protected:
   ErrorCode isValid(Address const &address, size_t size,
                     Mode mode) const override;
@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Types.h"
+
+#include <string>
+
+namespace ds2 {
+namespace GDBRemote {
+
+enum CompressionType {
+  kCompressionTypeNone,
+  kCompressionTypeZlibDeflate,
+  kCompressionTypeLZ4,
+};
+
+//
+// Packet compression as negotiated by LLDB with QEnableCompression. Names
+// follow LLDB's: "zlib-deflate" is a raw deflate stream (no zlib header) and
+// "lz4" is a raw LZ4 block.
+//
+class Compression {
+public:
+  // Packets smaller than this are not worth compressing.
+  static size_t const kDefaultMinSize = 384;
+
+public:
+  // Comma-separated list of the types we support, most preferred first.
+  static std::string SupportedTypes();
+  static CompressionType Parse(std::string const &name);
+
+public:
+  static bool Compress(CompressionType type, std::string const &input,
+                       std::string &output);
+};
+} // namespace GDBRemote
+} // namespace ds2
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "DebugServer2/Core/MemoryArena.h"
 #include "DebugServer2/GDBRemote/DummySessionDelegateImpl.h"
 #include "DebugServer2/GDBRemote/Mixins/FileOperationsMixin.h"
 #include "DebugServer2/Host/ProcessSpawner.h"
@@ -17,26 +18,81 @@
 #include "DebugServer2/Target/Thread.h"
 #include "DebugServer2/Utils/MPL.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
+#include <set>
+#include <thread>
 
 namespace ds2 {
 namespace GDBRemote {
 class DebugSessionImplBase : public DummySessionDelegateImpl {
+public:
+  // The PacketSize we advertise; also used to size O packets.
+  static size_t const kPacketSize = 0x3fff;
+  static size_t const kDefaultExpeditedStackSize = 64;
+  static size_t const kMaxOutputBacklog = 1024 * 1024;
+  static size_t const kMaxExpeditedFrames = 16;
+
 protected:
+  // The process the debugger currently works with, and the other processes
+  // it follows, which were created by fork(2) or vfork(2).
   Target::Process *_process;
+  std::map<ProcessId, Target::Process *> _inferiors;
   std::vector<int> _programmedSignals;
-  std::map<uint64_t, size_t> _allocations;
+  // _M allocations, by process and protection.
+  std::map<std::pair<ProcessId, uint32_t>, std::unique_ptr<MemoryArena>>
+      _arenas;
   std::map<uint64_t, Architecture::CPUState> _savedRegisters;
   Host::ProcessSpawner _spawner;
 
 protected:
   // a struct to help iterate over the thread list for onQueryThreadList
-  mutable IterationState<ThreadId> _threadIterationState;
+  mutable IterationState<ProcessThreadId> _threadIterationState;
+
+protected:
+  // Whether the debugger asked for fork and vfork stops in qSupported.
+  mutable bool _forkEvents;
+  mutable bool _vforkEvents;
+
+protected:
+  // Set when the debugger interrupts a vAttachWait or vAttachOrWait that is
+  // still waiting for its process. The interrupt comes from the session
+  // thread; _attachLock keeps it from reading _process while an attach
+  // assigns it.
+  std::atomic<bool> _attachWaitCancelled;
+  std::mutex _attachLock;
 
 protected:
   std::mutex _resumeSessionLock;
   Session *_resumeSession;
+
+protected:
+  // Inferior output waits in _consoleBuffer until the forwarder thread
+  // sends it, either after a short delay or once a full packet's worth has
+  // accumulated; it is also flushed before each stop reply. Output that
+  // doesn't fit in the backlog is dropped and reported with a marker.
+  std::thread _outputForwarder;
+  std::mutex _consoleLock;
+  std::condition_variable _consoleWakeup;
   std::string _consoleBuffer;
+  size_t _consoleDropped;
+  bool _outputForwarding;
+  size_t _outputRateLimit;
+  double _outputBudget;
+  std::chrono::steady_clock::time_point _outputBudgetUpdate;
+
+protected:
+  std::thread _profiler;
+  std::mutex _profilerLock;
+  std::condition_variable _profilerWakeup;
+  bool _profilerEnabled;
+  uint32_t _profilerInterval;
+  uint32_t _profilerScanType;
+
+protected:
+  size_t _expeditedStackSize;
 
 public:
   DebugSessionImplBase(StringCollection const &args,
@@ -45,6 +101,12 @@ public:
   DebugSessionImplBase();
   ~DebugSessionImplBase() override;
 
+public:
+  // Number of bytes at the stack pointer sent along with stop replies.
+  inline void setExpeditedStackSize(size_t size) { _expeditedStackSize = size; }
+  // Maximum bytes per second of inferior output forwarded; 0 means no limit.
+  inline void setOutputRateLimit(size_t rate) { _outputRateLimit = rate; }
+
 protected:
   size_t getGPRSize() const override;
 
@@ -67,6 +129,7 @@ protected:
                                  ProcessThreadId &ptid) const override;
   ErrorCode onThreadIsAlive(Session &session,
                             ProcessThreadId const &ptid) override;
+  ErrorCode onSetCurrentProcess(Session &session, ProcessId pid) override;
   ErrorCode onQueryAttached(Session &session, ProcessId pid,
                             bool &attachedProcess) const override;
   ErrorCode onQueryProcessInfo(Session &session,
@@ -77,12 +140,25 @@ protected:
                                   StopInfo &stop) const override;
 
   ErrorCode onQueryThreadList(Session &session, ProcessId pid, ThreadId lastTid,
-                              ThreadId &tid) const override;
+                              ProcessThreadId &ptid) const override;
 
   ErrorCode onQueryFileLoadAddress(Session &session,
                                    std::string const &file_path,
                                    Address &address) override;
 
+protected:
+  ErrorCode onEnableAsynchronousProfiling(Session &session,
+                                          ProcessThreadId const &ptid,
+                                          bool enabled, uint32_t interval,
+                                          uint32_t scanType) override;
+  ErrorCode onQueryProfileData(Session &session, ProcessThreadId const &ptid,
+                               uint32_t scanType,
+                               ProfileData &data) const override;
+
+protected:
+  ErrorCode onSaveCore(Session &session, std::string const &pathHint,
+                       std::string &path) override;
+
 protected:
   ErrorCode onQueryRegisterInfo(Session &session, uint32_t regno,
                                 RegisterInfo &info) const override;
@@ -123,6 +199,9 @@ protected:
 protected:
   ErrorCode onReadMemory(Session &session, Address const &address,
                          size_t length, ByteVector &data) override;
+  ErrorCode onReadMemoryRanges(Session &session,
+                               MemoryRange::Collection const &ranges,
+                               std::vector<ByteVector> &data) override;
   ErrorCode onWriteMemory(Session &session, Address const &address,
                           ByteVector const &data, size_t &nwritten) override;
 
@@ -145,6 +224,8 @@ protected:
 protected:
   ErrorCode onAttach(Session &session, ProcessId pid, AttachMode mode,
                      StopInfo &stop) override;
+  ErrorCode onAttach(Session &session, std::string const &name,
+                     AttachMode mode, StopInfo &stop) override;
 
 protected:
   ErrorCode onResume(Session &session,
@@ -155,6 +236,11 @@ protected:
   ErrorCode onDetach(Session &session, ProcessId pid, bool stopped) override;
   ErrorCode onExitServer(Session &session) override;
 
+private:
+  bool stepInRange(Target::Thread *thread, ThreadResumeAction const &action,
+                   std::set<ThreadId> const &resumed,
+                   std::set<ThreadId> const &known);
+
 protected:
   ErrorCode onInsertBreakpoint(Session &session, BreakpointType type,
                                Address const &address, uint32_t size,
@@ -165,11 +251,24 @@ protected:
                                Address const &address, uint32_t kind) override;
 
 protected:
+  Target::Process *findProcess(ProcessId pid) const;
+  void selectProcess(Target::Process *process);
+  void dropArenas(ProcessId pid);
+#if defined(OS_LINUX)
+  ErrorCode attachWhenStarted(Session &session, std::string const &name,
+                              AttachMode mode, StopInfo &stop);
+#endif
   Target::Thread *findThread(ProcessThreadId const &ptid) const;
   ErrorCode queryStopInfo(Session &session, Target::Thread *thread,
                           StopInfo &stop) const;
   ErrorCode queryStopInfo(Session &session, ProcessThreadId const &ptid,
                           StopInfo &stop) const;
+  void expediteStopInfo(Target::Thread *thread,
+                        Architecture::CPUState const &state,
+                        StopInfo &stop) const;
+  ErrorCode readRegisterState(Session &session, Target::Thread *thread,
+                              uint32_t regno,
+                              Architecture::CPUState &state) const;
 
 protected:
   ErrorCode fetchStopInfoForAllThreads(Session &session,
@@ -182,6 +281,12 @@ private:
   ErrorCode spawnProcess(StringCollection const &args,
                          EnvironmentBlock const &env);
   void appendOutput(char const *buf, size_t size);
+  void outputForwarderLoop();
+  void stopOutputForwarder();
+  size_t outputBudget();
+  void sendOutput(Session &session, size_t budget);
+  void profilerLoop();
+  void stopProfiler();
 };
 
 using DebugSessionImpl =
@@ -110,7 +110,7 @@ protected: // Debugging Session
   // the one specified.
   //
   ErrorCode onQueryThreadList(Session &session, ProcessId pid, ThreadId lastTid,
-                              ThreadId &tid) const override;
+                              ProcessThreadId &ptid) const override;
 
   ErrorCode onQueryThreadStopInfo(Session &session, ProcessThreadId const &ptid,
                                   StopInfo &stop) const override;
@@ -119,6 +119,7 @@ protected: // Debugging Session
                                  ProcessThreadId &ptid) const override;
   ErrorCode onThreadIsAlive(Session &session,
                             ProcessThreadId const &ptid) override;
+  ErrorCode onSetCurrentProcess(Session &session, ProcessId pid) override;
   ErrorCode onQueryThreadInfo(Session &session, ProcessThreadId const &ptid,
                               uint32_t mode, void *info) const override;
 
@@ -133,7 +134,11 @@ protected: // Debugging Session
                                           bool enabled, uint32_t interval,
                                           uint32_t scanType) override;
   ErrorCode onQueryProfileData(Session &session, ProcessThreadId const &ptid,
-                               uint32_t scanType, void *data) const override;
+                               uint32_t scanType,
+                               ProfileData &data) const override;
+
+  ErrorCode onSaveCore(Session &session, std::string const &pathHint,
+                       std::string &path) override;
 
   ErrorCode onResume(Session &session,
                      ThreadResumeAction::Collection const &actions,
@@ -159,6 +164,9 @@ protected: // Debugging Session
 
   ErrorCode onReadMemory(Session &session, Address const &address,
                          size_t length, ByteVector &data) override;
+  ErrorCode onReadMemoryRanges(Session &session,
+                               MemoryRange::Collection const &ranges,
+                               std::vector<ByteVector> &data) override;
   ErrorCode onWriteMemory(Session &session, Address const &address,
                           ByteVector const &data, size_t &nwritten) override;
 
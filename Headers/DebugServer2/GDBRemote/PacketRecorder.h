@@ -0,0 +1,47 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Types.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ds2 {
+namespace GDBRemote {
+
+//
+// Records the packets a session receives so that they can be replayed later
+// without a debugger or an inferior. Packets are stored as they are handed
+// to the interpreter (framing and checksum already stripped), one per line,
+// as "<decimal length>:<bytes>\n" so that binary payloads survive.
+//
+class PacketRecorder {
+private:
+  std::FILE *_file;
+
+public:
+  PacketRecorder();
+  ~PacketRecorder();
+
+public:
+  bool open(std::string const &path);
+  void close();
+
+public:
+  void record(std::string const &packet);
+
+public:
+  static bool Load(std::string const &path, std::vector<std::string> &packets);
+};
+} // namespace GDBRemote
+} // namespace ds2
@@ -26,6 +26,11 @@ protected:
 public:
   PlatformSessionImplBase();
 
+public:
+  // Keep `size` debug servers spawned ahead of time so that
+  // qLaunchGDBServer can hand one out without waiting for it to start.
+  static void SetDebugServerPoolSize(size_t size);
+
 protected:
   ErrorCode onQueryProcessList(Session &session, ProcessInfoMatch const &match,
                                bool first, ProcessInfo &info) const override;
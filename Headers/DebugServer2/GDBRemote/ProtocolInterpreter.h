@@ -12,6 +12,9 @@
 
 #include "DebugServer2/GDBRemote/PacketProcessor.h"
 
+#include <chrono>
+#include <functional>
+
 namespace ds2 {
 namespace GDBRemote {
 
@@ -35,10 +38,17 @@ public:
     int compare(std::string const &command) const;
   };
 
+  // Called after each dispatched command with the name of the handler that
+  // processed it (empty for unsupported commands) and the time it took.
+  typedef std::function<void(std::string const &command,
+                             std::chrono::nanoseconds elapsed)>
+      TimingCallback;
+
 private:
   SessionBase *_session;
   Handler::Collection _handlers;
   std::vector<std::string> _lastCommands;
+  TimingCallback _timingCallback;
 
 public:
   ProtocolInterpreter();
@@ -49,9 +59,17 @@ public:
     return const_cast<ProtocolInterpreter *>(this)->_session;
   }
 
+public:
+  inline void setTimingCallback(TimingCallback const &callback) {
+    _timingCallback = callback;
+  }
+
 public:
   void onCommand(std::string const &command, std::string const &arguments);
 
+private:
+  void dispatch(std::string const &command, std::string const &arguments);
+
 public:
   bool registerHandler(Handler const &handler);
 
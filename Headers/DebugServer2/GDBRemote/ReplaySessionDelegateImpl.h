@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/GDBRemote/DummySessionDelegateImpl.h"
+
+namespace ds2 {
+namespace GDBRemote {
+
+//
+// A fake single-threaded, always-stopped inferior for replaying recorded
+// packets. Every answer is derived from the request alone so that replays
+// are reproducible and measure the protocol layer, not the target.
+//
+class ReplaySessionDelegateImpl : public DummySessionDelegateImpl {
+public:
+  static ProcessId const kPid = 4242;
+  static size_t const kGPRCount = 24;
+
+protected:
+  mutable bool _threadListDone;
+
+public:
+  ReplaySessionDelegateImpl();
+
+protected: // General Information
+  size_t getGPRSize() const override;
+
+protected: // Common
+  ErrorCode onQuerySupported(Session &session,
+                             Feature::Collection const &remoteFeatures,
+                             Feature::Collection &localFeatures) const override;
+
+protected: // Debugging Session
+  ErrorCode onQueryThreadList(Session &session, ProcessId pid, ThreadId lastTid,
+                              ProcessThreadId &ptid) const override;
+  ErrorCode onQueryThreadStopInfo(Session &session, ProcessThreadId const &ptid,
+                                  StopInfo &stop) const override;
+  ErrorCode onQueryCurrentThread(Session &session,
+                                 ProcessThreadId &ptid) const override;
+  ErrorCode onThreadIsAlive(Session &session,
+                            ProcessThreadId const &ptid) override;
+
+  ErrorCode onResume(Session &session,
+                     ThreadResumeAction::Collection const &actions,
+                     StopInfo &stop) override;
+
+  ErrorCode
+  onReadGeneralRegisters(Session &session, ProcessThreadId const &ptid,
+                         Architecture::GPRegisterValueVector &regs) override;
+  ErrorCode onWriteGeneralRegisters(Session &session,
+                                    ProcessThreadId const &ptid,
+                                    std::vector<uint64_t> const &regs) override;
+
+  ErrorCode onReadMemory(Session &session, Address const &address,
+                         size_t length, ByteVector &data) override;
+  ErrorCode onReadMemoryRanges(Session &session,
+                               MemoryRange::Collection const &ranges,
+                               std::vector<ByteVector> &data) override;
+  ErrorCode onWriteMemory(Session &session, Address const &address,
+                          ByteVector const &data, size_t &nwritten) override;
+
+private:
+  void fillStopInfo(StopInfo &stop) const;
+};
+} // namespace GDBRemote
+} // namespace ds2
@@ -56,6 +56,8 @@ private:
   void Handle__M(ProtocolInterpreter::Handler const &, std::string const &);
   void Handle__m(ProtocolInterpreter::Handler const &, std::string const &);
   void Handle_M(ProtocolInterpreter::Handler const &, std::string const &);
+  void Handle_MultiMemRead(ProtocolInterpreter::Handler const &,
+                           std::string const &);
   void Handle_m(ProtocolInterpreter::Handler const &, std::string const &);
   void Handle_P(ProtocolInterpreter::Handler const &, std::string const &);
   void Handle_p(ProtocolInterpreter::Handler const &, std::string const &);
@@ -65,6 +67,8 @@ private:
                       std::string const &);
   void Handle_QDisableRandomization(ProtocolInterpreter::Handler const &,
                                     std::string const &);
+  void Handle_QEnableCompression(ProtocolInterpreter::Handler const &,
+                                 std::string const &);
   void Handle_QEnvironment(ProtocolInterpreter::Handler const &,
                            std::string const &);
   void Handle_QEnvironmentHexEncoded(ProtocolInterpreter::Handler const &,
@@ -157,6 +161,8 @@ private:
   void Handle_qRcmd(ProtocolInterpreter::Handler const &, std::string const &);
   void Handle_qRegisterInfo(ProtocolInterpreter::Handler const &,
                             std::string const &);
+  void Handle_qSaveCore(ProtocolInterpreter::Handler const &,
+                        std::string const &);
   void Handle_qSearch(ProtocolInterpreter::Handler const &,
                       std::string const &);
   void Handle_qShlibInfoAddr(ProtocolInterpreter::Handler const &,
@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include "DebugServer2/GDBRemote/Compression.h"
+#include "DebugServer2/GDBRemote/PacketRecorder.h"
 #include "DebugServer2/GDBRemote/PacketProcessor.h"
 #include "DebugServer2/GDBRemote/ProtocolHelpers.h"
 #include "DebugServer2/GDBRemote/ProtocolInterpreter.h"
@@ -32,11 +34,14 @@ private:
   Host::Channel *_channel;
   PacketProcessor _processor;
   ProtocolInterpreter _interpreter;
+  PacketRecorder *_recorder;
 
 protected:
   SessionDelegate *_delegate;
   bool _ackmode;
   CompatibilityMode _compatMode;
+  CompressionType _compressionType;
+  size_t _compressionMinSize;
 
 public:
   SessionBase(CompatibilityMode mode);
@@ -56,6 +61,7 @@ public:
 
 public:
   bool create(Host::Channel *channel);
+  inline void setRecorder(PacketRecorder *recorder) { _recorder = recorder; }
 
 public:
   bool receive(bool cooked);
@@ -69,9 +75,7 @@ public:
   template <typename T> bool send(T const &data, bool escaped = false) {
     std::ostringstream ss;
     static std::string const searchStr = "$#}*";
-    uint8_t csum;
-
-    ss << '$';
+    std::string payload;
 
     //
     // If data contains $, #, } or * we need to escape the
@@ -80,18 +84,17 @@ public:
     if (!escaped &&
         std::find_first_of(data.begin(), data.end(), searchStr.begin(),
                            searchStr.end()) != data.end()) {
-      std::string encoded = Escape(data);
-      ss << encoded;
-      csum = Checksum(encoded);
+      payload = Escape(data);
     } else {
-      for (char c : data) {
-        ss << c;
-      }
-      csum = Checksum(data);
+      payload.assign(data.begin(), data.end());
+    }
+
+    if (_compressionType != kCompressionTypeNone) {
+      payload = compressPayload(payload);
     }
 
-    ss << '#' << std::hex << std::setw(2) << std::setfill('0')
-       << (unsigned)csum;
+    ss << '$' << payload << '#' << std::hex << std::setw(2)
+       << std::setfill('0') << (unsigned)Checksum(payload);
 
     std::string final_data = ss.str();
     DS2LOG(Packet, "putpkt(\"%s\", %u)", final_data.c_str(),
@@ -100,6 +103,11 @@ public:
     return _channel->send(final_data);
   }
 
+public:
+  // Packets sent between cork() and uncork() are written out together.
+  inline void cork() { _channel->cork(); }
+  inline bool uncork() { return _channel->uncork(); }
+
 protected:
   bool sendACK();
   bool sendNAK();
@@ -112,6 +120,15 @@ public:
 protected:
   inline void setAckMode(bool enabled) { _ackmode = enabled; }
 
+protected:
+  inline void setCompression(CompressionType type, size_t minSize) {
+    _compressionType = type;
+    _compressionMinSize = minSize;
+  }
+
+private:
+  std::string compressPayload(std::string const &payload);
+
 public:
   inline ProtocolInterpreter &interpreter() const {
     return const_cast<SessionBase *>(this)->_interpreter;
@@ -120,12 +120,15 @@ protected: // Debugging Session
   //
   virtual ErrorCode onQueryThreadList(Session &session, ProcessId pid,
                                       ThreadId lastTid,
-                                      ThreadId &tid) const = 0;
+                                      ProcessThreadId &ptid) const = 0;
 
   virtual ErrorCode onQueryCurrentThread(Session &session,
                                          ProcessThreadId &ptid) const = 0;
   virtual ErrorCode onThreadIsAlive(Session &session,
                                     ProcessThreadId const &ptid) = 0;
+  // Makes `pid` the process that memory and register operations apply to,
+  // in multiprocess mode.
+  virtual ErrorCode onSetCurrentProcess(Session &session, ProcessId pid) = 0;
   virtual ErrorCode onQueryThreadInfo(Session &session,
                                       ProcessThreadId const &ptid,
                                       uint32_t mode, void *info) const = 0;
@@ -146,7 +149,11 @@ protected: // Debugging Session
                                                   uint32_t scanType) = 0;
   virtual ErrorCode onQueryProfileData(Session &session,
                                        ProcessThreadId const &ptid,
-                                       uint32_t scanType, void *data) const = 0;
+                                       uint32_t scanType,
+                                       ProfileData &data) const = 0;
+
+  virtual ErrorCode onSaveCore(Session &session, std::string const &pathHint,
+                               std::string &path) = 0;
 
   virtual ErrorCode onResume(Session &session,
                              ThreadResumeAction::Collection const &actions,
@@ -176,6 +183,9 @@ protected: // Debugging Session
 
   virtual ErrorCode onReadMemory(Session &session, Address const &address,
                                  size_t length, ByteVector &data) = 0;
+  virtual ErrorCode onReadMemoryRanges(Session &session,
+                                       MemoryRange::Collection const &ranges,
+                                       std::vector<ByteVector> &data) = 0;
   virtual ErrorCode onWriteMemory(Session &session, Address const &address,
                                   ByteVector const &data, size_t &nwritten) = 0;
 
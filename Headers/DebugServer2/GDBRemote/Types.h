@@ -15,6 +15,7 @@
 #include "DebugServer2/Types.h"
 #include "JSObjects/JSObjects.h"
 
+#include <map>
 #include <set>
 
 namespace ds2 {
@@ -48,6 +49,12 @@ public:
   Architecture::GPRegisterStopMap registers;
   std::set<ThreadId> threads;
 
+  // Expedited data that saves the debugger a few round trips after a stop:
+  // the PC of every thread in `threads`, and chunks of memory around the
+  // stack and frame pointers of the stopped thread.
+  std::map<ThreadId, uint64_t> threadPCs;
+  std::map<uint64_t, ByteVector> memory;
+
 public:
   std::string encode(CompatibilityMode mode, bool listThreads) const;
   std::string encodeWithAllThreads(CompatibilityMode mode,
@@ -70,6 +77,8 @@ public:
     threadName.clear();
     registers.clear();
     threads.clear();
+    threadPCs.clear();
+    memory.clear();
     ds2::StopInfo::clear();
   }
 };
@@ -81,6 +90,7 @@ enum ResumeAction {
   kResumeActionSingleStepWithSignal,
   kResumeActionSingleStepCycle,
   kResumeActionSingleStepCycleWithSignal,
+  kResumeActionRangeStep,
   kResumeActionContinue,
   kResumeActionContinueWithSignal,
   kResumeActionBackwardStep,
@@ -96,6 +106,9 @@ struct ThreadResumeAction {
   Address address;
   int signal;
   uint32_t ncycles;
+  // For range stepping, keep stepping while the PC is in [start, end).
+  Address rangeStart;
+  Address rangeEnd;
 
   ThreadResumeAction() : action(kResumeActionInvalid), signal(0), ncycles(0) {}
 };
@@ -213,6 +226,24 @@ struct ProgramResult {
   std::string encode() const;
 };
 
+struct ProfileData : public ds2::ProfileData {
+  // Bits of the scan_type argument of qGetProfileData and
+  // QSetEnableAsyncProfiling.
+  enum {
+    kScanHostCPU = (1 << 0),
+    kScanCPU = (1 << 1),
+    kScanThreadsCPU = (1 << 2),
+    kScanThreadName = (1 << 3),
+    kScanQueueName = (1 << 4),
+    kScanHostMemory = (1 << 5),
+    kScanMemory = (1 << 6),
+    kScanAll = 0xffffffff,
+  };
+
+  ProfileData() : ds2::ProfileData() {}
+  std::string encode(uint32_t scanType) const;
+};
+
 template <class T> struct IterationState {
   std::vector<T> vals;
   typename std::vector<T>::iterator it;
@@ -35,6 +35,13 @@ public:
 public:
   virtual bool send(std::string const &buffer);
   virtual bool receive(std::string &buffer);
+
+public:
+  // While corked, sent data is held back so that bursts of small messages
+  // go out together when the last uncork() is called. Calls nest; channels
+  // that don't buffer ignore them.
+  virtual void cork();
+  virtual bool uncork();
 };
 } // namespace Host
 } // namespace ds2
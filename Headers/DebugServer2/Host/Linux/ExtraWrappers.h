@@ -145,6 +145,18 @@ static inline int personality(unsigned long persona) {
 #define PTRACE_SETREGSET 0x4205
 #endif // !PTRACE_SETREGSET
 
+#if !defined(PTRACE_SEIZE)
+#define PTRACE_SEIZE 0x4206
+#endif // !PTRACE_SEIZE
+
+#if !defined(PTRACE_INTERRUPT)
+#define PTRACE_INTERRUPT 0x4207
+#endif // !PTRACE_INTERRUPT
+
+#if !defined(PTRACE_EVENT_STOP)
+#define PTRACE_EVENT_STOP 128
+#endif // !PTRACE_EVENT_STOP
+
 // As defined in <asm-generic/siginfo.h>, missing in glibc
 #if !defined(TRAP_BRKPT)
 #define TRAP_BRKPT 1
@@ -28,6 +28,15 @@ public:
   ErrorCode traceMe(bool disableASLR) override;
   ErrorCode traceThat(ProcessId pid) override;
 
+public:
+  // Attaches with PTRACE_SEIZE, which sets the trace options at the same
+  // time, and stops the thread with PTRACE_INTERRUPT. The thread reports a
+  // PTRACE_EVENT_STOP instead of a SIGSTOP.
+  ErrorCode attach(ProcessId pid) override;
+  // Stops a seized thread at its next opportunity with a PTRACE_EVENT_STOP.
+  // Any other ptrace-stop it reports first also satisfies the request.
+  ErrorCode interrupt(ProcessThreadId const &ptid);
+
 public:
   ErrorCode kill(ProcessThreadId const &ptid, int signal) override;
 
@@ -52,6 +61,11 @@ public:
                          Architecture::CPUState &state) override;
   ErrorCode writeCPUState(ProcessThreadId const &ptid, ProcessInfo const &pinfo,
                           Architecture::CPUState const &state) override;
+  // Same as above, but only writes the register sets that differ from
+  // `previous`, which must be the state the thread currently has.
+  ErrorCode writeCPUState(ProcessThreadId const &ptid, ProcessInfo const &pinfo,
+                          Architecture::CPUState const &state,
+                          Architecture::CPUState const &previous);
 
 private:
   ErrorCode prepareAddressForResume(ProcessThreadId const &ptid,
@@ -67,6 +81,10 @@ public:
 public:
   ErrorCode getSigInfo(ProcessThreadId const &ptid, siginfo_t &si) override;
   ErrorCode getEventMessage(ProcessThreadId const &ptid, unsigned long &data);
+  // Reads a register set in the layout the kernel uses in core files. data
+  // must be large enough for it and is shrunk to the size that was returned.
+  ErrorCode readRegisterSetData(ProcessThreadId const &ptid, int regSetCode,
+                                ByteVector &data);
 
 protected:
   virtual ErrorCode readRegisterSet(ProcessThreadId const &ptid, int regSetCode,
@@ -75,6 +93,23 @@ protected:
                                      int regSetCode, void const *buffer,
                                      size_t length);
 
+#if defined(ARCH_X86_64)
+public:
+  // readCPUState is readBaseCPUState followed by readExtendedCPUState. The
+  // base state is the general purpose and debug registers, the extended
+  // state is everything that lives in the XSAVE area.
+  ErrorCode readBaseCPUState(ProcessThreadId const &ptid,
+                             ProcessInfo const &pinfo,
+                             Architecture::CPUState &state);
+  ErrorCode readExtendedCPUState(ProcessThreadId const &ptid,
+                                 ProcessInfo const &pinfo,
+                                 Architecture::CPUState &state);
+
+protected:
+  ErrorCode readXSaveArea(pid_t pid, ByteVector &area, size_t &length);
+  ErrorCode writeXSaveArea(pid_t pid, Architecture::CPUState const &state);
+#endif
+
 #if defined(ARCH_X86) || defined(ARCH_X86_64)
 protected:
   uintptr_t readUserData(ProcessThreadId const &ptid, uint64_t offset);
@@ -87,29 +122,29 @@ protected:
 public:
   int getMaxHardwareBreakpoints(ProcessThreadId const &ptid) override;
   int getMaxHardwareWatchpoints(ProcessThreadId const &ptid) override;
+  int getMaxWatchpointSize(ProcessThreadId const &ptid) override;
+
+public:
+  ErrorCode writeHardwareBreakpoint(ProcessThreadId const &ptid, uint64_t addr,
+                                    uint32_t ctrl, size_t idx) override;
+  ErrorCode writeHardwareWatchpoint(ProcessThreadId const &ptid, uint64_t addr,
+                                    uint32_t ctrl, size_t idx) override;
 #endif
 
 #if defined(ARCH_ARM)
 protected:
   uint32_t getStoppointData(ProcessThreadId const &ptid);
 
-public:
-  int getMaxWatchpointSize(ProcessThreadId const &ptid) override;
-
 protected:
-  ErrorCode writeStoppoint(ProcessThreadId const &ptid, size_t idx,
+  ErrorCode writeStoppoint(ProcessThreadId const &ptid, int idx,
                            uint32_t *val);
-
-public:
-  ErrorCode writeHardwareBreakpoint(ProcessThreadId const &ptid, uint32_t addr,
-                                    uint32_t ctrl, size_t idx) override;
-  ErrorCode writeHardwareWatchpoint(ProcessThreadId const &ptid, uint32_t addr,
-                                    uint32_t ctrl, size_t idx) override;
 #endif
 
 #if defined(ARCH_ARM64)
 protected:
   int getMaxStoppoints(ProcessThreadId const &ptid, int regSet);
+  ErrorCode writeStoppoint(ProcessThreadId const &ptid, int regSet,
+                           uint64_t addr, uint32_t ctrl, size_t idx);
 #endif
 };
 } // namespace Linux
@@ -18,6 +18,7 @@
 #include <functional>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <vector>
 
 namespace ds2 {
 namespace Host {
@@ -92,6 +93,17 @@ public:
     uint64_t start_brk;
   };
 
+  // All sizes are in pages.
+  struct Statm {
+    uint64_t size;
+    uint64_t resident;
+    uint64_t shared;
+    uint64_t text;
+    uint64_t lib;
+    uint64_t data;
+    uint64_t dt;
+  };
+
 public:
   static int OpenFd(const char *what, int mode = O_RDONLY);
   static int OpenFd(pid_t pid, const char *what, int mode = O_RDONLY);
@@ -124,6 +136,8 @@ public:
   static bool ReadStat(pid_t pid, pid_t tid, Stat &stat);
   static bool ReadProcessIds(pid_t pid, pid_t &ppid, uid_t &uid, uid_t &euid,
                              gid_t &gid, gid_t &egid);
+  static bool ReadStatm(pid_t pid, Statm &statm);
+  static bool ReadThreadCPUTime(pid_t pid, pid_t tid, uint64_t &usec);
 
 public:
   struct ELFInfo {
@@ -152,6 +166,15 @@ public:
   static bool EnumerateProcesses(bool allUsers, uid_t uid,
                                  std::function<void(pid_t, uid_t)> const &cb);
   static bool EnumerateThreads(pid_t pid, std::function<void(pid_t)> const &cb);
+  // Calls cb for each mapping of /proc/<pid>/maps, in ascending order, and
+  // anonymous ones included.
+  static bool EnumerateMemoryRegions(
+      pid_t pid, std::function<void(MemoryRegionInfo const &)> const &cb);
+  // Same as EnumerateThreads, but reads the whole task directory at once
+  // with getdents(2) and returns the thread IDs in ascending order.
+  static bool ReadThreadIds(pid_t pid, std::vector<pid_t> &tids);
+  // Returns the IDs of all the processes in /proc, in ascending order.
+  static bool ReadProcessList(std::vector<pid_t> &pids);
 };
 } // namespace Linux
 } // namespace Host
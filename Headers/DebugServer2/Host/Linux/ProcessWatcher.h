@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Types.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ds2 {
+namespace Host {
+namespace Linux {
+
+//
+// ProcessWatcher looks for a process running the executable with a given
+// name (or path), either among the existing processes or among the ones that
+// will be started later, for vAttachWait and vAttachOrWait.
+//
+// New programs are noticed through the exec events of the netlink process
+// connector when the kernel delivers them to us (this needs CAP_NET_ADMIN in
+// the initial namespaces), so that the caller can stop the process right
+// after execve(2) returns. Otherwise /proc is polled, and only the processes
+// that weren't there on the previous pass are looked at, along with the ones
+// that appeared recently and may not have called execve(2) yet.
+//
+class ProcessWatcher {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+public:
+  // How long a new process is checked again after it first shows up.
+  static std::chrono::milliseconds const kExecGracePeriod;
+  static std::chrono::microseconds const kScanInterval;
+
+private:
+  std::string _name;
+  int _fd;
+  // The processes seen on the last pass over /proc, ordered by pid, along
+  // with the time they were first seen.
+  std::vector<std::pair<pid_t, Clock::time_point>> _known;
+
+public:
+  ProcessWatcher(std::string const &name);
+  ~ProcessWatcher();
+
+public:
+  // Starts watching. If existing is true, a process that is already running
+  // the program is returned in pid; otherwise pid is kAnyProcessId.
+  ErrorCode start(bool existing, ProcessId &pid);
+  // Waits until a new process runs the program. Returns kErrorInterrupted
+  // once cancel is set.
+  ErrorCode wait(std::atomic<bool> const &cancel, ProcessId &pid);
+
+public:
+  // Whether the exec events of the process connector are being used.
+  inline bool usesConnector() const { return _fd >= 0; }
+
+private:
+  bool matches(pid_t pid) const;
+  bool openConnector();
+  bool readConnector(ProcessId &pid);
+  bool scan(bool match, ProcessId &pid);
+};
+} // namespace Linux
+} // namespace Host
+} // namespace ds2
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Host/Socket.h"
+#include "DebugServer2/Types.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ds2 {
+namespace Host {
+namespace Linux {
+
+//
+// SocketServer multiplexes any number of client connections accepted on a
+// listening socket over a single epoll(7) instance. The acceptor thread only
+// waits for readiness; data is processed by a fixed-size pool of workers.
+//
+// Each connection is registered with EPOLLONESHOT, which guarantees that a
+// connection is owned by at most one worker at a time and that the data of
+// a given client is always processed in order.
+//
+class SocketServer {
+public:
+  // A ConnectionHandler holds the per-client protocol state (e.g. a GDB
+  // remote session) and is fed the data received on its socket.
+  class ConnectionHandler {
+  public:
+    virtual ~ConnectionHandler() = default;
+
+  public:
+    // Returns false if the connection should be closed.
+    virtual bool onData(std::string const &data) = 0;
+  };
+
+  typedef std::function<std::unique_ptr<ConnectionHandler>(Socket *)>
+      HandlerFactory;
+
+public:
+  static size_t const kDefaultMaxConnections = 256;
+
+private:
+  enum class ConnectionState { Idle, Processing, Closing };
+
+  struct Connection {
+    std::unique_ptr<Socket> socket;
+    std::unique_ptr<ConnectionHandler> handler;
+    ConnectionState state;
+    uint32_t events;
+  };
+
+private:
+  std::unique_ptr<Socket> _listener;
+  HandlerFactory _factory;
+  size_t _maxConnections;
+  size_t _workerCount;
+  int _epollFd;
+  bool _accepting;
+  bool _stopping;
+
+  std::mutex _lock;
+  std::condition_variable _ready;
+  std::map<Connection *, std::unique_ptr<Connection>> _connections;
+  std::deque<Connection *> _queue;
+  std::vector<std::thread> _workers;
+
+public:
+  SocketServer(std::unique_ptr<Socket> listener, HandlerFactory const &factory,
+               size_t maxConnections = kDefaultMaxConnections,
+               size_t workerCount = 0);
+  ~SocketServer();
+
+public:
+  // Runs the acceptor loop. Only returns on error.
+  ErrorCode run();
+
+private:
+  void acceptConnections();
+  void dispatch(Connection *connection, uint32_t events);
+  void workerLoop();
+  void process(Connection *connection);
+  bool arm(int fd, Connection *connection, uint32_t events, bool add);
+};
+} // namespace Linux
+} // namespace Host
+} // namespace ds2
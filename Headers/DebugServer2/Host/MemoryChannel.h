@@ -0,0 +1,62 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#pragma once
+
+#include "DebugServer2/Host/Channel.h"
+#include "DebugServer2/Types.h"
+
+#include <deque>
+#include <string>
+
+namespace ds2 {
+namespace Host {
+
+//
+// MemoryChannel is a channel with no peer: messages pushed into it are
+// handed out one at a time by receive(), and whatever is sent is counted and
+// dropped, except for the last message which is kept for inspection. It is
+// meant for driving a session without a socket, e.g. when replaying packets.
+//
+class MemoryChannel : public Channel {
+protected:
+  std::deque<std::string> _input;
+  std::string _lastSent;
+  uint64_t _sentBytes;
+  uint64_t _sentMessages;
+  bool _closed;
+
+public:
+  MemoryChannel();
+
+public:
+  inline void push(std::string const &message) { _input.push_back(message); }
+  inline std::string const &lastSent() const { return _lastSent; }
+  inline uint64_t sentBytes() const { return _sentBytes; }
+  inline uint64_t sentMessages() const { return _sentMessages; }
+
+public:
+  void close() override;
+
+public:
+  bool connected() const override;
+
+public:
+  bool wait(int ms = -1) override;
+
+public:
+  ssize_t send(void const *buffer, size_t length) override;
+  ssize_t receive(void *buffer, size_t length) override;
+
+public:
+  bool receive(std::string &buffer) override;
+};
+} // namespace Host
+} // namespace ds2
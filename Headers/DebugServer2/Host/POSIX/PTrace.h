@@ -89,18 +89,14 @@ public:
 public:
   virtual int getMaxHardwareBreakpoints(ProcessThreadId const &ptid) = 0;
   virtual int getMaxHardwareWatchpoints(ProcessThreadId const &ptid) = 0;
-#endif
-
-#if defined(ARCH_ARM)
-public:
   virtual int getMaxWatchpointSize(ProcessThreadId const &ptid) = 0;
 
 public:
   virtual ErrorCode writeHardwareBreakpoint(ProcessThreadId const &ptid,
-                                            uint32_t addr, uint32_t ctrl,
+                                            uint64_t addr, uint32_t ctrl,
                                             size_t idx) = 0;
   virtual ErrorCode writeHardwareWatchpoint(ProcessThreadId const &ptid,
-                                            uint32_t addr, uint32_t ctrl,
+                                            uint64_t addr, uint32_t ctrl,
                                             size_t idx) = 0;
 #endif // ARCH
 #endif // OS_LINUX
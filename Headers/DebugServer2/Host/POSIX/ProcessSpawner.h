@@ -14,6 +14,7 @@
 
 #include <functional>
 #include <thread>
+#include <vector>
 
 namespace ds2 {
 namespace Host {
@@ -48,6 +49,9 @@ protected:
   EnvironmentBlock _environment;
   std::string _workingDirectory;
   std::thread _delegateThread;
+  // Used to tell the redirection thread to stop: an eventfd on Linux (both
+  // entries are then the same descriptor), a pipe elsewhere.
+  int _wakeupFds[2];
   RedirectDescriptor _descriptors[3];
   std::string _outputBuffer;
   int _exitStatus;
@@ -119,6 +123,8 @@ public:
 
 private:
   void redirectionThread();
+  size_t forwardOutput(RedirectDescriptor &descriptor, std::vector<char> &buf);
+  void stopRedirectionThread();
 };
 } // namespace Host
 } // namespace ds2
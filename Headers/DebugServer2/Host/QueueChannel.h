@@ -51,6 +51,10 @@ public:
 
 public:
   bool receive(std::string &buffer) override;
+
+public:
+  void cork() override;
+  bool uncork() override;
 };
 } // namespace Host
 } // namespace ds2
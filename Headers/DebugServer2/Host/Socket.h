@@ -12,7 +12,10 @@
 
 #include "DebugServer2/Host/Channel.h"
 
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
 #if defined(OS_WIN32)
 #include <winsock2.h>
 #elif defined(OS_POSIX)
@@ -31,6 +34,11 @@ private:
   static SOCKET const INVALID_SOCKET = -1;
 #endif
 
+public:
+  // Platform servers can get hit by hundreds of clients at once; don't
+  // refuse connections just because we didn't get to accept() them yet.
+  static int const kDefaultBacklog = SOMAXCONN;
+
 protected:
   enum class State { Invalid, Listening, Connected };
 
@@ -39,6 +47,15 @@ protected:
   State _state;
   int _lastError;
 
+protected:
+  // Data accepted by send() but not written yet, oldest first; the first
+  // _outboundOffset bytes of the front buffer have already been written.
+  // Sends can come from the session thread and from the main thread.
+  std::mutex _sendMutex;
+  std::deque<std::string> _outbound;
+  size_t _outboundOffset;
+  unsigned _corkDepth;
+
 public:
   Socket();
   Socket(SOCKET handle);
@@ -47,8 +64,13 @@ public:
 public:
   void close() override;
 
+protected:
+  // Same as close(), for callers that already hold _sendMutex.
+  void closeHandle();
+
 public:
   inline bool valid() const { return (_handle != INVALID_SOCKET); }
+  inline SOCKET handle() const { return _handle; }
 
 public:
   inline bool listening() const { return (_state == State::Listening); }
@@ -60,9 +82,11 @@ protected:
   bool create(int af);
 
 public:
-  bool listen(std::string const &address, std::string const &port);
+  bool listen(std::string const &address, std::string const &port,
+              int backlog = kDefaultBacklog);
 #if defined(OS_POSIX)
-  bool listen(std::string const &path, bool abstract = false);
+  bool listen(std::string const &path, bool abstract = false,
+              int backlog = kDefaultBacklog);
 #endif
   std::unique_ptr<Socket> accept();
   bool connect(std::string const &host, std::string const &port);
@@ -82,10 +106,22 @@ public:
 
 public:
   bool setNonBlocking();
+  // We batch small writes ourselves, so Nagle's algorithm only adds latency.
+  // Only valid on TCP sockets.
+  bool setNoDelay(bool enable);
 
 public:
   ssize_t send(void const *buffer, size_t length) override;
   ssize_t receive(void *buffer, size_t length) override;
+
+public:
+  void cork() override;
+  bool uncork() override;
+
+protected:
+  bool flushOutbound();
+  ssize_t writeOutbound();
+  bool waitWritable();
 };
 } // namespace Host
 } // namespace ds2
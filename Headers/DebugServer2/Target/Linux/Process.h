@@ -10,9 +10,12 @@
 
 #pragma once
 
+#include "DebugServer2/Core/MemoryCache.h"
 #include "DebugServer2/Host/Linux/PTrace.h"
 #include "DebugServer2/Target/POSIX/ELFProcess.h"
 
+#include <map>
+
 namespace ds2 {
 namespace Target {
 namespace Linux {
@@ -21,8 +24,45 @@ class Process : public POSIX::ELFProcess {
 protected:
   Host::Linux::PTrace _ptrace;
 
+protected:
+  // Pages read since the last stop; cleared whenever threads may have run.
+  MemoryCache _memoryCache;
+  Address _stackHint;
+
+protected:
+  // Whether the debugger wants to see fork(2) and vfork(2) events; the
+  // children of those it doesn't want are detached.
+  bool _followForks;
+  bool _followVForks;
+  // Children of vfork(2) still running in our address space.
+  unsigned int _pendingVForks;
+  // Initial stops of children that were collected before the fork event of
+  // their parent.
+  std::map<ProcessId, int> _childStops;
+
+public:
+  Process();
+
 protected:
   ErrorCode attach(int waitStatus) override;
+  ErrorCode attachThreads();
+  ErrorCode waitAttachStop(pid_t tid, int &status, int &signal);
+
+public:
+  inline void setForkEvents(bool fork, bool vfork) {
+    _followForks = fork;
+    _followVForks = vfork;
+  }
+
+  // Creates the process object of a child created by fork(2) or vfork(2),
+  // which is traced automatically. The breakpoints it inherited from
+  // `parent` are removed from its memory.
+  static ds2::Target::Process *Adopt(ProcessId pid, Process *parent);
+
+protected:
+  bool stashChildStop(pid_t tid, int status);
+  void detachChild(ProcessId pid);
+  bool handleForkEvent(Thread *thread);
 
 public:
   ErrorCode terminate() override;
@@ -32,14 +72,32 @@ public:
   ErrorCode getMemoryRegionInfo(Address const &address,
                                 MemoryRegionInfo &info) override;
 
+public:
+  ErrorCode getProfileData(ProfileData &data) override;
+
+public:
+  ErrorCode saveCore(std::string const &pathHint, std::string &path) override;
+
+protected:
+  ErrorCode writeCore(int fd);
+
 protected:
   ErrorCode executeCode(ByteVector const &codestr, uint64_t &result);
 
+public:
+  void prepareForDetach() override;
+
 public:
   ErrorCode readMemory(Address const &address, void *data, size_t length,
                        size_t *count = nullptr) override;
   ErrorCode writeMemory(Address const &address, void const *data, size_t length,
                         size_t *count = nullptr) override;
+  ErrorCode readMemoryRanges(MemoryRange::Collection const &ranges,
+                             std::vector<ByteVector> &buffers) override;
+
+protected:
+  bool fillMemoryCache(uint64_t address, size_t length);
+  void flushMemoryCache();
 
 public:
   ErrorCode allocateMemory(size_t size, uint32_t protection,
@@ -50,8 +108,18 @@ protected:
   ErrorCode checkMemoryErrorCode(uint64_t address);
 
 public:
+  ErrorCode suspend() override;
   ErrorCode wait() override;
 
+public:
+  ErrorCode beforeResume() override;
+  ErrorCode afterResume() override;
+
+protected:
+  bool breakpointConditionFailed(Thread *thread, Address &address);
+  ErrorCode stepOverBreakpoint(Thread *thread, Address const &address,
+                               Thread *&reported);
+
 public:
   Host::Linux::PTrace &ptrace() const override;
 
@@ -66,7 +134,7 @@ protected:
   ErrorCode writeCPUState(ThreadId tid, Architecture::CPUState const &state,
                           uint32_t flags = 0);
 
-#if defined(ARCH_ARM)
+#if defined(ARCH_ARM) || defined(ARCH_ARM64)
 public:
   int getMaxBreakpoints() const override;
   int getMaxWatchpoints() const override;
@@ -19,10 +19,39 @@ namespace Target {
 namespace Linux {
 
 class Thread : public ds2::Target::POSIX::Thread {
+protected:
+  // Registers are cached while the thread is stopped. Writes only go to
+  // _cpuState and are flushed right before the thread runs again;
+  // _kernelCPUState is what the kernel currently has, so that only the
+  // register sets that actually changed get written back.
+  Architecture::CPUState _cpuState;
+  Architecture::CPUState _kernelCPUState;
+  bool _cpuStateValid;
+  bool _cpuStateDirty;
+#if defined(ARCH_X86_64)
+  // The XSAVE area is only read when someone asks for more than the base
+  // state (see readBaseCPUState).
+  bool _extendedCPUStateValid;
+#endif
+
 protected:
   friend class Process;
   Thread(Process *process, ThreadId tid);
 
+public:
+  ErrorCode readCPUState(Architecture::CPUState &state) override;
+  ErrorCode writeCPUState(Architecture::CPUState const &state) override;
+  ErrorCode readBaseCPUState(Architecture::CPUState &state) override;
+
+public:
+  ErrorCode step(int signal = 0, Address const &address = Address()) override;
+  ErrorCode resume(int signal = 0, Address const &address = Address()) override;
+
+protected:
+  ErrorCode fetchCPUState(bool extended);
+  ErrorCode flushCPUState();
+  inline void invalidateCPUState() { _cpuStateValid = _cpuStateDirty = false; }
+
 protected:
   ErrorCode updateStopInfo(int waitStatus) override;
   void updateState() override;
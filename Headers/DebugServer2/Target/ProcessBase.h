@@ -14,6 +14,9 @@
 #include "DebugServer2/Core/SoftwareBreakpointManager.h"
 #include "DebugServer2/Target/ProcessDecl.h"
 #include "DebugServer2/Target/ThreadBase.h"
+#if defined(ARCH_ARM) || defined(ARCH_ARM64)
+#include "DebugServer2/Architecture/ARM/SingleStepCache.h"
+#endif
 
 #include <functional>
 #include <memory>
@@ -38,6 +41,9 @@ protected:
   Thread *_currentThread;
   mutable std::unique_ptr<SoftwareBreakpointManager> _softwareBreakpointManager;
   mutable std::unique_ptr<HardwareBreakpointManager> _hardwareBreakpointManager;
+#if defined(ARCH_ARM) || defined(ARCH_ARM64)
+  Architecture::ARM::SingleStepCache _singleStepCache;
+#endif
 
 protected:
   ProcessBase();
@@ -107,6 +113,10 @@ public:
 public:
   ErrorCode readMemoryBuffer(Address const &address, size_t length,
                              ByteVector &buffer);
+  // Each buffer receives as many bytes of its range as could be read, which
+  // may be none; failing to read a range is not an error.
+  virtual ErrorCode readMemoryRanges(MemoryRange::Collection const &ranges,
+                                     std::vector<ByteVector> &buffers);
   ErrorCode writeMemoryBuffer(Address const &address, ByteVector const &buffer,
                               size_t *nwritten = nullptr);
   ErrorCode writeMemoryBuffer(Address const &address, ByteVector const &buffer,
@@ -127,6 +137,17 @@ public:
 public:
   virtual void getThreadIds(std::vector<ThreadId> &tids);
 
+public:
+  // Must be safe to call while the process is running, from a thread other
+  // than the one that waits on the process.
+  virtual ErrorCode getProfileData(ProfileData &data);
+
+public:
+  // Writes an ELF core file of the stopped process on the host. It is
+  // created at pathHint if possible, in the temporary directory otherwise;
+  // path is set to the file that was written.
+  virtual ErrorCode saveCore(std::string const &pathHint, std::string &path);
+
 protected:
   virtual ErrorCode updateInfo() = 0;
 
@@ -134,6 +155,13 @@ public:
   virtual SoftwareBreakpointManager *softwareBreakpointManager() const final;
   virtual HardwareBreakpointManager *hardwareBreakpointManager() const final;
 
+#if defined(ARCH_ARM) || defined(ARCH_ARM64)
+public:
+  inline Architecture::ARM::SingleStepCache &singleStepCache() {
+    return _singleStepCache;
+  }
+#endif
+
 public:
   virtual void prepareForDetach();
   virtual ErrorCode beforeResume();
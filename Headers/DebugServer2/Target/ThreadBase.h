@@ -61,6 +61,11 @@ public:
 public:
   virtual ErrorCode readCPUState(Architecture::CPUState &state) = 0;
   virtual ErrorCode writeCPUState(Architecture::CPUState const &state) = 0;
+  // Like readCPUState, but only the general purpose and debug registers are
+  // guaranteed to be there; targets that fetch the other register sets lazily
+  // skip them. The state can be written back as long as nothing read the full
+  // state in between, in which case only those registers are written.
+  virtual ErrorCode readBaseCPUState(Architecture::CPUState &state);
   virtual ErrorCode modifyRegisters(
       std::function<void(Architecture::CPUState &state)> action) final;
 
@@ -146,6 +146,9 @@ struct StopInfo {
     kReasonThreadSpawn,
     kReasonThreadEntry,
     kReasonThreadExit,
+    kReasonFork,
+    kReasonVFork,
+    kReasonVForkDone,
 #if defined(OS_WIN32)
     kReasonMemoryError,
     kReasonMemoryAlignment,
@@ -171,6 +174,9 @@ struct StopInfo {
   Address watchpointAddress;
   int watchpointIndex;
 
+  // Process created by fork(2) or vfork(2), for kReasonFork and kReasonVFork.
+  ProcessId childPid;
+
   StopInfo() { clear(); }
 
   inline void clear() {
@@ -184,6 +190,7 @@ struct StopInfo {
     core = -1;
     watchpointAddress = 0;
     watchpointIndex = -1;
+    childPid = kAnyProcessId;
   }
 };
 
@@ -359,4 +366,51 @@ struct MappedFileInfo {
   uint64_t baseAddress;
   uint64_t size;
 };
+
+//
+// A range of memory, part of a batched read
+//
+struct MemoryRange {
+  typedef std::vector<MemoryRange> Collection;
+
+  Address start;
+  size_t length;
+
+  MemoryRange() : length(0) {}
+  MemoryRange(Address const &start_, size_t length_)
+      : start(start_), length(length_) {}
+};
+
+//
+// Resource usage of a running process
+//
+struct ProfileData {
+  struct ThreadUsage {
+    ThreadId tid;
+    uint64_t cpuTime; // in microseconds
+    std::string name;
+  };
+
+  uint32_t cpuCount;
+  uint64_t timestamp; // in microseconds
+  uint64_t cpuTime;   // in microseconds, sum of all threads
+  std::vector<ThreadUsage> threads;
+  uint64_t hostMemory;
+  uint64_t virtualMemory;
+  uint64_t residentMemory;
+  uint64_t sharedMemory;
+
+  ProfileData() { clear(); }
+
+  inline void clear() {
+    cpuCount = 0;
+    timestamp = 0;
+    cpuTime = 0;
+    threads.clear();
+    hostMemory = 0;
+    virtualMemory = 0;
+    residentMemory = 0;
+    sharedMemory = 0;
+  }
+};
 } // namespace ds2
@@ -31,12 +31,21 @@ enum LogLevel {
   kLogLevelFatal,
 };
 
+// Exposed so that DS2LOG can check it inline; use Set/GetLogLevel.
+extern LogLevel gLogLevel;
+
 LogLevel GetLogLevel();
 void SetLogLevel(LogLevel level);
 void SetLogColorsEnabled(bool enabled);
 std::string const &GetLogOutputFilename();
 void SetLogOutputFilename(std::string const &filename);
 
+// Log records are formatted and written by a background thread. Fatal
+// messages and messages logged while asynchronous logging is disabled (e.g.
+// in a fork()'d child) are written immediately.
+void SetLogAsynchronous(bool enabled);
+void FlushLog();
+
 void Log(int level, char const *classname, char const *funcname,
          char const *format, ...) DS2_ATTRIBUTE_PRINTF(4, 5);
 
@@ -58,8 +67,11 @@ void Log(int level, char const *classname, char const *funcname,
 #error "Compiler not supported."
 #endif
 
+// Arguments are not evaluated when the level is disabled.
 #define DS2LOG(LVL, ...)                                                       \
-  ds2::Log(ds2::kLogLevel##LVL, nullptr, FUNCTION_NAME, __VA_ARGS__)
+  (ds2::kLogLevel##LVL < ds2::gLogLevel                                        \
+       ? (void)0                                                               \
+       : ds2::Log(ds2::kLogLevel##LVL, nullptr, FUNCTION_NAME, __VA_ARGS__))
 
 #if !defined(NDEBUG)
 #define DS2ASSERT(COND)                                                        \
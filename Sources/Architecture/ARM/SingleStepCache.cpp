@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Architecture/ARM/SingleStepCache.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ds2 {
+namespace Architecture {
+namespace ARM {
+
+namespace {
+
+// An IT instruction followed by four 4-byte Thumb2 instructions is the
+// longest sequence an entry is decoded from.
+static uint32_t const kMaxEntryExtent = 2 + 4 * 4;
+
+static inline uint64_t MakeKey(uint64_t pc, bool thumb) {
+  return (pc << 1) | (thumb ? 1 : 0);
+}
+
+static inline uint64_t EntryEnd(uint64_t pc, SingleStepCache::Entry const &e) {
+  return std::max<uint64_t>(e.nextPC, pc + 4);
+}
+} // namespace
+
+SingleStepCache::Entry const *SingleStepCache::find(uint32_t pc,
+                                                    bool thumb) const {
+  auto it = _entries.find(MakeKey(pc, thumb));
+  return (it == _entries.end()) ? nullptr : &it->second;
+}
+
+void SingleStepCache::insert(uint32_t pc, bool thumb, Entry const &entry) {
+  if (_entries.size() >= kMaxEntries) {
+    _entries.clear();
+  }
+
+  _entries[MakeKey(pc, thumb)] = entry;
+}
+
+void SingleStepCache::invalidate(uint64_t address, size_t length) {
+  if (length == 0 || _entries.empty()) {
+    return;
+  }
+
+  uint64_t first = (address > kMaxEntryExtent) ? address - kMaxEntryExtent : 0;
+  uint64_t end = address + length;
+  if (end < address) {
+    end = UINT64_MAX;
+  }
+
+  auto it = _entries.lower_bound(MakeKey(first, false));
+  while (it != _entries.end()) {
+    uint64_t pc = it->first >> 1;
+    if (pc >= end) {
+      break;
+    }
+
+    if (EntryEnd(pc, it->second) > address) {
+      it = _entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void SingleStepCache::updateLibraries(uint64_t signature) {
+  if (signature != _librariesSignature) {
+    _entries.clear();
+    _librariesSignature = signature;
+  }
+}
+} // namespace ARM
+} // namespace Architecture
+} // namespace ds2
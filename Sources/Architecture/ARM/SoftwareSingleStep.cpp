@@ -10,6 +10,7 @@
 
 #include "DebugServer2/Architecture/ARM/SoftwareSingleStep.h"
 #include "DebugServer2/Architecture/ARM/Branching.h"
+#include "DebugServer2/Architecture/ARM/SingleStepCache.h"
 #include "DebugServer2/Utils/Bits.h"
 #include "DebugServer2/Utils/Log.h"
 
@@ -20,19 +21,83 @@ namespace ds2 {
 namespace Architecture {
 namespace ARM {
 
+namespace {
+
+//
+// Decoding only depends on the instruction bytes, so the result is kept in
+// the process' single-step cache; stepping through a loop then doesn't read
+// and decode the same instructions on every iteration.
+//
+ErrorCode DecodeThumbInstruction(Process *process, uint32_t pc,
+                                 SingleStepCache::Entry &entry) {
+  SingleStepCache &cache = process->singleStepCache();
+  SingleStepCache::Entry const *cached = cache.find(pc, true);
+  if (cached != nullptr) {
+    entry = *cached;
+    return kSuccess;
+  }
+
+  uint32_t insns[2];
+
+  CHK(process->readMemory(pc, insns, sizeof(insns)));
+
+  entry.branch = GetThumbBranchInfo(insns, entry.info);
+  entry.nextPC = pc + static_cast<uint8_t>(GetThumbInstSize(insns[0]));
+
+  //
+  // An IT instruction is 2 bytes long; we need to read all the instructions
+  // in the IT block and skip past them.
+  //
+  if (entry.branch && entry.info.it) {
+    uint16_t itinsns[4 * 2]; // At most 4 instructions in the IT block.
+
+    entry.nextPC = pc + 2;
+    CHK(process->readMemory(entry.nextPC, itinsns, sizeof(itinsns)));
+
+    size_t skip = 0;
+    for (size_t n = 0; n < entry.info.itCount; n++) {
+      skip += static_cast<uint8_t>(GetThumbInstSize(itinsns[skip / 2]));
+    }
+
+    entry.nextPC += skip;
+  }
+
+  cache.insert(pc, true, entry);
+  return kSuccess;
+}
+
+ErrorCode DecodeARMInstruction(Process *process, uint32_t pc,
+                               SingleStepCache::Entry &entry) {
+  SingleStepCache &cache = process->singleStepCache();
+  SingleStepCache::Entry const *cached = cache.find(pc, false);
+  if (cached != nullptr) {
+    entry = *cached;
+    return kSuccess;
+  }
+
+  uint32_t insn;
+
+  CHK(process->readMemory(pc, &insn, sizeof(insn)));
+
+  entry.branch = GetARMBranchInfo(insn, entry.info);
+  entry.nextPC = pc + 4;
+
+  cache.insert(pc, false, entry);
+  return kSuccess;
+}
+} // namespace
+
 ErrorCode PrepareThumbSoftwareSingleStep(Process *process, uint32_t pc,
                                          CPUState const &state, bool &link,
                                          uint32_t &nextPC, uint32_t &nextPCSize,
                                          uint32_t &branchPC,
                                          uint32_t &branchPCSize) {
-  uint32_t insns[2];
+  SingleStepCache::Entry entry;
+  CHK(DecodeThumbInstruction(process, pc, entry));
 
-  CHK(process->readMemory(pc, insns, sizeof(insns)));
-
-  ds2::Architecture::ARM::BranchInfo info;
-  if (!ds2::Architecture::ARM::GetThumbBranchInfo(insns, info)) {
-    nextPC = pc + static_cast<uint8_t>(
-                      ds2::Architecture::ARM::GetThumbInstSize(insns[0]));
+  BranchInfo const &info = entry.info;
+  if (!entry.branch) {
+    nextPC = entry.nextPC;
     // Even if the next instruction is a 4-byte Thumb2 instruction, we are fine
     // with a 2-byte breakpoint because we won't ever jump over that
     // instruction.
@@ -47,22 +112,7 @@ ErrorCode PrepareThumbSoftwareSingleStep(Process *process, uint32_t pc,
   // If it's inside an IT block, we need to set the branch after the IT block.
   //
   if (info.it) {
-    nextPC = pc + 2;
-
-    //
-    // We need to read all the instructions in the IT block and skip past them.
-    //
-    uint16_t itinsns[4 * 2]; // At most 4 instructions in the IT block.
-
-    CHK(process->readMemory(nextPC, itinsns, sizeof(itinsns)));
-
-    size_t skip = 0;
-    for (size_t n = 0; n < info.itCount; n++) {
-      skip += static_cast<uint8_t>(
-          ds2::Architecture::ARM::GetThumbInstSize(itinsns[skip / 2]));
-    }
-
-    nextPC += skip;
+    nextPC = entry.nextPC;
     //
     // Even if the next instruction is a 4-byte Thumb2 instruction, we are fine
     // with a 2-byte breakpoint because we won't ever jump over that
@@ -83,8 +133,7 @@ ErrorCode PrepareThumbSoftwareSingleStep(Process *process, uint32_t pc,
   //
   if (info.type == ds2::Architecture::ARM::kBranchTypeBcc_i ||
       info.type == ds2::Architecture::ARM::kBranchTypeCB_i || link) {
-    nextPC = pc + static_cast<uint8_t>(
-                      ds2::Architecture::ARM::GetThumbInstSize(insns[0]));
+    nextPC = entry.nextPC;
     nextPCSize = 2;
   }
 
@@ -194,14 +243,13 @@ ErrorCode PrepareARMSoftwareSingleStep(Process *process, uint32_t pc,
                                        uint32_t &nextPC, uint32_t &nextPCSize,
                                        uint32_t &branchPC,
                                        uint32_t &branchPCSize) {
-  uint32_t insn;
+  SingleStepCache::Entry entry;
+  CHK(DecodeARMInstruction(process, pc, entry));
 
-  CHK(process->readMemory(pc, &insn, sizeof(insn)));
-
-  Architecture::ARM::BranchInfo info;
-  if (!Architecture::ARM::GetARMBranchInfo(insn, info)) {
+  BranchInfo const &info = entry.info;
+  if (!entry.branch) {
     // We couldn't find a branch, the next instruction is standard ARM.
-    nextPC = pc + 4;
+    nextPC = entry.nextPC;
     nextPCSize = 4;
     return kSuccess;
   }
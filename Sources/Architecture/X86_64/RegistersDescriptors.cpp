@@ -43,6 +43,50 @@ extern RegisterDef const reg_def_ymm13;
 extern RegisterDef const reg_def_ymm14;
 extern RegisterDef const reg_def_ymm15;
 
+// Register Set (avx512-mask-regs)
+extern RegisterDef const reg_def_k0;
+extern RegisterDef const reg_def_k1;
+extern RegisterDef const reg_def_k2;
+extern RegisterDef const reg_def_k3;
+extern RegisterDef const reg_def_k4;
+extern RegisterDef const reg_def_k5;
+extern RegisterDef const reg_def_k6;
+extern RegisterDef const reg_def_k7;
+
+// Register Set (avx512-regs)
+extern RegisterDef const reg_def_zmm0;
+extern RegisterDef const reg_def_zmm1;
+extern RegisterDef const reg_def_zmm2;
+extern RegisterDef const reg_def_zmm3;
+extern RegisterDef const reg_def_zmm4;
+extern RegisterDef const reg_def_zmm5;
+extern RegisterDef const reg_def_zmm6;
+extern RegisterDef const reg_def_zmm7;
+extern RegisterDef const reg_def_zmm8;
+extern RegisterDef const reg_def_zmm9;
+extern RegisterDef const reg_def_zmm10;
+extern RegisterDef const reg_def_zmm11;
+extern RegisterDef const reg_def_zmm12;
+extern RegisterDef const reg_def_zmm13;
+extern RegisterDef const reg_def_zmm14;
+extern RegisterDef const reg_def_zmm15;
+extern RegisterDef const reg_def_zmm16;
+extern RegisterDef const reg_def_zmm17;
+extern RegisterDef const reg_def_zmm18;
+extern RegisterDef const reg_def_zmm19;
+extern RegisterDef const reg_def_zmm20;
+extern RegisterDef const reg_def_zmm21;
+extern RegisterDef const reg_def_zmm22;
+extern RegisterDef const reg_def_zmm23;
+extern RegisterDef const reg_def_zmm24;
+extern RegisterDef const reg_def_zmm25;
+extern RegisterDef const reg_def_zmm26;
+extern RegisterDef const reg_def_zmm27;
+extern RegisterDef const reg_def_zmm28;
+extern RegisterDef const reg_def_zmm29;
+extern RegisterDef const reg_def_zmm30;
+extern RegisterDef const reg_def_zmm31;
+
 // Register Set (eflags)
 extern RegisterDef const reg_def_eflags;
 
@@ -254,8 +298,27 @@ RegisterDef const *const lldb_reg_defs_2[] = {
 LLDBRegisterSet const lldb_reg_set_2 = {"Advanced Vector Extensions", 16,
                                         lldb_reg_defs_2};
 
+// LLDB Register Set (AVX-512 Registers)
+
+RegisterDef const *const lldb_reg_defs_3[] = {
+    &reg_def_zmm0,  &reg_def_zmm1,  &reg_def_zmm2,  &reg_def_zmm3,
+    &reg_def_zmm4,  &reg_def_zmm5,  &reg_def_zmm6,  &reg_def_zmm7,
+    &reg_def_zmm8,  &reg_def_zmm9,  &reg_def_zmm10, &reg_def_zmm11,
+    &reg_def_zmm12, &reg_def_zmm13, &reg_def_zmm14, &reg_def_zmm15,
+    &reg_def_zmm16, &reg_def_zmm17, &reg_def_zmm18, &reg_def_zmm19,
+    &reg_def_zmm20, &reg_def_zmm21, &reg_def_zmm22, &reg_def_zmm23,
+    &reg_def_zmm24, &reg_def_zmm25, &reg_def_zmm26, &reg_def_zmm27,
+    &reg_def_zmm28, &reg_def_zmm29, &reg_def_zmm30, &reg_def_zmm31,
+    &reg_def_k0,    &reg_def_k1,    &reg_def_k2,    &reg_def_k3,
+    &reg_def_k4,    &reg_def_k5,    &reg_def_k6,    &reg_def_k7,
+    nullptr};
+
+LLDBRegisterSet const lldb_reg_set_3 = {"AVX-512 Registers", 40,
+                                        lldb_reg_defs_3};
+
 LLDBRegisterSet const *const lldb_reg_sets[] = {
-    &lldb_reg_set_0, &lldb_reg_set_1, &lldb_reg_set_2, nullptr};
+    &lldb_reg_set_0, &lldb_reg_set_1, &lldb_reg_set_2, &lldb_reg_set_3,
+    nullptr};
 
 //
 // GDB Features
@@ -546,86 +609,118 @@ RegisterDef const *const reg_cnt_defs_r14l[] = {&reg_def_r14, nullptr};
 RegisterDef const *const reg_inv_defs_r15l[] = {
     &reg_def_r15, &reg_def_r15d, &reg_def_r15w, &reg_def_r15l, nullptr};
 RegisterDef const *const reg_cnt_defs_r15l[] = {&reg_def_r15, nullptr};
-RegisterDef const *const reg_inv_defs_ymm0[] = {&reg_def_ymm0, &reg_def_xmm0,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm1[] = {&reg_def_ymm1, &reg_def_xmm1,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm2[] = {&reg_def_ymm2, &reg_def_xmm2,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm3[] = {&reg_def_ymm3, &reg_def_xmm3,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm4[] = {&reg_def_ymm4, &reg_def_xmm4,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm5[] = {&reg_def_ymm5, &reg_def_xmm5,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm6[] = {&reg_def_ymm6, &reg_def_xmm6,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm7[] = {&reg_def_ymm7, &reg_def_xmm7,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm8[] = {&reg_def_ymm8, &reg_def_xmm8,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm9[] = {&reg_def_ymm9, &reg_def_xmm9,
-                                                nullptr};
-RegisterDef const *const reg_inv_defs_ymm10[] = {&reg_def_ymm10, &reg_def_xmm10,
-                                                 nullptr};
-RegisterDef const *const reg_inv_defs_ymm11[] = {&reg_def_ymm11, &reg_def_xmm11,
-                                                 nullptr};
-RegisterDef const *const reg_inv_defs_ymm12[] = {&reg_def_ymm12, &reg_def_xmm12,
-                                                 nullptr};
-RegisterDef const *const reg_inv_defs_ymm13[] = {&reg_def_ymm13, &reg_def_xmm13,
-                                                 nullptr};
-RegisterDef const *const reg_inv_defs_ymm14[] = {&reg_def_ymm14, &reg_def_xmm14,
-                                                 nullptr};
-RegisterDef const *const reg_inv_defs_ymm15[] = {&reg_def_ymm15, &reg_def_xmm15,
-                                                 nullptr};
-RegisterDef const *const reg_inv_defs_xmm0[] = {&reg_def_ymm0, &reg_def_xmm0,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_ymm0[] = {&reg_def_zmm0, &reg_def_ymm0,
+                                                &reg_def_xmm0, nullptr};
+RegisterDef const *const reg_inv_defs_ymm1[] = {&reg_def_zmm1, &reg_def_ymm1,
+                                                &reg_def_xmm1, nullptr};
+RegisterDef const *const reg_inv_defs_ymm2[] = {&reg_def_zmm2, &reg_def_ymm2,
+                                                &reg_def_xmm2, nullptr};
+RegisterDef const *const reg_inv_defs_ymm3[] = {&reg_def_zmm3, &reg_def_ymm3,
+                                                &reg_def_xmm3, nullptr};
+RegisterDef const *const reg_inv_defs_ymm4[] = {&reg_def_zmm4, &reg_def_ymm4,
+                                                &reg_def_xmm4, nullptr};
+RegisterDef const *const reg_inv_defs_ymm5[] = {&reg_def_zmm5, &reg_def_ymm5,
+                                                &reg_def_xmm5, nullptr};
+RegisterDef const *const reg_inv_defs_ymm6[] = {&reg_def_zmm6, &reg_def_ymm6,
+                                                &reg_def_xmm6, nullptr};
+RegisterDef const *const reg_inv_defs_ymm7[] = {&reg_def_zmm7, &reg_def_ymm7,
+                                                &reg_def_xmm7, nullptr};
+RegisterDef const *const reg_inv_defs_ymm8[] = {&reg_def_zmm8, &reg_def_ymm8,
+                                                &reg_def_xmm8, nullptr};
+RegisterDef const *const reg_inv_defs_ymm9[] = {&reg_def_zmm9, &reg_def_ymm9,
+                                                &reg_def_xmm9, nullptr};
+RegisterDef const *const reg_inv_defs_ymm10[] = {&reg_def_zmm10, &reg_def_ymm10,
+                                                 &reg_def_xmm10, nullptr};
+RegisterDef const *const reg_inv_defs_ymm11[] = {&reg_def_zmm11, &reg_def_ymm11,
+                                                 &reg_def_xmm11, nullptr};
+RegisterDef const *const reg_inv_defs_ymm12[] = {&reg_def_zmm12, &reg_def_ymm12,
+                                                 &reg_def_xmm12, nullptr};
+RegisterDef const *const reg_inv_defs_ymm13[] = {&reg_def_zmm13, &reg_def_ymm13,
+                                                 &reg_def_xmm13, nullptr};
+RegisterDef const *const reg_inv_defs_ymm14[] = {&reg_def_zmm14, &reg_def_ymm14,
+                                                 &reg_def_xmm14, nullptr};
+RegisterDef const *const reg_inv_defs_ymm15[] = {&reg_def_zmm15, &reg_def_ymm15,
+                                                 &reg_def_xmm15, nullptr};
+RegisterDef const *const reg_inv_defs_xmm0[] = {&reg_def_zmm0, &reg_def_ymm0,
+                                                &reg_def_xmm0, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm0[] = {&reg_def_ymm0, nullptr};
-RegisterDef const *const reg_inv_defs_xmm1[] = {&reg_def_ymm1, &reg_def_xmm1,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_xmm1[] = {&reg_def_zmm1, &reg_def_ymm1,
+                                                &reg_def_xmm1, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm1[] = {&reg_def_ymm1, nullptr};
-RegisterDef const *const reg_inv_defs_xmm2[] = {&reg_def_ymm2, &reg_def_xmm2,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_xmm2[] = {&reg_def_zmm2, &reg_def_ymm2,
+                                                &reg_def_xmm2, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm2[] = {&reg_def_ymm2, nullptr};
-RegisterDef const *const reg_inv_defs_xmm3[] = {&reg_def_ymm3, &reg_def_xmm3,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_xmm3[] = {&reg_def_zmm3, &reg_def_ymm3,
+                                                &reg_def_xmm3, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm3[] = {&reg_def_ymm3, nullptr};
-RegisterDef const *const reg_inv_defs_xmm4[] = {&reg_def_ymm4, &reg_def_xmm4,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_xmm4[] = {&reg_def_zmm4, &reg_def_ymm4,
+                                                &reg_def_xmm4, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm4[] = {&reg_def_ymm4, nullptr};
-RegisterDef const *const reg_inv_defs_xmm5[] = {&reg_def_ymm5, &reg_def_xmm5,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_xmm5[] = {&reg_def_zmm5, &reg_def_ymm5,
+                                                &reg_def_xmm5, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm5[] = {&reg_def_ymm5, nullptr};
-RegisterDef const *const reg_inv_defs_xmm6[] = {&reg_def_ymm6, &reg_def_xmm6,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_xmm6[] = {&reg_def_zmm6, &reg_def_ymm6,
+                                                &reg_def_xmm6, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm6[] = {&reg_def_ymm6, nullptr};
-RegisterDef const *const reg_inv_defs_xmm7[] = {&reg_def_ymm7, &reg_def_xmm7,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_xmm7[] = {&reg_def_zmm7, &reg_def_ymm7,
+                                                &reg_def_xmm7, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm7[] = {&reg_def_ymm7, nullptr};
-RegisterDef const *const reg_inv_defs_xmm8[] = {&reg_def_ymm8, &reg_def_xmm8,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_xmm8[] = {&reg_def_zmm8, &reg_def_ymm8,
+                                                &reg_def_xmm8, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm8[] = {&reg_def_ymm8, nullptr};
-RegisterDef const *const reg_inv_defs_xmm9[] = {&reg_def_ymm9, &reg_def_xmm9,
-                                                nullptr};
+RegisterDef const *const reg_inv_defs_xmm9[] = {&reg_def_zmm9, &reg_def_ymm9,
+                                                &reg_def_xmm9, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm9[] = {&reg_def_ymm9, nullptr};
-RegisterDef const *const reg_inv_defs_xmm10[] = {&reg_def_ymm10, &reg_def_xmm10,
-                                                 nullptr};
+RegisterDef const *const reg_inv_defs_xmm10[] = {&reg_def_zmm10, &reg_def_ymm10,
+                                                 &reg_def_xmm10, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm10[] = {&reg_def_ymm10, nullptr};
-RegisterDef const *const reg_inv_defs_xmm11[] = {&reg_def_ymm11, &reg_def_xmm11,
-                                                 nullptr};
+RegisterDef const *const reg_inv_defs_xmm11[] = {&reg_def_zmm11, &reg_def_ymm11,
+                                                 &reg_def_xmm11, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm11[] = {&reg_def_ymm11, nullptr};
-RegisterDef const *const reg_inv_defs_xmm12[] = {&reg_def_ymm12, &reg_def_xmm12,
-                                                 nullptr};
+RegisterDef const *const reg_inv_defs_xmm12[] = {&reg_def_zmm12, &reg_def_ymm12,
+                                                 &reg_def_xmm12, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm12[] = {&reg_def_ymm12, nullptr};
-RegisterDef const *const reg_inv_defs_xmm13[] = {&reg_def_ymm13, &reg_def_xmm13,
-                                                 nullptr};
+RegisterDef const *const reg_inv_defs_xmm13[] = {&reg_def_zmm13, &reg_def_ymm13,
+                                                 &reg_def_xmm13, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm13[] = {&reg_def_ymm13, nullptr};
-RegisterDef const *const reg_inv_defs_xmm14[] = {&reg_def_ymm14, &reg_def_xmm14,
-                                                 nullptr};
+RegisterDef const *const reg_inv_defs_xmm14[] = {&reg_def_zmm14, &reg_def_ymm14,
+                                                 &reg_def_xmm14, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm14[] = {&reg_def_ymm14, nullptr};
-RegisterDef const *const reg_inv_defs_xmm15[] = {&reg_def_ymm15, &reg_def_xmm15,
-                                                 nullptr};
+RegisterDef const *const reg_inv_defs_xmm15[] = {&reg_def_zmm15, &reg_def_ymm15,
+                                                 &reg_def_xmm15, nullptr};
 RegisterDef const *const reg_cnt_defs_xmm15[] = {&reg_def_ymm15, nullptr};
+RegisterDef const *const reg_inv_defs_zmm0[] = {&reg_def_zmm0, &reg_def_ymm0,
+                                                &reg_def_xmm0, nullptr};
+RegisterDef const *const reg_inv_defs_zmm1[] = {&reg_def_zmm1, &reg_def_ymm1,
+                                                &reg_def_xmm1, nullptr};
+RegisterDef const *const reg_inv_defs_zmm2[] = {&reg_def_zmm2, &reg_def_ymm2,
+                                                &reg_def_xmm2, nullptr};
+RegisterDef const *const reg_inv_defs_zmm3[] = {&reg_def_zmm3, &reg_def_ymm3,
+                                                &reg_def_xmm3, nullptr};
+RegisterDef const *const reg_inv_defs_zmm4[] = {&reg_def_zmm4, &reg_def_ymm4,
+                                                &reg_def_xmm4, nullptr};
+RegisterDef const *const reg_inv_defs_zmm5[] = {&reg_def_zmm5, &reg_def_ymm5,
+                                                &reg_def_xmm5, nullptr};
+RegisterDef const *const reg_inv_defs_zmm6[] = {&reg_def_zmm6, &reg_def_ymm6,
+                                                &reg_def_xmm6, nullptr};
+RegisterDef const *const reg_inv_defs_zmm7[] = {&reg_def_zmm7, &reg_def_ymm7,
+                                                &reg_def_xmm7, nullptr};
+RegisterDef const *const reg_inv_defs_zmm8[] = {&reg_def_zmm8, &reg_def_ymm8,
+                                                &reg_def_xmm8, nullptr};
+RegisterDef const *const reg_inv_defs_zmm9[] = {&reg_def_zmm9, &reg_def_ymm9,
+                                                &reg_def_xmm9, nullptr};
+RegisterDef const *const reg_inv_defs_zmm10[] = {&reg_def_zmm10, &reg_def_ymm10,
+                                                 &reg_def_xmm10, nullptr};
+RegisterDef const *const reg_inv_defs_zmm11[] = {&reg_def_zmm11, &reg_def_ymm11,
+                                                 &reg_def_xmm11, nullptr};
+RegisterDef const *const reg_inv_defs_zmm12[] = {&reg_def_zmm12, &reg_def_ymm12,
+                                                 &reg_def_xmm12, nullptr};
+RegisterDef const *const reg_inv_defs_zmm13[] = {&reg_def_zmm13, &reg_def_ymm13,
+                                                 &reg_def_xmm13, nullptr};
+RegisterDef const *const reg_inv_defs_zmm14[] = {&reg_def_zmm14, &reg_def_ymm14,
+                                                 &reg_def_xmm14, nullptr};
+RegisterDef const *const reg_inv_defs_zmm15[] = {&reg_def_zmm15, &reg_def_ymm15,
+                                                 &reg_def_xmm15, nullptr};
 
 //
 // Flag Sets
@@ -3075,6 +3170,766 @@ RegisterDef const reg_def_xmm15 = {
     0,
     reg_inv_defs_xmm15,
     reg_cnt_defs_xmm15};
+RegisterDef const reg_def_zmm0 = {
+    "zmm0",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm0,
+    848,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm0,
+    nullptr};
+RegisterDef const reg_def_zmm1 = {
+    "zmm1",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm1,
+    912,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm1,
+    nullptr};
+RegisterDef const reg_def_zmm2 = {
+    "zmm2",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm2,
+    976,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm2,
+    nullptr};
+RegisterDef const reg_def_zmm3 = {
+    "zmm3",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm3,
+    1040,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm3,
+    nullptr};
+RegisterDef const reg_def_zmm4 = {
+    "zmm4",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm4,
+    1104,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm4,
+    nullptr};
+RegisterDef const reg_def_zmm5 = {
+    "zmm5",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm5,
+    1168,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm5,
+    nullptr};
+RegisterDef const reg_def_zmm6 = {
+    "zmm6",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm6,
+    1232,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm6,
+    nullptr};
+RegisterDef const reg_def_zmm7 = {
+    "zmm7",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm7,
+    1296,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm7,
+    nullptr};
+RegisterDef const reg_def_zmm8 = {
+    "zmm8",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm8,
+    1360,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm8,
+    nullptr};
+RegisterDef const reg_def_zmm9 = {
+    "zmm9",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm9,
+    1424,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm9,
+    nullptr};
+RegisterDef const reg_def_zmm10 = {
+    "zmm10",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm10,
+    1488,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm10,
+    nullptr};
+RegisterDef const reg_def_zmm11 = {
+    "zmm11",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm11,
+    1552,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm11,
+    nullptr};
+RegisterDef const reg_def_zmm12 = {
+    "zmm12",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm12,
+    1616,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm12,
+    nullptr};
+RegisterDef const reg_def_zmm13 = {
+    "zmm13",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm13,
+    1680,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm13,
+    nullptr};
+RegisterDef const reg_def_zmm14 = {
+    "zmm14",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm14,
+    1744,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm14,
+    nullptr};
+RegisterDef const reg_def_zmm15 = {
+    "zmm15",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm15,
+    1808,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    reg_inv_defs_zmm15,
+    nullptr};
+RegisterDef const reg_def_zmm16 = {
+    "zmm16",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm16,
+    1872,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm17 = {
+    "zmm17",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm17,
+    1936,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm18 = {
+    "zmm18",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm18,
+    2000,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm19 = {
+    "zmm19",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm19,
+    2064,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm20 = {
+    "zmm20",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm20,
+    2128,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm21 = {
+    "zmm21",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm21,
+    2192,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm22 = {
+    "zmm22",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm22,
+    2256,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm23 = {
+    "zmm23",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm23,
+    2320,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm24 = {
+    "zmm24",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm24,
+    2384,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm25 = {
+    "zmm25",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm25,
+    2448,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm26 = {
+    "zmm26",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm26,
+    2512,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm27 = {
+    "zmm27",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm27,
+    2576,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm28 = {
+    "zmm28",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm28,
+    2640,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm29 = {
+    "zmm29",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm29,
+    2704,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm30 = {
+    "zmm30",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm30,
+    2768,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_zmm31 = {
+    "zmm31",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    512,
+    -1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_zmm31,
+    2832,
+    ds2::Architecture::kLLDBVectorFormatUInt8,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatVector,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_k0 = {
+    "k0",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    64,
+    ds2::Architecture::X86_64::reg_dwarf_k0,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_k0,
+    2896,
+    ds2::Architecture::kLLDBVectorFormatNone,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatHexadecimal,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_k1 = {
+    "k1",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    64,
+    ds2::Architecture::X86_64::reg_dwarf_k1,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_k1,
+    2904,
+    ds2::Architecture::kLLDBVectorFormatNone,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatHexadecimal,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_k2 = {
+    "k2",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    64,
+    ds2::Architecture::X86_64::reg_dwarf_k2,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_k2,
+    2912,
+    ds2::Architecture::kLLDBVectorFormatNone,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatHexadecimal,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_k3 = {
+    "k3",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    64,
+    ds2::Architecture::X86_64::reg_dwarf_k3,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_k3,
+    2920,
+    ds2::Architecture::kLLDBVectorFormatNone,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatHexadecimal,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_k4 = {
+    "k4",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    64,
+    ds2::Architecture::X86_64::reg_dwarf_k4,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_k4,
+    2928,
+    ds2::Architecture::kLLDBVectorFormatNone,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatHexadecimal,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_k5 = {
+    "k5",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    64,
+    ds2::Architecture::X86_64::reg_dwarf_k5,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_k5,
+    2936,
+    ds2::Architecture::kLLDBVectorFormatNone,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatHexadecimal,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_k6 = {
+    "k6",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    64,
+    ds2::Architecture::X86_64::reg_dwarf_k6,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_k6,
+    2944,
+    ds2::Architecture::kLLDBVectorFormatNone,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatHexadecimal,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
+RegisterDef const reg_def_k7 = {
+    "k7",
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    64,
+    ds2::Architecture::X86_64::reg_dwarf_k7,
+    -1,
+    -1,
+    ds2::Architecture::X86_64::reg_lldb_k7,
+    2952,
+    ds2::Architecture::kLLDBVectorFormatNone,
+    ds2::Architecture::kEncodingUInteger,
+    ds2::Architecture::kFormatHexadecimal,
+    {ds2::Architecture::kGDBEncodingSizedInteger, nullptr},
+    ds2::Architecture::kRegisterDefNoGDBRegisterNumber,
+    nullptr,
+    nullptr};
 RegisterDef const reg_def_orig_rax = {
     "orig_rax",
     nullptr,
@@ -3104,7 +3959,7 @@ namespace ds2 {
 namespace Architecture {
 namespace X86_64 {
 
-LLDBDescriptor const LLDB = {3, lldb_reg_sets};
+LLDBDescriptor const LLDB = {4, lldb_reg_sets};
 GDBDescriptor const GDB = {"i386:x86-64", "GNU/Linux", 3, gdb_features};
 
 } // namespace X86_64
@@ -9,7 +9,12 @@
 //
 
 #include "DebugServer2/Core/HardwareBreakpointManager.h"
+#if defined(OS_LINUX)
+#include "DebugServer2/Host/Linux/ExtraWrappers.h"
+#endif
 #include "DebugServer2/Target/Process.h"
+#include "DebugServer2/Target/Thread.h"
+#include "DebugServer2/Utils/Log.h"
 
 #include <algorithm>
 
@@ -17,32 +22,243 @@
 
 namespace ds2 {
 
+//
+// Control register layout used by the Linux ptrace interface on both AArch32
+// and AArch64: enable bit, privilege level, access type and a byte address
+// select mask. The kernel aligns the address and shifts the mask itself.
+//
+static uint32_t const kCtrlEnable = 1;
+static uint32_t const kCtrlPrivilegeUser = 2 << 1;
+static uint32_t const kCtrlTypeExec = 0 << 3;
+static uint32_t const kCtrlTypeLoad = 1 << 3;
+static uint32_t const kCtrlTypeStore = 2 << 3;
+static int const kCtrlLengthShift = 5;
+
+static inline uint32_t MakeCtrl(uint32_t type, size_t length) {
+  return (((1U << length) - 1) << kCtrlLengthShift) | type |
+         kCtrlPrivilegeUser | kCtrlEnable;
+}
+
+#if defined(ARCH_ARM)
+// Offsets within a word at which the AArch32 kernel accepts a watchpoint of
+// the given length.
+static bool IsValidWatchpoint(uint64_t address, size_t length) {
+  switch (length) {
+  case 1:
+    return true;
+  case 2:
+    return (address & 3) != 3;
+  case 4:
+    return (address & 3) == 0;
+  case 8:
+    return (address & 7) == 0;
+  default:
+    return false;
+  }
+}
+#endif
+
+HardwareBreakpointManager::HardwareBreakpointManager(
+    Target::ProcessBase *process)
+    : super(process), _maxWatchpoints(process->getMaxWatchpoints()),
+      _maxBreakpoints(process->getMaxBreakpoints()),
+      _maxWatchpointSize(process->getMaxWatchpointSize()) {
+  _locations.assign(_maxWatchpoints + _maxBreakpoints, 0);
+}
+
+size_t HardwareBreakpointManager::maxWatchpoints() { return _maxWatchpoints; }
+
+void HardwareBreakpointManager::getLocationRange(Mode mode, size_t &begin,
+                                                 size_t &end) const {
+  if (mode == kModeExec) {
+    begin = _maxWatchpoints;
+    end = _locations.size();
+  } else {
+    begin = 0;
+    end = _maxWatchpoints;
+  }
+}
+
+ErrorCode HardwareBreakpointManager::getStoppointData(Site const &site,
+                                                      uint64_t &address,
+                                                      uint32_t &ctrl) const {
+  if (site.mode == kModeExec) {
+    address = site.address;
+#if defined(ARCH_ARM)
+    // Thumb instructions are matched on their first halfword, even 32-bit
+    // ones, which may not be word-aligned.
+    if ((address & 1) || site.size == 2 || site.size == 3) {
+      address &= ~1ULL;
+      ctrl = MakeCtrl(kCtrlTypeExec, 2);
+      return (address & 1) ? kErrorInvalidArgument : kSuccess;
+    }
+#endif
+    ctrl = MakeCtrl(kCtrlTypeExec, 4);
+    return (address & 3) ? kErrorInvalidArgument : kSuccess;
+  }
+
+  uint32_t type = 0;
+  if (site.mode & kModeRead) {
+    type |= kCtrlTypeLoad;
+  }
+  if (site.mode & kModeWrite) {
+    type |= kCtrlTypeStore;
+  }
+
+  if (site.size == 0 || site.size > _maxWatchpointSize) {
+    return kErrorInvalidArgument;
+  }
+
+#if defined(ARCH_ARM64)
+  // Any length works as long as the range doesn't cross a doubleword.
+  if ((site.address & 7) + site.size > 8) {
+    return kErrorInvalidArgument;
+  }
+
+  address = site.address;
+  ctrl = MakeCtrl(type, site.size);
+  return kSuccess;
+#else
+  // AArch32 only takes power-of-two lengths at some offsets; find the
+  // smallest region covering the site that it accepts.
+  uint64_t end = site.address + site.size;
+  for (size_t length = 1; length <= _maxWatchpointSize; length <<= 1) {
+    if (length < site.size) {
+      continue;
+    }
+
+    for (uint64_t base = site.address; base + length >= end; base--) {
+      if (IsValidWatchpoint(base, length)) {
+        address = base;
+        ctrl = MakeCtrl(type, length);
+        return kSuccess;
+      }
+      if (base == 0) {
+        break;
+      }
+    }
+  }
+
+  return kErrorInvalidArgument;
+#endif
+}
+
 int HardwareBreakpointManager::hit(Target::Thread *thread, Site &site) {
+#if defined(OS_LINUX)
+  if (_sites.empty() || thread->state() != Target::Thread::kStopped) {
+    return -1;
+  }
+
+  siginfo_t si;
+  ProcessThreadId ptid(_process->pid(), thread->tid());
+  auto process = static_cast<Target::Process *>(_process);
+  if (process->ptrace().getSigInfo(ptid, si) != kSuccess ||
+      si.si_code != TRAP_HWBKPT) {
+    return -1;
+  }
+
+  // Breakpoints report the PC. Watchpoints report the address accessed,
+  // which can be below the watched range for accesses wider than it; we
+  // then settle for a site in the same doubleword.
+  uint64_t address = reinterpret_cast<uintptr_t>(si.si_addr);
+  int candidate = -1;
+  for (size_t idx = 0; idx < _locations.size(); idx++) {
+    auto it = _sites.find(_locations[idx]);
+    if (_locations[idx] == 0 || it == _sites.end()) {
+      continue;
+    }
+
+    Site const &s = it->second;
+    if (s.mode == kModeExec) {
+      if ((s.address & ~1ULL) == address) {
+        site = s;
+        return idx;
+      }
+    } else if (address >= s.address && address < s.address + s.size) {
+      site = s;
+      return idx;
+    } else if (candidate < 0 && (address & ~7ULL) == (s.address & ~7ULL)) {
+      candidate = idx;
+    }
+  }
+
+  if (candidate >= 0) {
+    site = _sites.find(_locations[candidate])->second;
+  }
+  return candidate;
+#else
   return -1;
-};
+#endif
+}
 
 ErrorCode HardwareBreakpointManager::enableLocation(Site const &site, int idx,
                                                     Target::Thread *thread) {
+#if defined(OS_LINUX)
+  uint64_t address;
+  uint32_t ctrl;
+  CHK(getStoppointData(site, address, ctrl));
+
+  ProcessThreadId ptid(_process->pid(), thread->tid());
+  auto &ptrace = static_cast<Target::Process *>(_process)->ptrace();
+  if (static_cast<size_t>(idx) >= _maxWatchpoints) {
+    return ptrace.writeHardwareBreakpoint(ptid, address, ctrl,
+                                          idx - _maxWatchpoints);
+  }
+  return ptrace.writeHardwareWatchpoint(ptid, address, ctrl, idx);
+#else
   return kErrorUnsupported;
-};
+#endif
+}
 
 ErrorCode HardwareBreakpointManager::disableLocation(int idx,
                                                      Target::Thread *thread) {
+#if defined(OS_LINUX)
+  // Disabled slots get a null address and a control value that is valid for
+  // any slot of their kind, see PTrace::writeHardwareBreakpoint.
+  ProcessThreadId ptid(_process->pid(), thread->tid());
+  auto &ptrace = static_cast<Target::Process *>(_process)->ptrace();
+  if (static_cast<size_t>(idx) >= _maxWatchpoints) {
+    return ptrace.writeHardwareBreakpoint(
+        ptid, 0, MakeCtrl(kCtrlTypeExec, 4) & ~kCtrlEnable,
+        idx - _maxWatchpoints);
+  }
+  return ptrace.writeHardwareWatchpoint(
+      ptid, 0, MakeCtrl(kCtrlTypeStore, 4) & ~kCtrlEnable, idx);
+#else
   return kErrorUnsupported;
-};
-
-size_t HardwareBreakpointManager::maxWatchpoints() {
-  return _process->getMaxWatchpoints();
+#endif
 }
 
 ErrorCode HardwareBreakpointManager::isValid(Address const &address,
                                              size_t size, Mode mode) const {
-  DS2LOG(Debug, "Trying to set hardware breakpoint on arm");
-  return kErrorUnsupported;
+  if ((mode & kModeExec) && (mode & (kModeRead | kModeWrite))) {
+    DS2LOG(Debug, "Trying to set a hardware breakpoint with mixed exec and "
+                  "read/write modes");
+    return kErrorInvalidArgument;
+  }
+
+  Site site;
+  site.address = address;
+  site.size = size;
+  site.mode = mode;
+
+  uint64_t hwAddress;
+  uint32_t ctrl;
+  ErrorCode error = getStoppointData(site, hwAddress, ctrl);
+  if (error != kSuccess) {
+    DS2LOG(Debug,
+           "cannot set hardware stoppoint of %zu bytes at %#" PRIx64
+           " with mode %d",
+           size, address.value(), mode);
+    return error;
+  }
+
+  return super::isValid(address, size, mode);
 }
 
 size_t HardwareBreakpointManager::chooseBreakpointSize() const {
-  DS2BUG(
-      "Choosing a hardware breakpoint size on ARM is an unsupported operation");
+  // Only called for breakpoints with no size; assume an A32 or A64
+  // instruction, Thumb callers pass 2 or 3.
+  return 4;
 }
 } // namespace ds2
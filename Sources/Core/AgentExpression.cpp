@@ -0,0 +1,380 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Core/AgentExpression.h"
+#include "DebugServer2/Target/Process.h"
+#include "DebugServer2/Target/Thread.h"
+#include "DebugServer2/Utils/Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace ds2 {
+
+namespace {
+
+enum Opcode : uint8_t {
+  kOpAdd = 0x02,
+  kOpSub = 0x03,
+  kOpMul = 0x04,
+  kOpDivSigned = 0x05,
+  kOpDivUnsigned = 0x06,
+  kOpRemSigned = 0x07,
+  kOpRemUnsigned = 0x08,
+  kOpLsh = 0x09,
+  kOpRshSigned = 0x0a,
+  kOpRshUnsigned = 0x0b,
+  kOpTrace = 0x0c,
+  kOpTraceQuick = 0x0d,
+  kOpLogNot = 0x0e,
+  kOpBitAnd = 0x0f,
+  kOpBitOr = 0x10,
+  kOpBitXor = 0x11,
+  kOpBitNot = 0x12,
+  kOpEqual = 0x13,
+  kOpLessSigned = 0x14,
+  kOpLessUnsigned = 0x15,
+  kOpExt = 0x16,
+  kOpRef8 = 0x17,
+  kOpRef16 = 0x18,
+  kOpRef32 = 0x19,
+  kOpRef64 = 0x1a,
+  kOpIfGoto = 0x20,
+  kOpGoto = 0x21,
+  kOpConst8 = 0x22,
+  kOpConst16 = 0x23,
+  kOpConst32 = 0x24,
+  kOpConst64 = 0x25,
+  kOpReg = 0x26,
+  kOpEnd = 0x27,
+  kOpDup = 0x28,
+  kOpPop = 0x29,
+  kOpZeroExt = 0x2a,
+  kOpSwap = 0x2b,
+  kOpTraceNZ = 0x2f,
+  kOpTrace16 = 0x30,
+  kOpPick = 0x32,
+  kOpRot = 0x33,
+};
+
+// GDB limits the stack to a few dozen entries; we are slightly more lenient.
+// Since bytecode may contain backward jumps, bound the number of executed
+// instructions so a bogus condition can't hang the wait loop.
+static size_t const kMaxStackDepth = 128;
+static size_t const kMaxSteps = 1 << 16;
+
+class Interpreter {
+private:
+  ByteVector const &_bytecode;
+  Target::Thread *_thread;
+  std::vector<uint64_t> _stack;
+  Architecture::CPUState _state;
+  bool _haveState;
+  bool _haveFullState;
+  size_t _pc;
+
+public:
+  Interpreter(ByteVector const &bytecode, Target::Thread *thread)
+      : _bytecode(bytecode), _thread(thread), _haveState(false),
+        _haveFullState(false), _pc(0) {}
+
+public:
+  ErrorCode run(uint64_t &result);
+
+private:
+  bool push(uint64_t value) {
+    if (_stack.size() >= kMaxStackDepth)
+      return false;
+    _stack.push_back(value);
+    return true;
+  }
+
+  bool pop(uint64_t &value) {
+    if (_stack.empty())
+      return false;
+    value = _stack.back();
+    _stack.pop_back();
+    return true;
+  }
+
+  // Operands are encoded big-endian.
+  bool operand(size_t size, uint64_t &value) {
+    if (_pc + size > _bytecode.size())
+      return false;
+    value = 0;
+    for (size_t n = 0; n < size; n++) {
+      value = (value << 8) | _bytecode[_pc++];
+    }
+    return true;
+  }
+
+  ErrorCode readRegister(uint32_t regno, uint64_t &value);
+  ErrorCode readMemory(uint64_t address, size_t size, uint64_t &value);
+  ErrorCode binary(uint8_t op);
+};
+
+ErrorCode Interpreter::readRegister(uint32_t regno, uint64_t &value) {
+  // Conditions mostly look at general purpose registers, which don't need
+  // the full CPU state; it may be much more expensive to fetch.
+  if (!_haveState) {
+    CHK(_thread->readBaseCPUState(_state));
+    _haveState = true;
+  }
+
+  if (!_haveFullState) {
+    Architecture::GPRegisterStopMap regs;
+    _state.getStopGPState(regs, false);
+    if (regs.find(regno) == regs.end()) {
+      CHK(_thread->readCPUState(_state));
+      _haveFullState = true;
+    }
+  }
+
+  void *ptr;
+  size_t length;
+  if (!_state.getGDBRegisterPtr(regno, &ptr, &length))
+    return kErrorInvalidArgument;
+
+  value = 0;
+  std::memcpy(&value, ptr, std::min(length, sizeof(value)));
+  return kSuccess;
+}
+
+ErrorCode Interpreter::readMemory(uint64_t address, size_t size,
+                                  uint64_t &value) {
+  value = 0;
+  return _thread->process()->readMemory(address, &value, size);
+}
+
+ErrorCode Interpreter::binary(uint8_t op) {
+  uint64_t a, b;
+  if (!pop(b) || !pop(a))
+    return kErrorInvalidArgument;
+
+  switch (op) {
+  case kOpAdd:
+    a += b;
+    break;
+  case kOpSub:
+    a -= b;
+    break;
+  case kOpMul:
+    a *= b;
+    break;
+  case kOpDivSigned:
+  case kOpRemSigned:
+    if (b == 0)
+      return kErrorInvalidArgument;
+    // INT64_MIN / -1 overflows.
+    if (static_cast<int64_t>(b) == -1) {
+      a = (op == kOpDivSigned) ? -a : 0;
+    } else if (op == kOpDivSigned) {
+      a = static_cast<int64_t>(a) / static_cast<int64_t>(b);
+    } else {
+      a = static_cast<int64_t>(a) % static_cast<int64_t>(b);
+    }
+    break;
+  case kOpDivUnsigned:
+  case kOpRemUnsigned:
+    if (b == 0)
+      return kErrorInvalidArgument;
+    a = (op == kOpDivUnsigned) ? a / b : a % b;
+    break;
+  case kOpLsh:
+    a = (b < 64) ? a << b : 0;
+    break;
+  case kOpRshSigned:
+    a = static_cast<int64_t>(a) >> std::min<uint64_t>(b, 63);
+    break;
+  case kOpRshUnsigned:
+    a = (b < 64) ? a >> b : 0;
+    break;
+  case kOpBitAnd:
+    a &= b;
+    break;
+  case kOpBitOr:
+    a |= b;
+    break;
+  case kOpBitXor:
+    a ^= b;
+    break;
+  case kOpEqual:
+    a = (a == b);
+    break;
+  case kOpLessSigned:
+    a = static_cast<int64_t>(a) < static_cast<int64_t>(b);
+    break;
+  case kOpLessUnsigned:
+    a = (a < b);
+    break;
+  default:
+    DS2BUG("unexpected binary opcode %#x", op);
+  }
+
+  return push(a) ? kSuccess : kErrorInvalidArgument;
+}
+
+ErrorCode Interpreter::run(uint64_t &result) {
+  for (size_t steps = 0; steps < kMaxSteps; steps++) {
+    if (_pc >= _bytecode.size())
+      return kErrorInvalidArgument;
+
+    uint8_t op = _bytecode[_pc++];
+    uint64_t a, b, c;
+
+    switch (op) {
+    case kOpAdd:
+    case kOpSub:
+    case kOpMul:
+    case kOpDivSigned:
+    case kOpDivUnsigned:
+    case kOpRemSigned:
+    case kOpRemUnsigned:
+    case kOpLsh:
+    case kOpRshSigned:
+    case kOpRshUnsigned:
+    case kOpBitAnd:
+    case kOpBitOr:
+    case kOpBitXor:
+    case kOpEqual:
+    case kOpLessSigned:
+    case kOpLessUnsigned:
+      CHK(binary(op));
+      break;
+
+    case kOpLogNot:
+    case kOpBitNot:
+      if (!pop(a))
+        return kErrorInvalidArgument;
+      push(op == kOpLogNot ? !a : ~a);
+      break;
+
+    case kOpExt:
+    case kOpZeroExt:
+      if (!operand(1, b) || b == 0 || !pop(a))
+        return kErrorInvalidArgument;
+      if (b < 64) {
+        if (op == kOpExt) {
+          a = static_cast<int64_t>(a << (64 - b)) >> (64 - b);
+        } else {
+          a &= (1ULL << b) - 1;
+        }
+      }
+      push(a);
+      break;
+
+    case kOpRef8:
+    case kOpRef16:
+    case kOpRef32:
+    case kOpRef64:
+      if (!pop(a))
+        return kErrorInvalidArgument;
+      CHK(readMemory(a, 1 << (op - kOpRef8), b));
+      push(b);
+      break;
+
+    case kOpIfGoto:
+    case kOpGoto:
+      if (!operand(2, b))
+        return kErrorInvalidArgument;
+      if (op == kOpIfGoto) {
+        if (!pop(a))
+          return kErrorInvalidArgument;
+        if (a == 0)
+          break;
+      }
+      _pc = b;
+      break;
+
+    case kOpConst8:
+    case kOpConst16:
+    case kOpConst32:
+    case kOpConst64:
+      if (!operand(1 << (op - kOpConst8), a) || !push(a))
+        return kErrorInvalidArgument;
+      break;
+
+    case kOpReg:
+      if (!operand(2, b))
+        return kErrorInvalidArgument;
+      CHK(readRegister(b, a));
+      if (!push(a))
+        return kErrorInvalidArgument;
+      break;
+
+    case kOpEnd:
+      if (!pop(result))
+        return kErrorInvalidArgument;
+      return kSuccess;
+
+    case kOpDup:
+      if (_stack.empty() || !push(_stack.back()))
+        return kErrorInvalidArgument;
+      break;
+
+    case kOpPop:
+      if (!pop(a))
+        return kErrorInvalidArgument;
+      break;
+
+    case kOpSwap:
+      if (_stack.size() < 2)
+        return kErrorInvalidArgument;
+      std::swap(_stack[_stack.size() - 1], _stack[_stack.size() - 2]);
+      break;
+
+    case kOpPick:
+      if (!operand(1, b) || b >= _stack.size() ||
+          !push(_stack[_stack.size() - 1 - b]))
+        return kErrorInvalidArgument;
+      break;
+
+    case kOpRot:
+      // a b c => c a b
+      if (!pop(c) || !pop(b) || !pop(a))
+        return kErrorInvalidArgument;
+      push(c);
+      push(a);
+      push(b);
+      break;
+
+    // Nothing is being collected when evaluating a condition, we only need
+    // to keep the stack consistent.
+    case kOpTrace:
+    case kOpTraceNZ:
+      if (!pop(b) || !pop(a))
+        return kErrorInvalidArgument;
+      break;
+
+    case kOpTraceQuick:
+    case kOpTrace16:
+      if (!operand(op == kOpTraceQuick ? 1 : 2, a) || _stack.empty())
+        return kErrorInvalidArgument;
+      break;
+
+    default:
+      DS2LOG(Debug, "unsupported agent expression opcode %#x", op);
+      return kErrorUnsupported;
+    }
+  }
+
+  DS2LOG(Warning, "agent expression did not terminate after %zu steps",
+         kMaxSteps);
+  return kErrorInvalidArgument;
+}
+} // namespace
+
+ErrorCode AgentExpression::Evaluate(ByteVector const &bytecode,
+                                    Target::Thread *thread, uint64_t &result) {
+  Interpreter interpreter(bytecode, thread);
+  return interpreter.run(result);
+}
+} // namespace ds2
@@ -35,9 +35,13 @@ ErrorCode BreakpointManager::add(Address const &address, Lifetime lifetime,
     if (it->second.mode != mode)
       return kErrorInvalidArgument;
 
-    it->second.lifetime = static_cast<Lifetime>(it->second.lifetime | lifetime);
-    if (lifetime == Lifetime::Permanent)
+    // Inserting a permanent breakpoint is idempotent: the debugger sends the
+    // same Z packet again to update the conditions of a breakpoint, and
+    // removes it with a single z packet.
+    if (lifetime == Lifetime::Permanent &&
+        (it->second.lifetime & Lifetime::Permanent) == Lifetime::None)
       ++it->second.refs;
+    it->second.lifetime = static_cast<Lifetime>(it->second.lifetime | lifetime);
   } else {
     Site &site = _sites[address];
 
@@ -110,6 +114,26 @@ bool BreakpointManager::has(Address const &address) const {
   return (_sites.find(address) != _sites.end());
 }
 
+ErrorCode
+BreakpointManager::setConditions(Address const &address,
+                                 std::vector<ByteVector> const &conditions) {
+  auto it = _sites.find(address);
+  if (it == _sites.end())
+    return kErrorNotFound;
+
+  it->second.conditions = conditions;
+  return kSuccess;
+}
+
+bool BreakpointManager::hasConditions() const {
+  for (auto const &it : _sites) {
+    if (!it.second.conditions.empty())
+      return true;
+  }
+
+  return false;
+}
+
 void BreakpointManager::enumerate(
     std::function<void(Site const &)> const &cb) const {
   for (auto const &it : _sites) {
@@ -154,6 +178,22 @@ void BreakpointManager::disable(Target::Thread *thread) {
   }
 }
 
+ErrorCode BreakpointManager::enableSite(Address const &address) {
+  auto it = _sites.find(address);
+  if (it == _sites.end())
+    return kErrorNotFound;
+
+  return enabled() ? enableLocation(it->second) : kSuccess;
+}
+
+ErrorCode BreakpointManager::disableSite(Address const &address) {
+  auto it = _sites.find(address);
+  if (it == _sites.end())
+    return kErrorNotFound;
+
+  return enabled() ? disableLocation(it->second) : kSuccess;
+}
+
 bool BreakpointManager::hit(Address const &address, Site &site) {
   if (!address.valid())
     return false;
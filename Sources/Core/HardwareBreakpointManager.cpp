@@ -18,24 +18,35 @@
 
 namespace ds2 {
 
-HardwareBreakpointManager::HardwareBreakpointManager(
-    Target::ProcessBase *process)
-    : super(process), _locations(maxWatchpoints(), 0) {}
-
 HardwareBreakpointManager::~HardwareBreakpointManager() {}
 
 ErrorCode HardwareBreakpointManager::add(Address const &address,
                                          Lifetime lifetime, size_t size,
                                          Mode mode) {
-  if (_sites.size() >= maxWatchpoints()) {
-    return kErrorInvalidArgument;
-  }
-
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
   if (mode == kModeRead) {
     DS2LOG(Warning,
            "read-only watchpoints are unsupported, setting as read-write");
     mode = static_cast<Mode>(mode | kModeWrite);
   }
+#endif
+
+  if (!has(address)) {
+    size_t begin, end;
+    getLocationRange(mode, begin, end);
+
+    // Only count the sites competing for the same slots.
+    size_t used = 0;
+    for (auto const &it : _sites) {
+      size_t siteBegin, siteEnd;
+      getLocationRange(it.second.mode, siteBegin, siteEnd);
+      used += (siteBegin == begin) ? 1 : 0;
+    }
+
+    if (used >= end - begin) {
+      return kErrorInvalidArgument;
+    }
+  }
 
   return super::add(address, lifetime, size, mode);
 }
@@ -51,12 +62,12 @@ ErrorCode HardwareBreakpointManager::remove(Address const &address) {
 
 ErrorCode HardwareBreakpointManager::enableLocation(Site const &site,
                                                     Target::Thread *thread) {
-  ErrorCode error;
+  ErrorCode error = kSuccess;
   int idx;
 
   auto loc = std::find(_locations.begin(), _locations.end(), site.address);
   if (loc == _locations.end()) {
-    idx = getAvailableLocation();
+    idx = getAvailableLocation(site.mode);
     if (idx < 0) {
       return kErrorInvalidArgument;
     }
@@ -78,7 +89,7 @@ ErrorCode HardwareBreakpointManager::enableLocation(Site const &site,
 
 ErrorCode HardwareBreakpointManager::disableLocation(Site const &site,
                                                      Target::Thread *thread) {
-  ErrorCode error;
+  ErrorCode error = kSuccess;
 
   auto loc = std::find(_locations.begin(), _locations.end(), site.address);
   if (loc == _locations.end()) {
@@ -95,15 +106,15 @@ ErrorCode HardwareBreakpointManager::disableLocation(Site const &site,
   return error;
 }
 
-int HardwareBreakpointManager::getAvailableLocation() {
-  DS2ASSERT(_locations.size() == maxWatchpoints());
-  if (_sites.size() == maxWatchpoints()) {
+int HardwareBreakpointManager::getAvailableLocation(Mode mode) {
+  size_t begin, end;
+  getLocationRange(mode, begin, end);
+
+  auto it = std::find(_locations.begin() + begin, _locations.begin() + end, 0);
+  if (it == _locations.begin() + end) {
     return -1;
   }
 
-  auto it = std::find(_locations.begin(), _locations.end(), 0);
-  DS2ASSERT(it != _locations.end());
-
   return (it - _locations.begin());
 }
 
@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Core/MemoryArena.h"
+#include "DebugServer2/Host/Platform.h"
+#include "DebugServer2/Target/Process.h"
+#include "DebugServer2/Utils/Bits.h"
+#include "DebugServer2/Utils/Log.h"
+
+#include <algorithm>
+#include <iterator>
+
+using ds2::Host::Platform;
+
+namespace ds2 {
+
+MemoryArena::MemoryArena(Target::ProcessBase *process, uint32_t protection,
+                         size_t chunkSize)
+    : _process(process), _protection(protection), _chunkSize(chunkSize) {}
+
+ErrorCode MemoryArena::allocate(size_t size, uint64_t &address) {
+  if (size == 0) {
+    return kErrorInvalidArgument;
+  }
+
+  Utils::Align(size, kAlignment);
+
+  auto fits = [size](std::pair<uint64_t const, size_t> const &block) {
+    return block.second >= size;
+  };
+
+  auto it = std::find_if(_free.begin(), _free.end(), fits);
+  if (it == _free.end()) {
+    CHK(grow(size));
+    it = std::find_if(_free.begin(), _free.end(), fits);
+    DS2ASSERT(it != _free.end());
+  }
+
+  address = it->first;
+  size_t remaining = it->second - size;
+  _free.erase(it);
+  if (remaining > 0) {
+    _free[address + size] = remaining;
+  }
+
+  _allocated[address] = size;
+  return kSuccess;
+}
+
+ErrorCode MemoryArena::deallocate(uint64_t address) {
+  auto it = _allocated.find(address);
+  if (it == _allocated.end()) {
+    return kErrorInvalidArgument;
+  }
+
+  release(it->first, it->second);
+  _allocated.erase(it);
+  return kSuccess;
+}
+
+ErrorCode MemoryArena::grow(size_t size) {
+  size_t chunkSize = size;
+  Utils::Align(chunkSize, Platform::GetPageSize());
+  chunkSize = std::max(chunkSize, _chunkSize);
+
+  uint64_t base;
+  CHK(_process->allocateMemory(chunkSize, _protection, &base));
+
+  DS2LOG(Debug, "mapped %zu bytes arena chunk at %#" PRIx64 " (protection %#x)",
+         chunkSize, base, _protection);
+
+  release(base, chunkSize);
+  return kSuccess;
+}
+
+void MemoryArena::release(uint64_t address, size_t size) {
+  auto next = _free.lower_bound(address);
+  if (next != _free.end() && address + size == next->first) {
+    size += next->second;
+    next = _free.erase(next);
+  }
+
+  if (next != _free.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == address) {
+      prev->second += size;
+      return;
+    }
+  }
+
+  _free[address] = size;
+}
+} // namespace ds2
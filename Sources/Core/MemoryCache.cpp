@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Core/MemoryCache.h"
+#include "DebugServer2/Host/Platform.h"
+#include "DebugServer2/Utils/Log.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using ds2::Host::Platform;
+
+namespace ds2 {
+
+MemoryCache::MemoryCache() : _pageSize(Platform::GetPageSize()) {}
+
+bool MemoryCache::read(uint64_t address, void *data, size_t length) const {
+  if (length == 0 || address + length < address) {
+    return false;
+  }
+
+  uint8_t *out = static_cast<uint8_t *>(data);
+  uint64_t page = address & ~static_cast<uint64_t>(_pageSize - 1);
+  size_t offset = address - page;
+
+  auto it = _pages.find(page);
+  while (length > 0) {
+    if (it == _pages.end() || it->first != page) {
+      return false;
+    }
+
+    size_t ncopy = std::min(length, _pageSize - offset);
+    std::memcpy(out, it->second.data() + offset, ncopy);
+
+    out += ncopy;
+    length -= ncopy;
+    offset = 0;
+    page += _pageSize;
+    ++it;
+  }
+
+  return true;
+}
+
+void MemoryCache::insert(uint64_t address, void const *data, size_t length) {
+  DS2ASSERT((address & (_pageSize - 1)) == 0);
+
+  uint8_t const *in = static_cast<uint8_t const *>(data);
+  for (; length >= _pageSize; length -= _pageSize) {
+    // Keep the cache small, it only has to cover one stop's worth of reads.
+    if (_pages.size() >= kMaxPages && _pages.find(address) == _pages.end()) {
+      _pages.clear();
+    }
+
+    _pages[address].assign(in, in + _pageSize);
+    in += _pageSize;
+    address += _pageSize;
+  }
+}
+
+void MemoryCache::update(uint64_t address, void const *data, size_t length) {
+  uint8_t const *in = static_cast<uint8_t const *>(data);
+  uint64_t page = address & ~static_cast<uint64_t>(_pageSize - 1);
+  size_t offset = address - page;
+
+  while (length > 0) {
+    size_t ncopy = std::min(length, _pageSize - offset);
+
+    auto it = _pages.find(page);
+    if (it != _pages.end()) {
+      std::memcpy(it->second.data() + offset, in, ncopy);
+    }
+
+    in += ncopy;
+    length -= ncopy;
+    offset = 0;
+    page += _pageSize;
+  }
+}
+
+void MemoryCache::invalidate(uint64_t address, size_t length) {
+  if (length == 0) {
+    return;
+  }
+
+  uint64_t mask = ~static_cast<uint64_t>(_pageSize - 1);
+  uint64_t end = address + length - 1;
+  if (end < address) {
+    end = UINT64_MAX;
+  }
+
+  _pages.erase(_pages.lower_bound(address & mask),
+               _pages.upper_bound(end & mask));
+}
+} // namespace ds2
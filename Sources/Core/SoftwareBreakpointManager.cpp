@@ -104,6 +104,17 @@ void SoftwareBreakpointManager::disable(Target::Thread *thread) {
   _enabled = false;
 }
 
+void SoftwareBreakpointManager::inherit(
+    SoftwareBreakpointManager const &parent) {
+  _sites = parent._sites;
+  _insns = parent._insns;
+  _enabled = parent._enabled;
+
+  if (_enabled) {
+    disable();
+  }
+}
+
 bool SoftwareBreakpointManager::enabled(Target::Thread *thread) const {
   if (thread != nullptr) {
     DS2LOG(Warning, "thread-specific software breakpoints are unsupported");
@@ -28,10 +28,21 @@ static const int kStatusRegIdx = 6;
 static const int kCtrlRegIdx = 7;
 static const int kNumDebugRegisters = 8;
 
+HardwareBreakpointManager::HardwareBreakpointManager(
+    Target::ProcessBase *process)
+    : super(process), _locations(maxWatchpoints(), 0) {}
+
 size_t HardwareBreakpointManager::maxWatchpoints() {
   return 4; // dr0, dr1, dr2, dr3
 }
 
+void HardwareBreakpointManager::getLocationRange(Mode, size_t &begin,
+                                                 size_t &end) const {
+  // Breakpoints and watchpoints share the same debug registers.
+  begin = 0;
+  end = _locations.size();
+}
+
 ErrorCode HardwareBreakpointManager::enableLocation(Site const &site, int idx,
                                                     Target::Thread *thread) {
   ErrorCode error;
@@ -245,7 +256,7 @@ ErrorCode HardwareBreakpointManager::readDebugRegisters(
     Target::Thread *thread, std::vector<uint64_t> &regs) const {
   Architecture::CPUState state;
 
-  CHK(thread->readCPUState(state));
+  CHK(thread->readBaseCPUState(state));
 
 #if defined(ARCH_X86)
   for (int i = 0; i < kNumDebugRegisters; ++i) {
@@ -270,7 +281,7 @@ ErrorCode HardwareBreakpointManager::writeDebugRegisters(
     Target::Thread *thread, std::vector<uint64_t> &regs) const {
   Architecture::CPUState state;
 
-  CHK(thread->readCPUState(state));
+  CHK(thread->readBaseCPUState(state));
 
 #if defined(ARCH_X86)
   for (int i = 0; i < kNumDebugRegisters; ++i) {
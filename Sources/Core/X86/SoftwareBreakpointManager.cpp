@@ -27,7 +27,7 @@ int SoftwareBreakpointManager::hit(Target::Thread *thread, Site &site) {
   if (thread->state() == Target::Thread::kStepped)
     return 0;
 
-  thread->readCPUState(state);
+  thread->readBaseCPUState(state);
   state.setPC(state.pc() - 1);
 
   if (super::hit(state.pc(), site)) {
@@ -39,7 +39,7 @@ int SoftwareBreakpointManager::hit(Target::Thread *thread, Site &site) {
       abort();
 
     uint64_t ex = state.pc();
-    thread->readCPUState(state);
+    thread->readBaseCPUState(state);
     DS2ASSERT(ex == state.pc());
 
     return 0;
@@ -0,0 +1,188 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/GDBRemote/Compression.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace ds2 {
+namespace GDBRemote {
+
+namespace {
+
+//
+// LZ4 block format: a sequence is a token (literal length in the high
+// nibble, match length - 4 in the low nibble), optional extra literal length
+// bytes, the literals, a 16-bit little-endian match offset and optional extra
+// match length bytes. The last sequence only has literals, the last 5 bytes
+// of the block are always literals and the last match starts at least 12
+// bytes before the end of the block.
+//
+static size_t const kLZ4MinMatch = 4;
+static size_t const kLZ4LastLiterals = 5;
+static size_t const kLZ4MatchFindLimit = 12;
+static size_t const kLZ4MaxOffset = 65535;
+static unsigned const kLZ4HashBits = 12;
+
+static inline uint32_t Read32(std::string const &input, size_t pos) {
+  uint32_t value;
+  std::memcpy(&value, &input[pos], sizeof(value));
+  return value;
+}
+
+static inline uint32_t HashLZ4(uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - kLZ4HashBits);
+}
+
+static void PutLength(std::string &output, size_t length) {
+  while (length >= 255) {
+    output.push_back(static_cast<char>(255));
+    length -= 255;
+  }
+  output.push_back(static_cast<char>(length));
+}
+
+static void PutSequence(std::string &output, std::string const &input,
+                        size_t anchor, size_t literals, size_t offset,
+                        size_t match) {
+  uint8_t token = (std::min<size_t>(literals, 15) << 4);
+  if (match != 0) {
+    token |= std::min<size_t>(match - kLZ4MinMatch, 15);
+  }
+  output.push_back(static_cast<char>(token));
+
+  if (literals >= 15) {
+    PutLength(output, literals - 15);
+  }
+  output.append(input, anchor, literals);
+
+  if (match == 0) {
+    return;
+  }
+
+  output.push_back(static_cast<char>(offset & 0xff));
+  output.push_back(static_cast<char>(offset >> 8));
+  if (match - kLZ4MinMatch >= 15) {
+    PutLength(output, match - kLZ4MinMatch - 15);
+  }
+}
+
+// Greedy single-probe matcher; it trades ratio for speed, which is what we
+// want on the packet path.
+static void CompressLZ4(std::string const &input, std::string &output) {
+  size_t const size = input.size();
+  size_t anchor = 0;
+
+  output.clear();
+  output.reserve(size + size / 255 + 16);
+
+  if (size > kLZ4MatchFindLimit) {
+    std::vector<uint32_t> table(1 << kLZ4HashBits, UINT32_MAX);
+    size_t const matchLimit = size - kLZ4MatchFindLimit;
+    size_t const matchEnd = size - kLZ4LastLiterals;
+    size_t pos = 0;
+
+    while (pos < matchLimit) {
+      uint32_t sequence = Read32(input, pos);
+      uint32_t &slot = table[HashLZ4(sequence)];
+      size_t ref = slot;
+      slot = pos;
+
+      if (ref == UINT32_MAX || pos - ref > kLZ4MaxOffset ||
+          Read32(input, ref) != sequence) {
+        pos++;
+        continue;
+      }
+
+      size_t match = kLZ4MinMatch;
+      while (pos + match < matchEnd &&
+             input[ref + match] == input[pos + match]) {
+        match++;
+      }
+
+      PutSequence(output, input, anchor, pos - anchor, pos - ref, match);
+      pos += match;
+      anchor = pos;
+    }
+  }
+
+  PutSequence(output, input, anchor, size - anchor, 0, 0);
+}
+
+#if defined(HAVE_ZLIB)
+static bool CompressZlibDeflate(std::string const &input, std::string &output) {
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+
+  // Negative window bits produce a raw deflate stream.
+  if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, -15, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+
+  output.resize(deflateBound(&stream, input.size()));
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+  stream.avail_in = input.size();
+  stream.next_out = reinterpret_cast<Bytef *>(&output[0]);
+  stream.avail_out = output.size();
+
+  int ret = deflate(&stream, Z_FINISH);
+  output.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  return ret == Z_STREAM_END;
+}
+#endif
+} // namespace
+
+std::string Compression::SupportedTypes() {
+#if defined(HAVE_ZLIB)
+  return "lz4,zlib-deflate";
+#else
+  return "lz4";
+#endif
+}
+
+CompressionType Compression::Parse(std::string const &name) {
+  if (name == "lz4") {
+    return kCompressionTypeLZ4;
+  }
+#if defined(HAVE_ZLIB)
+  if (name == "zlib-deflate") {
+    return kCompressionTypeZlibDeflate;
+  }
+#endif
+  return kCompressionTypeNone;
+}
+
+bool Compression::Compress(CompressionType type, std::string const &input,
+                           std::string &output) {
+  switch (type) {
+  case kCompressionTypeLZ4:
+    CompressLZ4(input, output);
+    return true;
+
+#if defined(HAVE_ZLIB)
+  case kCompressionTypeZlibDeflate:
+    return CompressZlibDeflate(input, output);
+#endif
+
+  default:
+    return false;
+  }
+}
+} // namespace GDBRemote
+} // namespace ds2
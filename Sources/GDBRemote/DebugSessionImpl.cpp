@@ -13,11 +13,17 @@
 #include "DebugServer2/Core/SoftwareBreakpointManager.h"
 #include "DebugServer2/GDBRemote/Session.h"
 #include "DebugServer2/Host/Platform.h"
+#if defined(OS_LINUX)
+#include "DebugServer2/Host/Linux/ProcessWatcher.h"
+#endif
 #include "DebugServer2/Utils/HexValues.h"
 #include "DebugServer2/Utils/Log.h"
 #include "DebugServer2/Utils/Paths.h"
 #include "DebugServer2/Utils/Stringify.h"
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -30,14 +36,22 @@ namespace GDBRemote {
 
 DebugSessionImplBase::DebugSessionImplBase(StringCollection const &args,
                                            EnvironmentBlock const &env)
-    : DummySessionDelegateImpl(), _resumeSession(nullptr) {
+    : DummySessionDelegateImpl(), _forkEvents(false), _vforkEvents(false),
+      _attachWaitCancelled(false), _resumeSession(nullptr), _consoleDropped(0),
+      _outputForwarding(false), _outputRateLimit(0), _outputBudget(0),
+      _profilerEnabled(false), _profilerInterval(0), _profilerScanType(0),
+      _expeditedStackSize(kDefaultExpeditedStackSize) {
   DS2ASSERT(args.size() >= 1);
   _resumeSessionLock.lock();
   spawnProcess(args, env);
 }
 
 DebugSessionImplBase::DebugSessionImplBase(int attachPid)
-    : DummySessionDelegateImpl(), _resumeSession(nullptr) {
+    : DummySessionDelegateImpl(), _forkEvents(false), _vforkEvents(false),
+      _attachWaitCancelled(false), _resumeSession(nullptr), _consoleDropped(0),
+      _outputForwarding(false), _outputRateLimit(0), _outputBudget(0),
+      _profilerEnabled(false), _profilerInterval(0), _profilerScanType(0),
+      _expeditedStackSize(kDefaultExpeditedStackSize) {
   _resumeSessionLock.lock();
   _process = ds2::Target::Process::Attach(attachPid);
   if (_process == nullptr)
@@ -45,12 +59,22 @@ DebugSessionImplBase::DebugSessionImplBase(int attachPid)
 }
 
 DebugSessionImplBase::DebugSessionImplBase()
-    : DummySessionDelegateImpl(), _process(nullptr), _resumeSession(nullptr) {
+    : DummySessionDelegateImpl(), _process(nullptr), _forkEvents(false),
+      _vforkEvents(false), _attachWaitCancelled(false),
+      _resumeSession(nullptr), _consoleDropped(0), _outputForwarding(false),
+      _outputRateLimit(0), _outputBudget(0), _profilerEnabled(false),
+      _profilerInterval(0), _profilerScanType(0),
+      _expeditedStackSize(kDefaultExpeditedStackSize) {
   _resumeSessionLock.lock();
 }
 
 DebugSessionImplBase::~DebugSessionImplBase() {
+  stopProfiler();
+  stopOutputForwarder();
   _resumeSessionLock.unlock();
+  for (auto const &it : _inferiors) {
+    delete it.second;
+  }
   delete _process;
 }
 
@@ -66,7 +90,19 @@ size_t DebugSessionImplBase::getGPRSize() const {
 }
 
 ErrorCode DebugSessionImplBase::onInterrupt(Session &) {
-  return _process->interrupt();
+  Target::Process *process;
+  {
+    std::lock_guard<std::mutex> guard(_attachLock);
+    process = _process;
+    if (process == nullptr) {
+      // Nothing to stop yet, but a vAttachWait may be waiting, or about to
+      // wait, for a process.
+      _attachWaitCancelled = true;
+      return kSuccess;
+    }
+  }
+
+  return process->interrupt();
 }
 
 ErrorCode DebugSessionImplBase::onQuerySupported(
@@ -74,11 +110,18 @@ ErrorCode DebugSessionImplBase::onQuerySupported(
     Feature::Collection &localFeatures) const {
   for (auto feature : remoteFeatures) {
     DS2LOG(Debug, "gdb feature: %s", feature.name.c_str());
+    if (feature.name == "fork-events") {
+      _forkEvents = (feature.flag == Feature::kSupported);
+    } else if (feature.name == "vfork-events") {
+      _vforkEvents = (feature.flag == Feature::kSupported);
+    }
   }
 
   // TODO PacketSize should be respected
   localFeatures.push_back(std::string("qEcho+"));
-  localFeatures.push_back(std::string("PacketSize=3fff"));
+  std::ostringstream packetSize;
+  packetSize << "PacketSize=" << std::hex << kPacketSize;
+  localFeatures.push_back(packetSize.str());
   localFeatures.push_back(std::string("QStartNoAckMode+"));
   localFeatures.push_back(std::string("qXfer:features:read+"));
 #if defined(OS_LINUX) || defined(OS_FREEBSD)
@@ -89,18 +132,30 @@ ErrorCode DebugSessionImplBase::onQuerySupported(
 #endif
   localFeatures.push_back(std::string("QListThreadsInStopReply+"));
   localFeatures.push_back(std::string("QPassSignals+"));
+  localFeatures.push_back(std::string("MultiMemRead+"));
+#if defined(OS_LINUX)
+  localFeatures.push_back(std::string("qSaveCore+"));
+#endif
 
   if (session.mode() != kCompatibilityModeLLDB) {
+#if defined(OS_LINUX) && !defined(ARCH_ARM)
+    localFeatures.push_back(std::string("ConditionalBreakpoints+"));
+#else
     localFeatures.push_back(std::string("ConditionalBreakpoints-"));
+#endif
     localFeatures.push_back(std::string("BreakpointCommands+"));
     localFeatures.push_back(std::string("multiprocess+"));
     localFeatures.push_back(std::string("QDisableRandomization+"));
     localFeatures.push_back(std::string("QNonStop+"));
 #if defined(OS_LINUX)
+    localFeatures.push_back(std::string("fork-events+"));
+    localFeatures.push_back(std::string("vfork-events+"));
     localFeatures.push_back(std::string("QProgramSignals+"));
     localFeatures.push_back(std::string("qXfer:siginfo:read+"));
     localFeatures.push_back(std::string("qXfer:siginfo:write+"));
 #else
+    localFeatures.push_back(std::string("fork-events-"));
+    localFeatures.push_back(std::string("vfork-events-"));
     localFeatures.push_back(std::string("QProgramSignals-"));
     localFeatures.push_back(std::string("qXfer:siginfo:read-"));
     localFeatures.push_back(std::string("qXfer:siginfo:write-"));
@@ -154,18 +209,51 @@ ErrorCode DebugSessionImplBase::onNonStopMode(Session &session, bool enable) {
   return kSuccess;
 }
 
-Thread *DebugSessionImplBase::findThread(ProcessThreadId const &ptid) const {
+Target::Process *DebugSessionImplBase::findProcess(ProcessId pid) const {
   if (_process == nullptr)
     return nullptr;
 
-  if (ptid.validPid() && ptid.pid != _process->pid())
+  if (pid == kAnyProcessId || pid == kAllProcessId || pid == _process->pid())
+    return _process;
+
+  auto it = _inferiors.find(pid);
+  return (it != _inferiors.end()) ? it->second : nullptr;
+}
+
+void DebugSessionImplBase::selectProcess(Target::Process *process) {
+  if (process == _process)
+    return;
+
+  DS2LOG(Debug, "switching to pid %" PRIu64, (uint64_t)process->pid());
+
+  _inferiors.erase(process->pid());
+  // Forget about processes that are gone once the debugger moves on.
+  if (_process->isAlive()) {
+    _inferiors[_process->pid()] = _process;
+  } else {
+    dropArenas(_process->pid());
+    delete _process;
+  }
+  _process = process;
+}
+
+void DebugSessionImplBase::dropArenas(ProcessId pid) {
+  auto it = _arenas.lower_bound(std::make_pair(pid, 0u));
+  while (it != _arenas.end() && it->first.first == pid) {
+    it = _arenas.erase(it);
+  }
+}
+
+Thread *DebugSessionImplBase::findThread(ProcessThreadId const &ptid) const {
+  Target::Process *process = findProcess(ptid.pid);
+  if (process == nullptr)
     return nullptr;
 
   Thread *thread = nullptr;
   if (!ptid.validTid()) {
-    thread = _process->currentThread();
+    thread = process->currentThread();
   } else {
-    thread = _process->thread(ptid.tid);
+    thread = process->thread(ptid.tid);
   }
 
   return thread;
@@ -175,6 +263,9 @@ ErrorCode DebugSessionImplBase::queryStopInfo(Session &session, Thread *thread,
                                               StopInfo &stop) const {
   DS2ASSERT(thread != nullptr);
 
+  Architecture::CPUState state;
+  bool expedite = false;
+
   // Directly copy the fields that are common between ds2::StopInfo and
   // ds2::GDBRemote::StopInfo.
   stop = thread->stopInfo();
@@ -196,10 +287,14 @@ ErrorCode DebugSessionImplBase::queryStopInfo(Session &session, Thread *thread,
     // killed.
     stop.threadName = Platform::GetThreadName(stop.ptid.pid, stop.ptid.tid);
 
-    Architecture::CPUState state;
-    CHK(thread->readCPUState(state));
+    CHK(thread->readBaseCPUState(state));
     state.getStopGPState(stop.registers,
                          session.mode() == kCompatibilityModeLLDB);
+
+    // Only the thread reporting the stop gets expedited data; this is also
+    // used to build jThreadsInfo and qThreadStopInfo replies.
+    expedite = session.mode() == kCompatibilityModeLLDB &&
+               thread == _process->currentThread();
   } break;
 
   case StopInfo::kEventExit:
@@ -214,9 +309,81 @@ ErrorCode DebugSessionImplBase::queryStopInfo(Session &session, Thread *thread,
   _process->enumerateThreads(
       [&](Thread *thread) { stop.threads.insert(thread->tid()); });
 
+  if (expedite) {
+    expediteStopInfo(thread, state, stop);
+  }
+
   return kSuccess;
 }
 
+void DebugSessionImplBase::expediteStopInfo(Thread *thread,
+                                            Architecture::CPUState const &state,
+                                            StopInfo &stop) const {
+  _process->enumerateThreads([&](Thread *other) {
+    if (other == thread) {
+      stop.threadPCs[other->tid()] = state.pc();
+      return;
+    }
+
+    Architecture::CPUState otherState;
+    if (other->readBaseCPUState(otherState) == kSuccess) {
+      stop.threadPCs[other->tid()] = otherState.pc();
+    }
+  });
+
+  // The debugger matches PCs with the `threads` list by position, so send
+  // all of them or none.
+  if (stop.threadPCs.size() != stop.threads.size()) {
+    stop.threadPCs.clear();
+  }
+
+  ProcessInfo info;
+  if (_process->getInfo(info) != kSuccess || info.pointerSize == 0 ||
+      info.pointerSize > sizeof(uint64_t)) {
+    return;
+  }
+
+  if (_expeditedStackSize > 0) {
+    ByteVector bytes(_expeditedStackSize);
+    size_t nread = 0;
+    _process->readMemory(state.sp(), bytes.data(), bytes.size(), &nread);
+    if (nread > 0) {
+      bytes.resize(nread);
+      stop.memory[state.sp()] = std::move(bytes);
+    }
+  }
+
+  //
+  // Walk the frame pointer chain. Each frame record holds the caller's frame
+  // pointer followed by the return address, which is all the debugger needs
+  // to unwind through frames that have a frame pointer. Frames live at
+  // increasing addresses, anything else means we've lost track.
+  //
+  uint64_t fp = state.fp();
+  for (size_t n = 0; n < kMaxExpeditedFrames && fp != 0; n++) {
+    ByteVector record(2 * info.pointerSize);
+    if (_process->readMemory(fp, record.data(), record.size()) != kSuccess) {
+      break;
+    }
+
+    uint64_t next = 0;
+#if defined(ENDIAN_BIG)
+    std::memcpy(reinterpret_cast<uint8_t *>(&next) + sizeof(next) -
+                    info.pointerSize,
+                record.data(), info.pointerSize);
+#else
+    std::memcpy(&next, record.data(), info.pointerSize);
+#endif
+
+    stop.memory[fp] = std::move(record);
+
+    if (next <= fp) {
+      break;
+    }
+    fp = next;
+  }
+}
+
 ErrorCode DebugSessionImplBase::queryStopInfo(Session &session,
                                               ProcessThreadId const &ptid,
                                               StopInfo &stop) const {
@@ -239,15 +406,20 @@ ErrorCode DebugSessionImplBase::onQueryThreadStopInfo(
 
 ErrorCode DebugSessionImplBase::onQueryThreadList(Session &, ProcessId pid,
                                                   ThreadId lastTid,
-                                                  ThreadId &tid) const {
+                                                  ProcessThreadId &ptid) const {
   if (_process == nullptr)
     return kErrorProcessNotFound;
 
-  std::vector<ThreadId> tids;
-
   if (lastTid == kAllThreadId) {
-    _process->getThreadIds(tids);
-    _threadIterationState.vals = tids;
+    _threadIterationState.vals.clear();
+    auto addThread = [this](Thread *thread) {
+      _threadIterationState.vals.emplace_back(thread->process()->pid(),
+                                              thread->tid());
+    };
+    _process->enumerateThreads(addThread);
+    for (auto const &it : _inferiors) {
+      it.second->enumerateThreads(addThread);
+    }
     _threadIterationState.it = _threadIterationState.vals.begin();
   } else if (lastTid != kAnyThreadId) {
     return kErrorInvalidArgument;
@@ -256,7 +428,7 @@ ErrorCode DebugSessionImplBase::onQueryThreadList(Session &, ProcessId pid,
   if (_threadIterationState.it == _threadIterationState.vals.end())
     return kErrorNotFound;
 
-  tid = *_threadIterationState.it++;
+  ptid = *_threadIterationState.it++;
   return kSuccess;
 }
 
@@ -290,6 +462,15 @@ ErrorCode DebugSessionImplBase::onThreadIsAlive(Session &session,
   return kSuccess;
 }
 
+ErrorCode DebugSessionImplBase::onSetCurrentProcess(Session &, ProcessId pid) {
+  Target::Process *process = findProcess(pid);
+  if (process == nullptr)
+    return kErrorProcessNotFound;
+
+  selectProcess(process);
+  return kSuccess;
+}
+
 ErrorCode DebugSessionImplBase::onQueryAttached(Session &, ProcessId pid,
                                                 bool &attachedProcess) const {
   if (_process == nullptr)
@@ -474,6 +655,93 @@ ErrorCode DebugSessionImplBase::onQueryFileLoadAddress(
   return kSuccess;
 }
 
+ErrorCode DebugSessionImplBase::onEnableAsynchronousProfiling(
+    Session &, ProcessThreadId const &, bool enabled, uint32_t interval,
+    uint32_t scanType) {
+  static uint32_t const kDefaultProfilingInterval = 1000000;
+
+  if (_process == nullptr)
+    return kErrorProcessNotFound;
+
+  if (!enabled) {
+    stopProfiler();
+    return kSuccess;
+  }
+
+  std::lock_guard<std::mutex> guard(_profilerLock);
+  _profilerInterval = interval != 0 ? interval : kDefaultProfilingInterval;
+  _profilerScanType = scanType != 0 ? scanType : ProfileData::kScanAll;
+
+  if (!_profilerEnabled) {
+    _profilerEnabled = true;
+    _profiler = std::thread(&DebugSessionImplBase::profilerLoop, this);
+  }
+
+  return kSuccess;
+}
+
+ErrorCode DebugSessionImplBase::onQueryProfileData(Session &,
+                                                   ProcessThreadId const &,
+                                                   uint32_t,
+                                                   ProfileData &data) const {
+  if (_process == nullptr)
+    return kErrorProcessNotFound;
+
+  return _process->getProfileData(data);
+}
+
+ErrorCode DebugSessionImplBase::onSaveCore(Session &,
+                                           std::string const &pathHint,
+                                           std::string &path) {
+  if (_process == nullptr)
+    return kErrorProcessNotFound;
+
+  return _process->saveCore(pathHint, path);
+}
+
+void DebugSessionImplBase::stopProfiler() {
+  {
+    std::lock_guard<std::mutex> guard(_profilerLock);
+    if (!_profilerEnabled)
+      return;
+    _profilerEnabled = false;
+  }
+
+  _profilerWakeup.notify_all();
+  _profiler.join();
+}
+
+void DebugSessionImplBase::profilerLoop() {
+  std::unique_lock<std::mutex> lock(_profilerLock);
+
+  while (_profilerEnabled) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds(_profilerInterval);
+    if (_profilerWakeup.wait_until(lock, deadline,
+                                   [this] { return !_profilerEnabled; })) {
+      break;
+    }
+
+    uint32_t scanType = _profilerScanType;
+    lock.unlock();
+
+    // Samples are only sent while the inferior is running. When it is
+    // stopped, the main thread holds `_resumeSessionLock` and the debugger
+    // can use qGetProfileData instead.
+    if (_resumeSessionLock.try_lock()) {
+      if (_resumeSession != nullptr) {
+        ProfileData data;
+        if (_process->getProfileData(data) == kSuccess) {
+          _resumeSession->send("A" + data.encode(scanType));
+        }
+      }
+      _resumeSessionLock.unlock();
+    }
+
+    lock.lock();
+  }
+}
+
 ErrorCode DebugSessionImplBase::onXferRead(Session &session,
                                            std::string const &object,
                                            std::string const &annex,
@@ -529,13 +797,17 @@ ErrorCode DebugSessionImplBase::onXferRead(Session &session,
 
     ss << "<threads>" << std::endl;
 
-    _process->enumerateThreads([&](Thread *thread) {
+    auto addThread = [&](Thread *thread) {
       ss << "<thread "
-         << "id=\"p" << std::hex << _process->pid() << '.' << std::hex
-         << thread->tid() << "\" "
+         << "id=\"p" << std::hex << thread->process()->pid() << '.'
+         << std::hex << thread->tid() << "\" "
          << "core=\"" << std::dec << thread->core() << "\""
          << "/>" << std::endl;
-    });
+    };
+    _process->enumerateThreads(addThread);
+    for (auto const &it : _inferiors) {
+      it.second->enumerateThreads(addThread);
+    }
 
     ss << "</threads>" << std::endl;
 
@@ -633,6 +905,22 @@ ErrorCode DebugSessionImplBase::onSetStdFile(Session &, int fileno,
   return kErrorInvalidArgument;
 }
 
+// Registers that are part of stop replies don't need the full CPU state,
+// which may be much more expensive to fetch.
+ErrorCode DebugSessionImplBase::readRegisterState(
+    Session &session, Thread *thread, uint32_t regno,
+    Architecture::CPUState &state) const {
+  CHK(thread->readBaseCPUState(state));
+
+  Architecture::GPRegisterStopMap regs;
+  state.getStopGPState(regs, session.mode() == kCompatibilityModeLLDB);
+  if (regs.find(regno) != regs.end()) {
+    return kSuccess;
+  }
+
+  return thread->readCPUState(state);
+}
+
 ErrorCode DebugSessionImplBase::onReadGeneralRegisters(
     Session &, ProcessThreadId const &ptid,
     Architecture::GPRegisterValueVector &regs) {
@@ -641,7 +929,7 @@ ErrorCode DebugSessionImplBase::onReadGeneralRegisters(
     return kErrorProcessNotFound;
 
   Architecture::CPUState state;
-  CHK(thread->readCPUState(state));
+  CHK(thread->readBaseCPUState(state));
 
   state.getGPState(regs);
 
@@ -655,7 +943,7 @@ ErrorCode DebugSessionImplBase::onWriteGeneralRegisters(
     return kErrorProcessNotFound;
 
   Architecture::CPUState state;
-  CHK(thread->readCPUState(state));
+  CHK(thread->readBaseCPUState(state));
 
   state.setGPState(regs);
 
@@ -706,7 +994,7 @@ ErrorCode DebugSessionImplBase::onReadRegisterValue(Session &session,
     return kErrorProcessNotFound;
 
   Architecture::CPUState state;
-  CHK(thread->readCPUState(state));
+  CHK(readRegisterState(session, thread, regno, state));
 
   void *ptr;
   size_t length;
@@ -735,7 +1023,7 @@ ErrorCode DebugSessionImplBase::onWriteRegisterValue(
     return kErrorProcessNotFound;
 
   Architecture::CPUState state;
-  CHK(thread->readCPUState(state));
+  CHK(readRegisterState(session, thread, regno, state));
 
   void *ptr;
   size_t length;
@@ -766,6 +1054,25 @@ ErrorCode DebugSessionImplBase::onReadMemory(Session &, Address const &address,
     return _process->readMemoryBuffer(address, length, data);
 }
 
+ErrorCode
+DebugSessionImplBase::onReadMemoryRanges(Session &,
+                                         MemoryRange::Collection const &ranges,
+                                         std::vector<ByteVector> &data) {
+  if (_process == nullptr)
+    return kErrorProcessNotFound;
+
+  // The reply has to fit in the packet size we advertised; refuse requests
+  // that couldn't, before allocating buffers for them.
+  size_t total = 0;
+  for (auto const &range : ranges) {
+    if (range.length > kPacketSize - total)
+      return kErrorInvalidArgument;
+    total += range.length;
+  }
+
+  return _process->readMemoryRanges(ranges, data);
+}
+
 ErrorCode DebugSessionImplBase::onWriteMemory(Session &, Address const &address,
                                               ByteVector const &data,
                                               size_t &nwritten) {
@@ -778,25 +1085,34 @@ ErrorCode DebugSessionImplBase::onWriteMemory(Session &, Address const &address,
 ErrorCode DebugSessionImplBase::onAllocateMemory(Session &, size_t size,
                                                  uint32_t permissions,
                                                  Address &address) {
-  uint64_t addr;
-  ErrorCode error = _process->allocateMemory(size, permissions, &addr);
-  if (error == kSuccess) {
-    _allocations[addr] = size;
-    address = addr;
+  if (_process == nullptr)
+    return kErrorProcessNotFound;
+
+  // Blocks with different protections can't share pages, keep one arena per
+  // protection in each process.
+  auto &arena = _arenas[std::make_pair(_process->pid(), permissions)];
+  if (!arena) {
+    arena = ds2::make_unique<MemoryArena>(_process, permissions);
   }
-  return error;
+
+  uint64_t addr;
+  CHK(arena->allocate(size, addr));
+  address = addr;
+  return kSuccess;
 }
 
 ErrorCode DebugSessionImplBase::onDeallocateMemory(Session &,
                                                    Address const &address) {
-  auto i = _allocations.find(address);
-  if (i == _allocations.end())
-    return kErrorInvalidArgument;
+  if (_process == nullptr)
+    return kErrorProcessNotFound;
 
-  CHK(_process->deallocateMemory(address, i->second));
+  for (auto const &it : _arenas) {
+    if (it.first.first == _process->pid() && it.second->owns(address)) {
+      return it.second->deallocate(address);
+    }
+  }
 
-  _allocations.erase(i);
-  return kSuccess;
+  return kErrorInvalidArgument;
 }
 
 ErrorCode
@@ -832,14 +1148,91 @@ ErrorCode DebugSessionImplBase::onAttach(Session &session, ProcessId pid,
     return kErrorInvalidArgument;
 
   DS2LOG(Debug, "attaching to pid %" PRIu64, (uint64_t)pid);
-  _process = Target::Process::Attach(pid);
-  if (_process == nullptr) {
+  Target::Process *process = Target::Process::Attach(pid);
+  if (process == nullptr) {
     return kErrorProcessNotFound;
   }
 
+  {
+    std::lock_guard<std::mutex> guard(_attachLock);
+    _process = process;
+  }
+
   return queryStopInfo(session, pid, stop);
 }
 
+ErrorCode DebugSessionImplBase::onAttach(Session &session,
+                                         std::string const &name,
+                                         AttachMode mode, StopInfo &stop) {
+  if (_process != nullptr)
+    return kErrorAlreadyExist;
+
+  if (name.empty())
+    return kErrorInvalidArgument;
+
+#if defined(OS_LINUX)
+  ErrorCode error = attachWhenStarted(session, name, mode, stop);
+  // An interrupt that came before or during the wait was meant for this
+  // attach only.
+  _attachWaitCancelled = false;
+  return error;
+#else
+  if (mode != kAttachNow)
+    return kErrorUnsupported;
+
+  ProcessId pid = kAnyProcessId;
+  Platform::EnumerateProcesses(true, UserId(), [&](ProcessInfo const &info) {
+    if (pid == kAnyProcessId &&
+        (info.name == name || ds2::Utils::Basename(info.name) == name))
+      pid = info.pid;
+  });
+  if (pid == kAnyProcessId)
+    return kErrorProcessNotFound;
+
+  return onAttach(session, pid, mode, stop);
+#endif
+}
+
+#if defined(OS_LINUX)
+ErrorCode DebugSessionImplBase::attachWhenStarted(Session &session,
+                                                  std::string const &name,
+                                                  AttachMode mode,
+                                                  StopInfo &stop) {
+  // Start watching before looking at the running processes so that nothing
+  // started in the meantime is missed, and attach as soon as the program
+  // shows up.
+  Host::Linux::ProcessWatcher watcher(name);
+  ProcessId pid;
+  CHK(watcher.start(mode != kAttachAndWait, pid));
+  DS2LOG(Debug, "waiting for process %s, using %s", name.c_str(),
+         watcher.usesConnector() ? "exec events" : "/proc scans");
+
+  for (;;) {
+    if (pid != kAnyProcessId) {
+      DS2LOG(Debug, "attaching to %s, pid %" PRIu64, name.c_str(),
+             (uint64_t)pid);
+      Target::Process *process = Target::Process::Attach(pid);
+      if (process != nullptr) {
+        {
+          std::lock_guard<std::mutex> guard(_attachLock);
+          _process = process;
+        }
+        return queryStopInfo(session, pid, stop);
+      }
+
+      // The process may have exited already, or belong to someone else.
+      DS2LOG(Warning, "unable to attach to pid %" PRIu64, (uint64_t)pid);
+    }
+
+    if (mode == kAttachNow)
+      return kErrorProcessNotFound;
+
+    pid = kAnyProcessId;
+    CHK(watcher.wait(_attachWaitCancelled, pid));
+  }
+}
+#endif
+
 ErrorCode
 DebugSessionImplBase::onResume(Session &session,
                                ThreadResumeAction::Collection const &actions,
@@ -848,21 +1241,54 @@ DebugSessionImplBase::onResume(Session &session,
   ThreadResumeAction globalAction;
   bool hasGlobalAction = false;
   std::set<Thread *> excluded;
+  ThreadResumeAction rangeAction;
+  ThreadId rangeTid = kAnyThreadId;
+  std::set<ThreadId> rangeResumed, rangeKnown;
+
+  // Only one process runs at a time; it is the one the actions name, if any.
+  for (auto const &action : actions) {
+    Target::Process *process = findProcess(action.ptid.pid);
+    if (action.ptid.validPid() && process != nullptr) {
+      selectProcess(process);
+      break;
+    }
+  }
+
+#if defined(OS_LINUX)
+  _process->setForkEvents(_forkEvents, _vforkEvents);
+#endif
 
   DS2ASSERT(_resumeSession == nullptr);
   _resumeSession = &session;
   _resumeSessionLock.unlock();
+  // Output that came in while we were stopped can go out now.
+  _consoleWakeup.notify_one();
 
   error = _process->beforeResume();
   if (error != kSuccess)
     goto ret;
 
+#if defined(ARCH_ARM) || defined(ARCH_ARM64)
+  // Code can change under us while threads run freely; only keep the decoded
+  // instructions across pure single steps.
+  for (auto const &action : actions) {
+    if (action.action == kResumeActionContinue ||
+        action.action == kResumeActionContinueWithSignal) {
+      _process->singleStepCache().clear();
+      break;
+    }
+  }
+#endif
+
   //
   // First process all actions that specify a thread,
-  // save the global and trigger it later.
+  // save the global and trigger it later. In multiprocess mode, p<pid>.-1
+  // stands for all the threads of the process.
   //
   for (auto const &action : actions) {
-    if (action.ptid.any()) {
+    if (action.ptid.any() ||
+        (session.mode() == kCompatibilityModeGDBMultiprocess &&
+         action.ptid.tid == kAllThreadId)) {
       if (hasGlobalAction) {
         DS2LOG(Error, "more than one global action specified");
         error = kErrorAlreadyExist;
@@ -893,7 +1319,8 @@ DebugSessionImplBase::onResume(Session &session,
       }
       excluded.insert(thread);
     } else if (action.action == kResumeActionSingleStep ||
-               action.action == kResumeActionSingleStepWithSignal) {
+               action.action == kResumeActionSingleStepWithSignal ||
+               action.action == kResumeActionRangeStep) {
       error = thread->step(action.signal, action.address);
       if (error != kSuccess) {
         DS2LOG(Warning, "cannot step pid %" PRIu64 " tid %" PRIu64 ", error=%s",
@@ -901,6 +1328,10 @@ DebugSessionImplBase::onResume(Session &session,
                Stringify::Error(error));
         continue;
       }
+      if (action.action == kResumeActionRangeStep) {
+        rangeAction = action;
+        rangeTid = thread->tid();
+      }
       excluded.insert(thread);
     } else {
       DS2LOG(Warning,
@@ -927,7 +1358,8 @@ DebugSessionImplBase::onResume(Session &session,
                (uint64_t)_process->pid(), Stringify::Error(error));
       }
     } else if (globalAction.action == kResumeActionSingleStep ||
-               globalAction.action == kResumeActionSingleStepWithSignal) {
+               globalAction.action == kResumeActionSingleStepWithSignal ||
+               globalAction.action == kResumeActionRangeStep) {
       Thread *thread = _process->currentThread();
       if (excluded.find(thread) == excluded.end()) {
         error = thread->step(globalAction.signal, globalAction.address);
@@ -936,6 +1368,9 @@ DebugSessionImplBase::onResume(Session &session,
                  "cannot step pid %" PRIu64 " tid %" PRIu64 ", error=%s",
                  (uint64_t)_process->pid(), (uint64_t)thread->tid(),
                  Stringify::Error(error));
+        } else if (globalAction.action == kResumeActionRangeStep) {
+          rangeAction = globalAction;
+          rangeTid = thread->tid();
         }
       }
     } else {
@@ -945,6 +1380,19 @@ DebugSessionImplBase::onResume(Session &session,
     }
   }
 
+  // Remember which threads run alongside a range-stepping thread, so that we
+  // can let them go again every time it stops within the range.
+  if (rangeTid != kAnyThreadId) {
+    std::vector<ThreadId> tids;
+    _process->getThreadIds(tids);
+    for (auto tid : tids) {
+      rangeKnown.insert(tid);
+      if (_process->thread(tid)->state() == Thread::kRunning) {
+        rangeResumed.insert(tid);
+      }
+    }
+  }
+
   // If kErrorAlreadyExist is set, then a signal is already pending.
   if (error != kErrorAlreadyExist) {
     bool keepGoing = true;
@@ -963,6 +1411,11 @@ DebugSessionImplBase::onResume(Session &session,
         break;
       }
 
+      if (thread->tid() == rangeTid &&
+          stepInRange(thread, rangeAction, rangeResumed, rangeKnown)) {
+        continue;
+      }
+
       switch (thread->stopInfo().reason) {
 #if defined(OS_WIN32)
       case StopInfo::kReasonDebugOutput: {
@@ -977,6 +1430,22 @@ DebugSessionImplBase::onResume(Session &session,
         CHK(_process->currentThread()->resume());
         break;
 
+#if defined(OS_LINUX)
+      // The debugger asked for these, keep the child around so that it can
+      // work with it or detach from it.
+      case StopInfo::kReasonFork:
+      case StopInfo::kReasonVFork: {
+        ProcessId pid = thread->stopInfo().childPid;
+        Target::Process *child = Target::Process::Adopt(pid, _process);
+        if (child != nullptr) {
+          _inferiors[pid] = child;
+        } else {
+          DS2LOG(Warning, "unable to adopt child %" PRIu64, (uint64_t)pid);
+        }
+        keepGoing = false;
+      } break;
+#endif
+
       default:
         keepGoing = false;
         break;
@@ -991,28 +1460,113 @@ DebugSessionImplBase::onResume(Session &session,
 
   error = queryStopInfo(session, _process->currentThread(), stop);
 
-  if (stop.event == StopInfo::kEventExit ||
-      stop.event == StopInfo::kEventKill) {
+  // A followed child can exit while the process we spawned keeps running and
+  // printing.
+  if ((stop.event == StopInfo::kEventExit ||
+       stop.event == StopInfo::kEventKill) &&
+      (_process->pid() == _spawner.pid() || _inferiors.empty())) {
     _spawner.flushAndExit();
   }
 
 ret:
+  // The debugger must see everything the inferior printed before it stopped.
+  {
+    std::lock_guard<std::mutex> guard(_consoleLock);
+    sendOutput(session, SIZE_MAX);
+  }
+
   _resumeSessionLock.lock();
   _resumeSession = nullptr;
   return error;
 }
 
-ErrorCode DebugSessionImplBase::onDetach(Session &, ProcessId, bool stopped) {
-  SoftwareBreakpointManager *bpm = _process->softwareBreakpointManager();
+ErrorCode DebugSessionImplBase::onDetach(Session &, ProcessId pid,
+                                         bool stopped) {
+  Target::Process *process = findProcess(pid);
+  if (process == nullptr)
+    return kErrorProcessNotFound;
+
+  SoftwareBreakpointManager *bpm = process->softwareBreakpointManager();
   if (bpm != nullptr) {
     bpm->clear();
   }
 
   if (stopped) {
-    CHK(_process->suspend());
+    CHK(process->suspend());
+  }
+
+  CHK(process->detach());
+  // The memory we allocated stays with the process.
+  dropArenas(process->pid());
+
+  if (process == _process) {
+    if (_inferiors.empty())
+      return kSuccess;
+
+    // Keep going with one of the other processes we follow.
+    _process = _inferiors.begin()->second;
+    _inferiors.erase(_inferiors.begin());
+  } else {
+    _inferiors.erase(process->pid());
   }
 
-  return _process->detach();
+  delete process;
+  return kSuccess;
+}
+
+bool DebugSessionImplBase::stepInRange(Thread *thread,
+                                       ThreadResumeAction const &action,
+                                       std::set<ThreadId> const &resumed,
+                                       std::set<ThreadId> const &known) {
+  bool traced = thread->stopInfo().reason == StopInfo::kReasonTrace;
+
+  Architecture::CPUState state;
+  if (thread->readBaseCPUState(state) != kSuccess)
+    return false;
+  uint64_t pc = state.pc();
+
+#if defined(ARCH_ARM)
+  // Software single-step stops on temporary breakpoints. Cycle the breakpoint
+  // managers to get rid of them before checking for a user breakpoint.
+  if (thread->stopInfo().reason == StopInfo::kReasonBreakpoint) {
+    if (_process->afterResume() != kSuccess)
+      return false;
+    traced = !_process->softwareBreakpointManager()->has(pc & ~1ULL);
+    if (_process->beforeResume() != kSuccess)
+      return false;
+  }
+#endif
+
+  if (!traced || pc < action.rangeStart.value() ||
+      pc >= action.rangeEnd.value())
+    return false;
+
+  std::vector<ThreadId> tids;
+  _process->getThreadIds(tids);
+
+  // If a thread that was running stopped for its own reasons while we were
+  // stepping, report the stop now rather than swallow its event.
+  for (auto tid : tids) {
+    if (tid != thread->tid() && resumed.count(tid) != 0 &&
+        _process->thread(tid)->stopInfo().event != StopInfo::kEventNone)
+      return false;
+  }
+
+  if (thread->step() != kSuccess)
+    return false;
+
+  for (auto tid : tids) {
+    if (tid == thread->tid() ||
+        (resumed.count(tid) == 0 && known.count(tid) != 0))
+      continue;
+
+    Thread *other = _process->thread(tid);
+    if (other->state() != Thread::kRunning) {
+      other->resume();
+    }
+  }
+
+  return true;
 }
 
 ErrorCode DebugSessionImplBase::onTerminate(Session &session,
@@ -1020,6 +1574,12 @@ ErrorCode DebugSessionImplBase::onTerminate(Session &session,
                                             StopInfo &stop) {
   ErrorCode error;
 
+  Target::Process *process = findProcess(ptid.pid);
+  if (process == nullptr)
+    return kErrorProcessNotFound;
+
+  selectProcess(process);
+
   error = _process->terminate();
   if (error != kSuccess) {
     DS2LOG(Error, "couldn't terminate process");
@@ -1041,8 +1601,22 @@ ErrorCode DebugSessionImplBase::onExitServer(Session &session) {
   StopInfo stop;
 
   if (_process != nullptr) {
-    error = _process->attached() ? onDetach(session, pid, false)
-                                 : onTerminate(session, pid, stop);
+    // Children we followed go away along with the process we created, and
+    // stay if we attached to it.
+    bool attached = _process->attached();
+    for (auto const &it : _inferiors) {
+      if (attached) {
+        it.second->detach();
+      } else {
+        it.second->terminate();
+      }
+      dropArenas(it.first);
+      delete it.second;
+    }
+    _inferiors.clear();
+
+    error = attached ? onDetach(session, pid, false)
+                     : onTerminate(session, pid, stop);
   }
 
   DS2LOG(Debug, "exiting ds2");
@@ -1056,7 +1630,10 @@ ErrorCode DebugSessionImplBase::onInsertBreakpoint(
     Session &session, BreakpointType type, Address const &address,
     uint32_t size, StringCollection const &conditions,
     StringCollection const &commands, bool persistentCommands) {
-  DS2ASSERT(conditions.empty() && commands.empty() && !persistentCommands);
+  if (!commands.empty()) {
+    DS2LOG(Warning, "ignoring %zu breakpoint commands at %" PRI_PTR,
+           commands.size(), PRI_PTR_CAST(address.value()));
+  }
 
   BreakpointManager *bpm = nullptr;
   BreakpointManager::Mode mode;
@@ -1094,7 +1671,31 @@ ErrorCode DebugSessionImplBase::onInsertBreakpoint(
   if (bpm == nullptr)
     return kErrorUnsupported;
 
-  return bpm->add(address, BreakpointManager::Lifetime::Permanent, size, mode);
+  // Conditions are only evaluated by the process when a software breakpoint
+  // is hit. Refuse the others rather than stopping unconditionally; an empty
+  // reply would make the debugger think the breakpoint type is unsupported.
+  if (type != kSoftwareBreakpoint && !conditions.empty()) {
+    DS2LOG(Warning, "conditions on non-software breakpoint at %" PRI_PTR
+                    " are not supported",
+           PRI_PTR_CAST(address.value()));
+    return kErrorInvalidArgument;
+  }
+
+  // Inserting a breakpoint again doesn't take another reference on it, it
+  // only replaces its conditions; a breakpoint re-inserted without
+  // conditions becomes unconditional.
+  CHK(bpm->add(address, BreakpointManager::Lifetime::Permanent, size, mode));
+
+  if (type == kSoftwareBreakpoint &&
+      (!conditions.empty() || bpm->hasConditions())) {
+    std::vector<ByteVector> bytecodes;
+    for (auto const &condition : conditions) {
+      bytecodes.emplace_back(condition.begin(), condition.end());
+    }
+    CHK(bpm->setConditions(address, bytecodes));
+  }
+
+  return kSuccess;
 }
 
 ErrorCode DebugSessionImplBase::onRemoveBreakpoint(Session &session,
@@ -1127,11 +1728,10 @@ ErrorCode DebugSessionImplBase::onRemoveBreakpoint(Session &session,
 ErrorCode DebugSessionImplBase::spawnProcess(StringCollection const &args,
                                              EnvironmentBlock const &env) {
   bool displayArgs = args.size() > 1;
-  auto it = args.begin();
-  DS2LOG(Debug, "spawning process '%s'%s", (it++)->c_str(),
+  DS2LOG(Debug, "spawning process '%s'%s", args[0].c_str(),
          displayArgs ? " with args:" : "");
-  while (it != args.end()) {
-    DS2LOG(Debug, "  %s", (it++)->c_str());
+  for (auto it = args.begin() + 1; it != args.end(); ++it) {
+    DS2LOG(Debug, "  %s", it->c_str());
   }
 
   _spawner.setExecutable(args[0]);
@@ -1154,6 +1754,19 @@ ErrorCode DebugSessionImplBase::spawnProcess(StringCollection const &args,
   _spawner.redirectOutputToDelegate(outputDelegate);
   _spawner.redirectErrorToDelegate(outputDelegate);
 
+  {
+    std::lock_guard<std::mutex> guard(_consoleLock);
+    if (!_outputForwarding) {
+      _outputForwarding = true;
+      _outputForwarder =
+          std::thread(&DebugSessionImplBase::outputForwarderLoop, this);
+    }
+  }
+
+  if (_process != nullptr) {
+    dropArenas(_process->pid());
+  }
+
   _process = ds2::Target::Process::Create(_spawner);
   if (_process == nullptr) {
     DS2LOG(Error, "cannot execute '%s'", args[0].c_str());
@@ -1164,20 +1777,120 @@ ErrorCode DebugSessionImplBase::spawnProcess(StringCollection const &args,
 }
 
 void DebugSessionImplBase::appendOutput(char const *buf, size_t size) {
-  for (size_t i = 0; i < size; ++i) {
-    this->_consoleBuffer += buf[i];
-    if (buf[i] == '\n') {
-      _resumeSessionLock.lock();
-      DS2ASSERT(_resumeSession != nullptr);
-      std::string data = "O";
-      data += ToHex(this->_consoleBuffer);
-      _consoleBuffer.clear();
-      this->_resumeSession->send(data);
+  std::lock_guard<std::mutex> guard(_consoleLock);
+
+  size_t const chunkSize = (kPacketSize - 1) / 2;
+  size_t previousSize = _consoleBuffer.size();
+  size_t room = previousSize < kMaxOutputBacklog
+                    ? kMaxOutputBacklog - previousSize
+                    : 0;
+  size_t count = std::min(size, room);
+  _consoleBuffer.append(buf, count);
+  _consoleDropped += size - count;
+
+  // The forwarder only needs to know when there is something new to wait
+  // for, or when it shouldn't wait any longer.
+  if (previousSize == 0 ||
+      (previousSize < chunkSize && _consoleBuffer.size() >= chunkSize)) {
+    _consoleWakeup.notify_one();
+  }
+}
+
+void DebugSessionImplBase::outputForwarderLoop() {
+  // How long output is collected before being sent, so that chatty
+  // inferiors don't produce one packet per line.
+  static auto const kOutputFlushDelay = std::chrono::milliseconds(10);
+
+  std::unique_lock<std::mutex> lock(_consoleLock);
+  bool blocked = false;
+
+  while (_outputForwarding) {
+    if (_consoleBuffer.empty() && _consoleDropped == 0) {
+      _consoleWakeup.wait(lock);
+      continue;
+    }
+
+    if (blocked) {
+      _consoleWakeup.wait_for(lock, kOutputFlushDelay);
+    } else {
+      _consoleWakeup.wait_for(lock, kOutputFlushDelay, [this] {
+        return !_outputForwarding ||
+               _consoleBuffer.size() >= (kPacketSize - 1) / 2;
+      });
+    }
+
+    size_t budget = outputBudget();
+
+    // Output is only forwarded while the inferior is running; otherwise the
+    // main thread holds `_resumeSessionLock` and flushes it itself before
+    // sending the stop reply.
+    blocked = true;
+    if (budget > 0 && _resumeSessionLock.try_lock()) {
+      if (_resumeSession != nullptr) {
+        sendOutput(*_resumeSession, budget);
+        blocked = false;
+      }
       _resumeSessionLock.unlock();
     }
   }
 }
 
+void DebugSessionImplBase::stopOutputForwarder() {
+  {
+    std::lock_guard<std::mutex> guard(_consoleLock);
+    if (!_outputForwarding)
+      return;
+    _outputForwarding = false;
+  }
+
+  _consoleWakeup.notify_all();
+  _outputForwarder.join();
+}
+
+size_t DebugSessionImplBase::outputBudget() {
+  if (_outputRateLimit == 0)
+    return SIZE_MAX;
+
+  // Token bucket allowing bursts of up to one second worth of output.
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = now - _outputBudgetUpdate;
+  _outputBudgetUpdate = now;
+  _outputBudget = std::min<double>(_outputRateLimit,
+                                   _outputBudget +
+                                       elapsed.count() * _outputRateLimit);
+  return static_cast<size_t>(_outputBudget);
+}
+
+// Must be called with `_consoleLock` held.
+void DebugSessionImplBase::sendOutput(Session &session, size_t budget) {
+  static size_t const kMaxChunk = (kPacketSize - 1) / 2;
+
+  if (_consoleBuffer.empty() && _consoleDropped == 0)
+    return;
+
+  session.cork();
+
+  if (_consoleDropped > 0) {
+    std::ostringstream ss;
+    ss << "\n[ds2: " << _consoleDropped << " bytes of output dropped]\n";
+    session.send("O" + ToHex(ss.str()));
+    _consoleDropped = 0;
+  }
+
+  size_t count = std::min(_consoleBuffer.size(), budget);
+  for (size_t offset = 0; offset < count; offset += kMaxChunk) {
+    size_t length = std::min(kMaxChunk, count - offset);
+    session.send("O" + ToHex(_consoleBuffer.substr(offset, length)));
+  }
+  _consoleBuffer.erase(0, count);
+
+  if (_outputRateLimit != 0) {
+    _outputBudget -= std::min<double>(_outputBudget, count);
+  }
+
+  session.uncork();
+}
+
 ErrorCode DebugSessionImplBase::onSendInput(Session &session,
                                             ByteVector const &buf) {
   return _spawner.input(buf);
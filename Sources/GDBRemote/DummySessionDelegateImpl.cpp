@@ -107,6 +107,11 @@ ErrorCode DummySessionDelegateImpl::onQueryHostInfo(Session &,
   info.endian = Platform::GetEndian();
   info.pointerSize = Platform::GetPointerSize();
   info.hostName = Platform::GetHostName(/*fqdn=*/true);
+#if defined(ARCH_ARM) || defined(ARCH_ARM64)
+  // ARM watchpoints trigger before the access; the debugger has to step over
+  // the instruction with the watchpoint removed.
+  info.watchpointExceptionsReceivedBefore = true;
+#endif
 
   // In complex workflows (such as used when testing Android-ARM on CircleCI) we
   // can occasionally experience long delays that exceed the 1 second default
@@ -171,7 +176,7 @@ DUMMY_IMPL_EMPTY(onExitServer, Session &)
 DUMMY_IMPL_EMPTY(onSynchronizeThreadState, Session &, ProcessId)
 
 DUMMY_IMPL_EMPTY_CONST(onQueryThreadList, Session &, ProcessId, ThreadId,
-                       ThreadId &)
+                       ProcessThreadId &)
 
 DUMMY_IMPL_EMPTY_CONST(onQueryCurrentThread, Session &, ProcessThreadId &)
 
@@ -180,6 +185,8 @@ DUMMY_IMPL_EMPTY_CONST(onQueryThreadStopInfo, Session &,
 
 DUMMY_IMPL_EMPTY(onThreadIsAlive, Session &, ProcessThreadId const &)
 
+DUMMY_IMPL_EMPTY(onSetCurrentProcess, Session &, ProcessId)
+
 DUMMY_IMPL_EMPTY_CONST(onQueryThreadInfo, Session &, ProcessThreadId const &,
                        uint32_t, void *)
 
@@ -193,7 +200,9 @@ DUMMY_IMPL_EMPTY(onEnableAsynchronousProfiling, Session &,
                  ProcessThreadId const &, bool, uint32_t, uint32_t)
 
 DUMMY_IMPL_EMPTY_CONST(onQueryProfileData, Session &, ProcessThreadId const &,
-                       uint32_t, void *)
+                       uint32_t, ProfileData &)
+
+DUMMY_IMPL_EMPTY(onSaveCore, Session &, std::string const &, std::string &)
 
 DUMMY_IMPL_EMPTY(onResume, Session &, ThreadResumeAction::Collection const &,
                  StopInfo &)
@@ -218,6 +227,9 @@ DUMMY_IMPL_EMPTY(onRestoreRegisters, Session &, ProcessThreadId const &ptid,
 
 DUMMY_IMPL_EMPTY(onReadMemory, Session &, Address const &, size_t, ByteVector &)
 
+DUMMY_IMPL_EMPTY(onReadMemoryRanges, Session &, MemoryRange::Collection const &,
+                 std::vector<ByteVector> &)
+
 DUMMY_IMPL_EMPTY(onWriteMemory, Session &, Address const &, ByteVector const &,
                  size_t &)
 
@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/GDBRemote/PacketRecorder.h"
+#include "DebugServer2/Utils/Log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace ds2 {
+namespace GDBRemote {
+
+PacketRecorder::PacketRecorder() : _file(nullptr) {}
+
+PacketRecorder::~PacketRecorder() { close(); }
+
+bool PacketRecorder::open(std::string const &path) {
+  close();
+
+  _file = std::fopen(path.c_str(), "wb");
+  if (_file == nullptr) {
+    DS2LOG(Error, "unable to open %s for recording: %s", path.c_str(),
+           strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+void PacketRecorder::close() {
+  if (_file != nullptr) {
+    std::fclose(_file);
+    _file = nullptr;
+  }
+}
+
+void PacketRecorder::record(std::string const &packet) {
+  if (_file == nullptr)
+    return;
+
+  std::fprintf(_file, "%zu:", packet.size());
+  std::fwrite(packet.data(), 1, packet.size(), _file);
+  std::fputc('\n', _file);
+  // Sessions usually end with the process being killed, don't lose the tail.
+  std::fflush(_file);
+}
+
+bool PacketRecorder::Load(std::string const &path,
+                          std::vector<std::string> &packets) {
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    DS2LOG(Error, "unable to open %s: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  bool success = true;
+  size_t length;
+  while (std::fscanf(file, "%zu:", &length) == 1) {
+    std::string packet(length, '\0');
+    if ((length > 0 && std::fread(&packet[0], 1, length, file) != length) ||
+        std::fgetc(file) != '\n') {
+      DS2LOG(Error, "%s: truncated packet #%zu", path.c_str(), packets.size());
+      success = false;
+      break;
+    }
+    packets.push_back(std::move(packet));
+  }
+
+  if (success && !std::feof(file)) {
+    DS2LOG(Error, "%s: malformed packet #%zu", path.c_str(), packets.size());
+    success = false;
+  }
+
+  std::fclose(file);
+  return success;
+}
+} // namespace GDBRemote
+} // namespace ds2
@@ -14,7 +14,20 @@
 #include "DebugServer2/Host/ProcessSpawner.h"
 #include "DebugServer2/Utils/Log.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
+#if defined(OS_POSIX)
+#include <cerrno>
+#include <csignal>
+#include <sys/wait.h>
+#endif
 
 using ds2::Host::Platform;
 using ds2::Host::ProcessSpawner;
@@ -95,14 +108,9 @@ ErrorCode PlatformSessionImplBase::onQueryGroupName(Session &,
     return kSuccess;
 }
 
-ErrorCode PlatformSessionImplBase::onLaunchDebugServer(Session &session,
-                                                       std::string const &host,
-                                                       uint16_t &port,
-                                                       ProcessId &pid) {
-  ProcessSpawner ps;
+static StringCollection DebugServerArguments() {
   StringCollection args;
 
-  ps.setExecutable(Platform::GetSelfExecutablePath());
   args.push_back("slave");
   if (GetLogLevel() == kLogLevelDebug) {
     args.push_back("--debug");
@@ -117,7 +125,15 @@ ErrorCode PlatformSessionImplBase::onLaunchDebugServer(Session &session,
 #if defined(OS_POSIX)
   args.push_back("--setsid");
 #endif
-  ps.setArguments(args);
+
+  return args;
+}
+
+static ErrorCode SpawnDebugServer(uint16_t &port, ProcessId &pid) {
+  ProcessSpawner ps;
+
+  ps.setExecutable(Platform::GetSelfExecutablePath());
+  ps.setArguments(DebugServerArguments());
   ps.redirectInputToNull();
   ps.redirectOutputToBuffer();
 
@@ -139,6 +155,225 @@ ErrorCode PlatformSessionImplBase::onLaunchDebugServer(Session &session,
   return kSuccess;
 }
 
+namespace {
+
+// How long a pooled debug server gets to report its port.
+static std::chrono::seconds const kPooledServerTimeout(10);
+
+// A slave debug server is ready to be used as soon as it printed its port:
+// it sits in accept() on a socket that is already bound. Spawning them ahead
+// of time hides exec, dynamic loading and socket setup from the client.
+//
+// Unlike the ones spawned on demand, pooled servers don't fork: they stay
+// our children until we reap them, so their pid can't be reused by another
+// process while we check on them.
+class DebugServerPool {
+private:
+  struct Server {
+    std::unique_ptr<ProcessSpawner> spawner;
+    uint16_t port;
+  };
+
+private:
+  std::mutex _lock;
+  std::deque<Server> _ready;
+  // Servers that were handed out, reaped once they exit.
+  std::vector<std::unique_ptr<ProcessSpawner>> _running;
+  std::thread _refiller;
+  size_t _size;
+  bool _refilling;
+  bool _stopping;
+
+public:
+  DebugServerPool() : _size(0), _refilling(false), _stopping(false) {}
+
+  ~DebugServerPool() {
+    std::thread refiller;
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      _stopping = true;
+      refiller = std::move(_refiller);
+    }
+
+    if (refiller.joinable()) {
+      refiller.join();
+    }
+
+    // Nobody is going to connect to these anymore.
+    for (auto &server : _ready) {
+#if defined(OS_POSIX)
+      ::kill(server.spawner->pid(), SIGKILL);
+#endif
+      server.spawner->wait();
+    }
+  }
+
+public:
+  void setSize(size_t size) {
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      _size = size;
+    }
+    refill();
+  }
+
+  ErrorCode acquire(uint16_t &port, ProcessId &pid) {
+    bool found = false;
+
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      reap();
+
+      while (!found && !_ready.empty()) {
+        Server server = std::move(_ready.front());
+        _ready.pop_front();
+        // Skip servers that were killed while waiting in the pool.
+        if (!IsRunning(*server.spawner)) {
+          DS2LOG(Debug, "pooled debug server %" PRI_PID " is gone",
+                 server.spawner->pid());
+          continue;
+        }
+        port = server.port;
+        pid = server.spawner->pid();
+        _running.push_back(std::move(server.spawner));
+        found = true;
+      }
+    }
+
+    refill();
+
+    if (found) {
+      DS2LOG(Debug, "using pooled debug server %" PRI_PID " on port %u", pid,
+             port);
+      return kSuccess;
+    }
+
+    return SpawnDebugServer(port, pid);
+  }
+
+private:
+  // Reaps the server if it exited.
+  static bool IsRunning(ProcessSpawner const &spawner) {
+#if defined(OS_POSIX)
+    int status;
+    pid_t ret;
+    do {
+      ret = ::waitpid(spawner.pid(), &status, WNOHANG);
+    } while (ret < 0 && errno == EINTR);
+    return ret == 0;
+#else
+    return spawner.isRunning();
+#endif
+  }
+
+  static ErrorCode Spawn(Server &server) {
+    struct Output {
+      std::mutex lock;
+      std::condition_variable cv;
+      std::string data;
+    };
+
+    // The redirection thread may outlive this function if the server never
+    // reports its port.
+    auto output = std::make_shared<Output>();
+    auto spawner = ds2::make_unique<ProcessSpawner>();
+
+    StringCollection args = DebugServerArguments();
+    args.push_back("--no-fork");
+    spawner->setExecutable(Platform::GetSelfExecutablePath());
+    spawner->setArguments(args);
+    spawner->redirectInputToNull();
+    spawner->redirectOutputToDelegate([output](void *buf, size_t size) {
+      std::lock_guard<std::mutex> guard(output->lock);
+      output->data.append(static_cast<char *>(buf), size);
+      output->cv.notify_one();
+    });
+
+    CHK(spawner->run());
+
+    std::istringstream ss;
+    {
+      std::unique_lock<std::mutex> guard(output->lock);
+      if (!output->cv.wait_for(guard, kPooledServerTimeout, [&output]() {
+            return output->data.find('\n') != std::string::npos;
+          })) {
+        guard.unlock();
+#if defined(OS_POSIX)
+        ::kill(spawner->pid(), SIGKILL);
+#endif
+        spawner->wait();
+        return kErrorProcessNotFound;
+      }
+      ss.str(output->data);
+    }
+
+    ProcessId pid;
+    ss >> server.port >> pid;
+    server.spawner = std::move(spawner);
+    return kSuccess;
+  }
+
+  void reap() {
+    auto exited = [](std::unique_ptr<ProcessSpawner> const &spawner) {
+      return !IsRunning(*spawner);
+    };
+    _running.erase(std::remove_if(_running.begin(), _running.end(), exited),
+                   _running.end());
+  }
+
+  void refill() {
+    std::lock_guard<std::mutex> guard(_lock);
+    if (_stopping || _refilling || _ready.size() >= _size) {
+      return;
+    }
+
+    // The previous refill is over, its thread is exiting.
+    if (_refiller.joinable()) {
+      _refiller.join();
+    }
+
+    _refilling = true;
+    _refiller = std::thread(&DebugServerPool::refillThread, this);
+  }
+
+  void refillThread() {
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (_stopping || _ready.size() >= _size) {
+          _refilling = false;
+          return;
+        }
+      }
+
+      Server server;
+      if (Spawn(server) != kSuccess) {
+        DS2LOG(Warning, "unable to spawn debug server for the pool");
+        std::lock_guard<std::mutex> guard(_lock);
+        _refilling = false;
+        return;
+      }
+
+      std::lock_guard<std::mutex> guard(_lock);
+      _ready.push_back(std::move(server));
+    }
+  }
+};
+
+DebugServerPool sDebugServerPool;
+} // namespace
+
+void PlatformSessionImplBase::SetDebugServerPoolSize(size_t size) {
+  sDebugServerPool.setSize(size);
+}
+
+ErrorCode PlatformSessionImplBase::onLaunchDebugServer(Session &session,
+                                                       std::string const &host,
+                                                       uint16_t &port,
+                                                       ProcessId &pid) {
+  return sDebugServerPool.acquire(port, pid);
+}
+
 void PlatformSessionImplBase::updateProcesses(
     ProcessInfoMatch const &match) const {
   // TODO(fjricci) we should only add processes that match "match"
@@ -15,30 +15,14 @@
 
 #include <algorithm>
 #include <cstring>
-#include <iomanip>
-#include <sstream>
 
 namespace ds2 {
 namespace GDBRemote {
 
-static std::string EscapeForTerm(std::string const &s) {
-  std::ostringstream ss;
-  for (char n : s) {
-    unsigned c = static_cast<unsigned>(n & 0xff);
-    if (c < 0x20 || c > 0x7f) {
-      ss << "\\x" << std::hex << std::setw(2) << std::setfill('0') << c
-         << std::dec;
-    } else {
-      ss << n;
-    }
-  }
-  return ss.str();
-}
-
 ProtocolInterpreter::ProtocolInterpreter() : _session(nullptr) {}
 
 void ProtocolInterpreter::onPacketData(std::string const &data, bool valid) {
-  DS2LOG(Packet, "getpkt(\"%s\")", EscapeForTerm(&data[0]).c_str());
+  DS2LOG(Packet, "getpkt(\"%s\")", data.c_str());
 
   if (_session == nullptr)
     return;
@@ -106,6 +90,18 @@ void ProtocolInterpreter::onPacketData(std::string const &data, bool valid) {
     } else {
       command_end = 1;
     }
+  } else if (data[0] == 'M') {
+    //
+    // The only command starting with 'M' that is longer than one char is
+    // MultiMemRead, which is terminated with : (colon).
+    //
+    size_t end = data.find(':');
+    if (end != std::string::npos && data.compare(0, end, "MultiMemRead") == 0) {
+      command_end = end;
+      args_start = end + 1;
+    } else {
+      command_end = 1;
+    }
   } else if (data[0] == 'j') {
     //
     // The commands starting with j are terminated with : (colon)
@@ -152,6 +148,25 @@ void ProtocolInterpreter::onInvalidData(std::string const &data) {
 
 void ProtocolInterpreter::onCommand(std::string const &command,
                                     std::string const &arguments) {
+  if (!_timingCallback) {
+    dispatch(command, arguments);
+    return;
+  }
+
+  size_t commandLength;
+  Handler const *handler = findHandler(command, commandLength);
+
+  auto start = std::chrono::steady_clock::now();
+  dispatch(command, arguments);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  _timingCallback(
+      handler != nullptr ? handler->command : std::string(),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+}
+
+void ProtocolInterpreter::dispatch(std::string const &command,
+                                   std::string const &arguments) {
   size_t commandLength;
   Handler const *handler = findHandler(command, commandLength);
   if (handler == nullptr) {
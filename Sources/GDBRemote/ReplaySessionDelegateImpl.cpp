@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/GDBRemote/ReplaySessionDelegateImpl.h"
+#include "DebugServer2/GDBRemote/Session.h"
+
+#include <csignal>
+
+namespace ds2 {
+namespace GDBRemote {
+
+// Memory reads return the low byte of each address.
+static void FillMemory(uint64_t address, size_t length, ByteVector &data) {
+  data.resize(length);
+  for (size_t n = 0; n < length; n++) {
+    data[n] = static_cast<uint8_t>(address + n);
+  }
+}
+
+ReplaySessionDelegateImpl::ReplaySessionDelegateImpl()
+    : _threadListDone(false) {}
+
+size_t ReplaySessionDelegateImpl::getGPRSize() const { return 64; }
+
+ErrorCode ReplaySessionDelegateImpl::onQuerySupported(
+    Session &, Feature::Collection const &,
+    Feature::Collection &localFeatures) const {
+  localFeatures.push_back(std::string("PacketSize=3fff"));
+  localFeatures.push_back(std::string("QStartNoAckMode+"));
+  localFeatures.push_back(std::string("QListThreadsInStopReply+"));
+  localFeatures.push_back(std::string("MultiMemRead+"));
+  return kSuccess;
+}
+
+ErrorCode ReplaySessionDelegateImpl::onQueryThreadList(
+    Session &, ProcessId, ThreadId lastTid, ProcessThreadId &ptid) const {
+  if (lastTid == kAllThreadId) {
+    _threadListDone = false;
+  } else if (lastTid != kAnyThreadId) {
+    return kErrorInvalidArgument;
+  }
+
+  if (_threadListDone)
+    return kErrorNotFound;
+
+  ptid = ProcessThreadId(kPid, kPid);
+  _threadListDone = true;
+  return kSuccess;
+}
+
+ErrorCode
+ReplaySessionDelegateImpl::onQueryThreadStopInfo(Session &,
+                                                 ProcessThreadId const &,
+                                                 StopInfo &stop) const {
+  fillStopInfo(stop);
+  return kSuccess;
+}
+
+ErrorCode
+ReplaySessionDelegateImpl::onQueryCurrentThread(Session &,
+                                                ProcessThreadId &ptid) const {
+  ptid = ProcessThreadId(kPid, kPid);
+  return kSuccess;
+}
+
+ErrorCode ReplaySessionDelegateImpl::onThreadIsAlive(Session &,
+                                                     ProcessThreadId const &) {
+  return kSuccess;
+}
+
+ErrorCode ReplaySessionDelegateImpl::onResume(
+    Session &, ThreadResumeAction::Collection const &, StopInfo &stop) {
+  fillStopInfo(stop);
+  return kSuccess;
+}
+
+ErrorCode ReplaySessionDelegateImpl::onReadGeneralRegisters(
+    Session &, ProcessThreadId const &,
+    Architecture::GPRegisterValueVector &regs) {
+  regs.clear();
+  for (size_t n = 0; n < kGPRCount; n++) {
+    regs.push_back({sizeof(uint64_t), 0x1000 * n});
+  }
+  return kSuccess;
+}
+
+ErrorCode ReplaySessionDelegateImpl::onWriteGeneralRegisters(
+    Session &, ProcessThreadId const &, std::vector<uint64_t> const &) {
+  return kSuccess;
+}
+
+ErrorCode ReplaySessionDelegateImpl::onReadMemory(Session &,
+                                                  Address const &address,
+                                                  size_t length,
+                                                  ByteVector &data) {
+  FillMemory(address.value(), length, data);
+  return kSuccess;
+}
+
+ErrorCode ReplaySessionDelegateImpl::onReadMemoryRanges(
+    Session &, MemoryRange::Collection const &ranges,
+    std::vector<ByteVector> &data) {
+  data.resize(ranges.size());
+  for (size_t n = 0; n < ranges.size(); n++) {
+    FillMemory(ranges[n].start.value(), ranges[n].length, data[n]);
+  }
+  return kSuccess;
+}
+
+ErrorCode ReplaySessionDelegateImpl::onWriteMemory(Session &, Address const &,
+                                                   ByteVector const &data,
+                                                   size_t &nwritten) {
+  nwritten = data.size();
+  return kSuccess;
+}
+
+void ReplaySessionDelegateImpl::fillStopInfo(StopInfo &stop) const {
+  stop.clear();
+  stop.event = StopInfo::kEventStop;
+  stop.reason = StopInfo::kReasonBreakpoint;
+  stop.signal = SIGTRAP;
+  stop.ptid = ProcessThreadId(kPid, kPid);
+  stop.threads.insert(stop.ptid.tid);
+}
+} // namespace GDBRemote
+} // namespace ds2
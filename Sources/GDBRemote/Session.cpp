@@ -16,6 +16,7 @@
 #include "DebugServer2/Utils/String.h"
 #include "DebugServer2/Utils/SwapEndian.h"
 
+#include <cctype>
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
@@ -79,12 +80,14 @@ Session::Session(CompatibilityMode mode)
   REGISTER_HANDLER_EQUALS_1(_M);
   REGISTER_HANDLER_EQUALS_1(_m);
   REGISTER_HANDLER_EQUALS_1(M);
+  REGISTER_HANDLER_EQUALS_1(MultiMemRead);
   REGISTER_HANDLER_EQUALS_1(m);
   REGISTER_HANDLER_EQUALS_1(P);
   REGISTER_HANDLER_EQUALS_1(p);
   REGISTER_HANDLER_EQUALS_1(QAgent);
   REGISTER_HANDLER_EQUALS_1(QAllow);
   REGISTER_HANDLER_EQUALS_1(QDisableRandomization);
+  REGISTER_HANDLER_EQUALS_1(QEnableCompression);
   REGISTER_HANDLER_EQUALS_1(QEnvironment);
   REGISTER_HANDLER_EQUALS_1(QEnvironmentHexEncoded);
   REGISTER_HANDLER_EQUALS_1(QLaunchArch);
@@ -135,6 +138,7 @@ Session::Session(CompatibilityMode mode)
   REGISTER_HANDLER_EQUALS_1(qProcessInfoPID);
   REGISTER_HANDLER_EQUALS_1(qRcmd);
   REGISTER_HANDLER_STARTS_WITH_1(qRegisterInfo);
+  REGISTER_HANDLER_EQUALS_1(qSaveCore);
   REGISTER_HANDLER_EQUALS_1(qSearch);
   REGISTER_HANDLER_EQUALS_1(qShlibInfoAddr);
   REGISTER_HANDLER_EQUALS_1(qSpeedTest);
@@ -752,6 +756,18 @@ void Session::Handle_H(ProtocolInterpreter::Handler const &,
   //
   CHK_SEND(_delegate->onThreadIsAlive(*this, ptid));
 
+  //
+  // With several inferiors, memory accesses go to the process of the thread
+  // selected for 'g'.
+  //
+  if (command == 'g' && ptid.validPid()) {
+    ErrorCode error = _delegate->onSetCurrentProcess(*this, ptid.pid);
+    if (error != kSuccess && error != kErrorUnsupported) {
+      sendError(error);
+      return;
+    }
+  }
+
   _ptids[command] = ptid;
   sendOK();
 
@@ -958,6 +974,65 @@ void Session::Handle__m(ProtocolInterpreter::Handler const &,
   sendError(_delegate->onDeallocateMemory(*this, address));
 }
 
+//
+// Packet:        MultiMemRead:ranges:addr,length[,addr,length...];
+// Description:   Read several ranges of target memory at once. The reply
+//                lists how many bytes were read from each range, in hex,
+//                followed by a semicolon and the binary data of all the
+//                ranges back to back. A range that can't be read is
+//                reported with a length of zero.
+// Compatibility: LLDB
+//
+void Session::Handle_MultiMemRead(ProtocolInterpreter::Handler const &,
+                                  std::string const &args) {
+  MemoryRange::Collection ranges;
+  bool valid = args.compare(0, 7, "ranges:") == 0;
+
+  if (valid) {
+    std::vector<uint64_t> values;
+    std::string list = args.substr(7);
+    if (!list.empty() && list.back() == ';') {
+      list.pop_back();
+    }
+
+    ParseList(list, ',', [&](std::string const &arg) {
+      char *eptr;
+      values.push_back(std::strtoull(arg.c_str(), &eptr, 16));
+      if (arg.empty() || *eptr != '\0') {
+        valid = false;
+      }
+    });
+
+    valid = valid && !values.empty() && (values.size() % 2) == 0;
+    for (size_t n = 0; valid && n < values.size(); n += 2) {
+      ranges.emplace_back(values[n], values[n + 1]);
+    }
+  }
+
+  if (!valid) {
+    sendError(kErrorInvalidArgument);
+    return;
+  }
+
+  std::vector<ByteVector> data;
+  CHK_SEND(_delegate->onReadMemoryRanges(*this, ranges, data));
+
+  std::ostringstream ss;
+  for (size_t n = 0; n < data.size(); n++) {
+    if (n != 0) {
+      ss << ',';
+    }
+    ss << std::hex << data[n].size();
+  }
+  ss << ';';
+
+  for (auto const &bytes : data) {
+    ss.write(reinterpret_cast<char const *>(bytes.data()), bytes.size());
+  }
+
+  send(ss.str());
+}
+
 //
 // Packet:        M addr,length:XX...
 // Description:   Write to target memory, data is hex encoded.
@@ -1227,6 +1302,36 @@ void Session::Handle_QStartNoAckMode(ProtocolInterpreter::Handler const &,
   sendOK();
 }
 
+//
+// Packet:        QEnableCompression:type:<type>;[minsize:<size>;]
+// Description:   Request that the remote stub compress the packets it
+//                sends from now on, using one of the types advertised in
+//                qSupported. Packets smaller than minsize are sent raw.
+// Compatibility: LLDB
+//
+void Session::Handle_QEnableCompression(ProtocolInterpreter::Handler const &,
+                                        std::string const &args) {
+  CompressionType type = kCompressionTypeNone;
+  size_t minSize = Compression::kDefaultMinSize;
+
+  ParseList(args, ';', [&](std::string const &arg) {
+    if (arg.compare(0, 5, "type:") == 0) {
+      type = Compression::Parse(arg.substr(5));
+    } else if (arg.compare(0, 8, "minsize:") == 0) {
+      minSize = std::strtoul(&arg[8], nullptr, 0);
+    }
+  });
+
+  if (type == kCompressionTypeNone) {
+    sendError(kErrorInvalidArgument);
+    return;
+  }
+
+  // The reply itself is not compressed.
+  sendOK();
+  setCompression(type, minSize);
+}
+
 //
 // Packet:        QSyncThreadState
 // Description:   Do whatever necessary to synchronize the thread
@@ -1430,10 +1535,10 @@ void Session::Handle_QSetEnableAsyncProfiling(
   ParseList(args, ';', [&](std::string const &arg) {
     if (arg.compare(0, 7, "enable:") == 0) {
       enabled = std::strtoul(&arg[7], nullptr, 0) != 0;
-    } else if (arg.compare(0, 9, "scan_type:") == 0) {
-      scanType = std::strtoul(&arg[9], nullptr, 0);
-    } else if (arg.compare(0, 13, "interval_usec:") == 0) {
-      interval = std::strtoul(&arg[13], nullptr, 0);
+    } else if (arg.compare(0, 10, "scan_type:") == 0) {
+      scanType = std::strtoul(&arg[10], nullptr, 0);
+    } else if (arg.compare(0, 14, "interval_usec:") == 0) {
+      interval = std::strtoul(&arg[14], nullptr, 0);
     }
   });
 
@@ -1611,19 +1716,19 @@ void Session::Handle_qGetPid(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_qGetProfileData(ProtocolInterpreter::Handler const &,
                                      std::string const &args) {
-  uint32_t scanType = 0;
+  uint32_t scanType = ProfileData::kScanAll;
 
   ParseList(args, ';', [&](std::string const &arg) {
-    if (arg.compare(0, 9, "scan_type:") == 0) {
-      scanType = std::strtoul(&arg[9], nullptr, 0);
+    if (arg.compare(0, 10, "scan_type:") == 0) {
+      scanType = std::strtoul(&arg[10], nullptr, 0);
     }
   });
 
-  void *TODO;
+  ProfileData data;
   CHK_SEND(
-      _delegate->onQueryProfileData(*this, ProcessThreadId(), scanType, &TODO));
+      _delegate->onQueryProfileData(*this, ProcessThreadId(), scanType, data));
 
-  // send(TODO.encode());
+  send(data.encode(scanType));
 }
 
 //
@@ -1743,9 +1848,9 @@ void Session::Handle_qL(ProtocolInterpreter::Handler const &,
 
   ThreadId next = std::strtoul(&args[2], nullptr, 16);
 
-  ThreadId tid;
+  ProcessThreadId ptid;
   ErrorCode error =
-      _delegate->onQueryThreadList(*this, kAnyProcessId, next, tid);
+      _delegate->onQueryThreadList(*this, kAnyProcessId, next, ptid);
   if (error != kSuccess && error != kErrorNotFound) {
     sendError(error);
     return;
@@ -1762,7 +1867,7 @@ void Session::Handle_qL(ProtocolInterpreter::Handler const &,
     ss << '1'; // count
     ss << '0'; // done
     ss << std::hex << std::setw(8) << std::setfill('0') << next;
-    ss << std::hex << std::setw(8) << std::setfill('0') << tid;
+    ss << std::hex << std::setw(8) << std::setfill('0') << ptid.tid;
   }
 
   send(ss.str());
@@ -2065,6 +2170,31 @@ void Session::Handle_qRegisterInfo(ProtocolInterpreter::Handler const &,
   send(info.encode());
 }
 
+//
+// Packet:        qSaveCore[;path-hint:<hex-encoded-path>]
+// Description:   Writes a core file of the process on the remote system,
+//                preferably at path-hint, and replies with
+//                core-path:<hex-encoded-path>. The debugger then fetches it
+//                with vFile packets, which are compressed like any other
+//                reply once QEnableCompression was sent.
+// Compatibility: LLDB
+//
+void Session::Handle_qSaveCore(ProtocolInterpreter::Handler const &,
+                               std::string const &args) {
+  std::string pathHint;
+
+  ParseList(args, ';', [&](std::string const &arg) {
+    if (arg.compare(0, 10, "path-hint:") == 0) {
+      pathHint = HexToString(arg.substr(10));
+    }
+  });
+
+  std::string path;
+  CHK_SEND(_delegate->onSaveCore(*this, pathHint, path));
+
+  send("core-path:" + ToHex(path));
+}
+
 //
 // Packet:        qSearch:memory:address;length;search-pattern
 // Description:   Search in the memory interval specified the pattern.
@@ -2243,6 +2373,19 @@ void Session::Handle_qSupported(ProtocolInterpreter::Handler const &,
       }
   }
 
+  //
+  // Compression is handled by the session, not by the delegate. Only LLDB
+  // knows about QEnableCompression.
+  //
+  if (mode() == kCompatibilityModeLLDB) {
+    if (!result.empty()) {
+      result += ";";
+    }
+    result += "SupportedCompressions=" + Compression::SupportedTypes();
+    result += ";DefaultCompressionMinSize=" +
+              ds2::Utils::ToString(Compression::kDefaultMinSize);
+  }
+
   send(result);
 }
 
@@ -2562,9 +2705,9 @@ void Session::Handle_qsProcessInfo(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_qfThreadInfo(ProtocolInterpreter::Handler const &,
                                   std::string const &) {
-  ThreadId tid;
+  ProcessThreadId ptid;
   ErrorCode error =
-      _delegate->onQueryThreadList(*this, kAnyProcessId, kAllThreadId, tid);
+      _delegate->onQueryThreadList(*this, kAnyProcessId, kAllThreadId, ptid);
   if (error != kSuccess && error != kErrorNotFound) {
     sendError(error);
     return;
@@ -2574,7 +2717,12 @@ void Session::Handle_qfThreadInfo(ProtocolInterpreter::Handler const &,
     send("l");
   } else {
     std::ostringstream ss;
-    ss << "m" << getPacketSeparator() << std::hex << tid;
+    ss << "m" << getPacketSeparator();
+    if (_compatMode == kCompatibilityModeGDBMultiprocess) {
+      ss << ptid.encode(_compatMode);
+    } else {
+      ss << std::hex << ptid.tid;
+    }
     send(ss.str());
   }
 }
@@ -2586,9 +2734,9 @@ void Session::Handle_qfThreadInfo(ProtocolInterpreter::Handler const &,
 //
 void Session::Handle_qsThreadInfo(ProtocolInterpreter::Handler const &,
                                   std::string const &) {
-  ThreadId tid;
+  ProcessThreadId ptid;
   ErrorCode error =
-      _delegate->onQueryThreadList(*this, kAnyProcessId, kAnyThreadId, tid);
+      _delegate->onQueryThreadList(*this, kAnyProcessId, kAnyThreadId, ptid);
   if (error != kSuccess && error != kErrorNotFound) {
     sendError(error);
     return;
@@ -2598,7 +2746,12 @@ void Session::Handle_qsThreadInfo(ProtocolInterpreter::Handler const &,
     send("l");
   } else {
     std::ostringstream ss;
-    ss << "m" << getPacketSeparator() << std::hex << tid;
+    ss << "m" << getPacketSeparator();
+    if (_compatMode == kCompatibilityModeGDBMultiprocess) {
+      ss << ptid.encode(_compatMode);
+    } else {
+      ss << std::hex << ptid.tid;
+    }
     send(ss.str());
   }
 }
@@ -2870,17 +3023,19 @@ void Session::Handle_vAttachWait(ProtocolInterpreter::Handler const &,
 void Session::Handle_vContQuestionMark(ProtocolInterpreter::Handler const &,
                                        std::string const &) {
   // We support all the actions!
-  send("vCont;t;s;S;c;C;");
+  send("vCont;t;s;S;c;C;r;");
 }
 
 //
 // Packet:        vCont[;action[:thread-id]]...
-// Description:   Resume the inferior
+// Description:   Resume the inferior; the r start,end action steps the thread
+//                until its PC leaves [start, end) and only reports that stop
 // Compatibility: GDB, LLDB
 //
 void Session::Handle_vCont(ProtocolInterpreter::Handler const &,
                            std::string const &args) {
   ThreadResumeAction::Collection actions;
+  bool valid = true;
 
   if (!ParseList(args, ';', [&](std::string const &arg) {
         if (arg.empty())
@@ -2909,19 +3064,37 @@ void Session::Handle_vCont(ProtocolInterpreter::Handler const &,
           action.action = kResumeActionStop;
           action.signal = 0;
           break;
+        case 'r': {
+          char *start = eptr;
+          action.action = kResumeActionRangeStep;
+          action.signal = 0;
+          action.rangeStart = std::strtoull(start, &eptr, 16);
+          if (eptr == start || *eptr++ != ',') {
+            valid = false;
+            return;
+          }
+          char *end = eptr;
+          action.rangeEnd = std::strtoull(end, &eptr, 16);
+          // An empty range would step forever, or stop right away.
+          if (eptr == end || action.rangeEnd <= action.rangeStart) {
+            valid = false;
+            return;
+          }
+        } break;
         default:
-          sendError(kErrorInvalidArgument); // Not supported
+          valid = false; // Not supported
           return;
         }
         if (*eptr++ == ':') {
           if (!action.ptid.parse(eptr, _compatMode)) {
-            sendError(kErrorInvalidArgument); // Not supported
+            valid = false; // Not supported
             return;
           }
         }
 
         actions.push_back(action);
-      })) {
+      }) ||
+      !valid) {
     sendError(kErrorInvalidArgument);
     return;
   }
@@ -3351,10 +3524,75 @@ void Session::Handle_Z(ProtocolInterpreter::Handler const &,
   }
   kind = std::strtoul(eptr, &eptr, 16);
 
-  // TODO: cond_list, cmd_list.
+  //
+  // Conditions and commands are lists of agent expressions, each encoded as
+  // Xlen,bytecode with len the size of the bytecode in bytes. GDB sends the
+  // expressions of a list back to back, so the length of each one tells
+  // where the next one starts; commands follow a cmds:persist, prefix.
+  //
+  StringCollection conditions;
+  StringCollection commands;
+  bool persistentCommands = false;
+  bool inCommands = false;
+  bool valid = true;
+
+  if (*eptr == ';') {
+    char const *ptr = eptr + 1;
+    while (valid && *ptr != '\0') {
+      if (*ptr == ';') {
+        ptr++;
+        continue;
+      }
+
+      if (std::strncmp(ptr, "cmds:", 5) == 0) {
+        inCommands = true;
+        persistentCommands = ptr[5] == '1';
+        ptr = std::strchr(ptr, ',');
+        if (ptr == nullptr) {
+          valid = false;
+          break;
+        }
+        ptr++;
+        continue;
+      }
+
+      if (*ptr != 'X') {
+        valid = false;
+        break;
+      }
+
+      char *lptr;
+      size_t length = std::strtoul(ptr + 1, &lptr, 16);
+      if (lptr == ptr + 1 || *lptr++ != ',') {
+        valid = false;
+        break;
+      }
+
+      // Stops at the terminating NUL if the expression is too short.
+      size_t count = 0;
+      while (count < length * 2 &&
+             std::isxdigit(static_cast<unsigned char>(lptr[count]))) {
+        count++;
+      }
+      if (count != length * 2) {
+        valid = false;
+        break;
+      }
+
+      (inCommands ? commands : conditions)
+          .push_back(HexToString(std::string(lptr, count)));
+      ptr = lptr + count;
+    }
+  }
+
+  if (!valid) {
+    sendError(kErrorInvalidArgument);
+    return;
+  }
+
   sendError(_delegate->onInsertBreakpoint(*this, type, address, kind,
-                                          StringCollection(),
-                                          StringCollection(), false));
+                                          conditions, commands,
+                                          persistentCommands));
 }
 
 //
@@ -20,7 +20,9 @@ namespace ds2 {
 namespace GDBRemote {
 
 SessionBase::SessionBase(CompatibilityMode mode)
-    : _channel(nullptr), _delegate(nullptr), _ackmode(true), _compatMode(mode) {
+    : _channel(nullptr), _recorder(nullptr), _delegate(nullptr),
+      _ackmode(true), _compatMode(mode), _compressionType(kCompressionTypeNone),
+      _compressionMinSize(Compression::kDefaultMinSize) {
   _processor.setDelegate(&_interpreter);
   _interpreter.setSession(this);
 }
@@ -54,6 +56,9 @@ bool SessionBase::receive(bool cooked) {
     // by the Packet Processor, so we just need to forward it
     // to the interpreter.
     //
+    if (_recorder != nullptr) {
+      _recorder->record(data);
+    }
     _interpreter.onPacketData(data, true);
     return true;
   }
@@ -106,6 +111,26 @@ bool SessionBase::sendACK() { return _channel->send("+", 1) == 1; }
 
 bool SessionBase::sendNAK() { return _channel->send("-", 1) == 1; }
 
+//
+// Once compression is enabled every packet body is prefixed: 'N' followed by
+// the packet as-is, or 'C' followed by the uncompressed size, a colon and the
+// escaped compressed data. The checksum covers the prefixed body, so ACK/NAK
+// handling is unchanged.
+//
+std::string SessionBase::compressPayload(std::string const &payload) {
+  std::string compressed;
+
+  if (payload.size() < _compressionMinSize ||
+      !Compression::Compress(_compressionType, payload, compressed) ||
+      compressed.size() >= payload.size()) {
+    return "N" + payload;
+  }
+
+  std::ostringstream ss;
+  ss << 'C' << payload.size() << ':' << Escape(compressed);
+  return ss.str();
+}
+
 // The GDB protocol specifies whitespace in some packets. However,
 // lldb-server does not use this whitespace, and older versions of
 // lldb will fail if it is used. Don't use a separator in lldb mode.
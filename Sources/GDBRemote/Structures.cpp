@@ -262,6 +262,16 @@ std::string StopInfo::encodeInfo(CompatibilityMode mode,
     ss << ';' << key << ':' << val;
   }
 
+  // fork-events and vfork-events are only negotiated in multiprocess mode,
+  // the child is always sent as p<pid>.<tid>.
+  if (reason == StopInfo::kReasonFork || reason == StopInfo::kReasonVFork) {
+    ss << ';' << (reason == StopInfo::kReasonFork ? "fork" : "vfork") << ':'
+       << ProcessThreadId(childPid, childPid)
+              .encode(kCompatibilityModeGDBMultiprocess);
+  } else if (reason == StopInfo::kReasonVForkDone) {
+    ss << ';' << "vforkdone:";
+  }
+
   if (reason == StopInfo::kReasonSignalStop) {
     ss << ';' << "signal:" << signal;
   }
@@ -283,6 +293,23 @@ std::string StopInfo::encodeInfo(CompatibilityMode mode,
         first = false;
       }
     }
+
+    if (!threadPCs.empty()) {
+      ss << ';' << "thread-pcs:";
+      bool first = true;
+      for (auto &pc : threadPCs) {
+        if (!first) {
+          ss << ',';
+        }
+        ss << HEX0 << pc.second;
+        first = false;
+      }
+    }
+  }
+
+  for (auto &block : memory) {
+    ss << ';' << "memory:" << "0x" << HEX0 << block.first << '='
+       << ToHex(block.second);
   }
 
   return ss.str();
@@ -830,5 +857,47 @@ std::string ProgramResult::encode() const {
      << ',' << Escape(output);
   return ss.str();
 }
+
+//
+// Encodes profile data in the format debugserver uses, which LLDB expects
+// either as the reply to qGetProfileData, or as the payload of an
+// asynchronous `A' packet when profiling is enabled.
+//
+std::string ProfileData::encode(uint32_t scanType) const {
+  std::ostringstream ss;
+
+  if (scanType & kScanHostCPU) {
+    ss << "num_cpu:" << DEC << cpuCount << ';';
+  }
+
+  ss << "elapsed_usec:" << DEC << timestamp << ';';
+
+  if (scanType & kScanCPU) {
+    ss << "task_used_usec:" << DEC << cpuTime << ';';
+  }
+
+  if (scanType & kScanThreadsCPU) {
+    for (auto const &thread : threads) {
+      ss << "thread_used_id:" << HEX0 << thread.tid << ';';
+      ss << "thread_used_usec:" << DEC << thread.cpuTime << ';';
+      if ((scanType & kScanThreadName) && !thread.name.empty()) {
+        ss << "thread_used_name:" << ToHex(thread.name) << ';';
+      }
+    }
+  }
+
+  if (scanType & kScanHostMemory) {
+    ss << "total:" << DEC << hostMemory << ';';
+  }
+
+  if (scanType & kScanMemory) {
+    ss << "mem_virtual:" << DEC << virtualMemory << ';';
+    ss << "mem_resident:" << DEC << residentMemory << ';';
+    ss << "mem_shared:" << DEC << sharedMemory << ';';
+  }
+
+  ss << "--end--;";
+  return ss.str();
+}
 } // namespace GDBRemote
 } // namespace ds2
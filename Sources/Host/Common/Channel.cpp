@@ -41,5 +41,9 @@ bool Channel::receive(std::string &buffer) {
   buffer.resize(total);
   return !buffer.empty();
 }
+
+void Channel::cork() {}
+
+bool Channel::uncork() { return true; }
 } // namespace Host
 } // namespace ds2
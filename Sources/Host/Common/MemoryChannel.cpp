@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Host/MemoryChannel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace ds2 {
+namespace Host {
+
+MemoryChannel::MemoryChannel()
+    : _sentBytes(0), _sentMessages(0), _closed(false) {}
+
+void MemoryChannel::close() {
+  _closed = true;
+  _input.clear();
+}
+
+bool MemoryChannel::connected() const { return !_closed; }
+
+// There is nobody to wait for: either a message is queued or none ever will
+// be.
+bool MemoryChannel::wait(int) { return connected() && !_input.empty(); }
+
+ssize_t MemoryChannel::send(void const *buffer, size_t length) {
+  if (!connected())
+    return -1;
+
+  _lastSent.assign(static_cast<char const *>(buffer), length);
+  _sentBytes += length;
+  _sentMessages++;
+  return length;
+}
+
+ssize_t MemoryChannel::receive(void *buffer, size_t length) {
+  if (!connected() || _input.empty())
+    return 0;
+
+  std::string &front = _input.front();
+  length = std::min(length, front.size());
+  std::memcpy(buffer, front.data(), length);
+
+  if (length == front.size()) {
+    _input.pop_front();
+  } else {
+    front.erase(0, length);
+  }
+  return length;
+}
+
+bool MemoryChannel::receive(std::string &buffer) {
+  if (!connected() || _input.empty())
+    return false;
+
+  buffer = std::move(_input.front());
+  _input.pop_front();
+  return true;
+}
+} // namespace Host
+} // namespace ds2
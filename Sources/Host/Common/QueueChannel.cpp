@@ -66,5 +66,17 @@ bool QueueChannel::receive(std::string &buffer) {
   buffer = _queue.get(0);
   return true;
 }
+
+void QueueChannel::cork() {
+  if (connected())
+    _remote->cork();
+}
+
+bool QueueChannel::uncork() {
+  if (!connected())
+    return false;
+
+  return _remote->uncork();
+}
 } // namespace Host
 } // namespace ds2
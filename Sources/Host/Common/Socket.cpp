@@ -22,6 +22,7 @@
 #define SOCK_ERRNO WSAGetLastError()
 #define SOCK_WOULDBLOCK WSAEWOULDBLOCK
 #define SOCK_NAMETOOLONG WSAENAMETOOLONG
+#define SOCK_TIMEDOUT WSAETIMEDOUT
 #define SOCK_ERRNO_STRINGIFY Stringify::WSAError
 #elif defined(OS_POSIX)
 #include <arpa/inet.h>
@@ -29,12 +30,16 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 #define SOCK_ERRNO errno
 #define SOCK_WOULDBLOCK EAGAIN
 #define SOCK_NAMETOOLONG ENAMETOOLONG
+#define SOCK_TIMEDOUT ETIMEDOUT
 #define SOCK_ERRNO_STRINGIFY Stringify::Errno
 #endif
 
@@ -47,15 +52,35 @@ using ds2::Utils::Stringify;
 namespace ds2 {
 namespace Host {
 
+// Maximum number of queued buffers written with a single syscall.
+static size_t const kMaxSendBuffers = 64;
+
+// How long a send waits for a peer that doesn't read before giving up on the
+// connection. Sends hold _sendMutex while waiting.
+static int const kSendTimeoutMs = 30 * 1000;
+
+#if defined(OS_POSIX) && !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
 Socket::Socket()
-    : _handle(INVALID_SOCKET), _state(State::Invalid), _lastError(0) {}
+    : _handle(INVALID_SOCKET), _state(State::Invalid), _lastError(0),
+      _outboundOffset(0), _corkDepth(0) {}
 
 Socket::Socket(SOCKET handle)
-    : _handle(handle), _state(State::Connected), _lastError(0) {
+    : _handle(handle), _state(State::Connected), _lastError(0),
+      _outboundOffset(0), _corkDepth(0) {
 #if defined(OS_POSIX)
   ::fcntl(_handle, F_SETFD, FD_CLOEXEC);
   ::fcntl(_handle, F_SETFL, O_NONBLOCK);
 #endif
+
+  // Accepted sockets can also come from a UNIX-domain listener.
+  struct sockaddr_storage ss;
+  if (getSocketInfo(&ss) &&
+      (ss.ss_family == AF_INET || ss.ss_family == AF_INET6)) {
+    setNoDelay(true);
+  }
 }
 
 Socket::~Socket() { close(); }
@@ -96,6 +121,11 @@ bool Socket::create(int af) {
 }
 
 void Socket::close() {
+  std::lock_guard<std::mutex> guard(_sendMutex);
+  closeHandle();
+}
+
+void Socket::closeHandle() {
   if (!valid()) {
     return;
   }
@@ -111,7 +141,8 @@ void Socket::close() {
   _lastError = 0;
 }
 
-bool Socket::listen(std::string const &address, std::string const &port) {
+bool Socket::listen(std::string const &address, std::string const &port,
+                    int backlog) {
   if (listening() || connected()) {
     return false;
   }
@@ -173,7 +204,7 @@ bool Socket::listen(std::string const &address, std::string const &port) {
     return false;
   }
 
-  if (::listen(_handle, 1) < 0) {
+  if (::listen(_handle, backlog) < 0) {
     _lastError = SOCK_ERRNO;
     return false;
   }
@@ -183,7 +214,7 @@ bool Socket::listen(std::string const &address, std::string const &port) {
 }
 
 #if defined(OS_POSIX)
-bool Socket::listen(std::string const &path, bool abstract) {
+bool Socket::listen(std::string const &path, bool abstract, int backlog) {
 #if !defined(OS_LINUX)
   // Abstract UNIX sockets are supported only on Linux.
   DS2ASSERT(!abstract);
@@ -227,7 +258,7 @@ bool Socket::listen(std::string const &path, bool abstract) {
     return false;
   }
 
-  if (::listen(_handle, 1) < 0) {
+  if (::listen(_handle, backlog) < 0) {
     _lastError = SOCK_ERRNO;
     return false;
   }
@@ -304,6 +335,7 @@ bool Socket::connect(std::string const &host, std::string const &port) {
 
   _state = State::Connected;
   setNonBlocking();
+  setNoDelay(true);
 
   return true;
 }
@@ -329,22 +361,157 @@ bool Socket::setNonBlocking() {
   return true;
 }
 
+bool Socket::setNoDelay(bool enable) {
+  if (!connected()) {
+    return false;
+  }
+
+  int value = enable ? 1 : 0;
+  if (::setsockopt(_handle, IPPROTO_TCP, TCP_NODELAY,
+                   reinterpret_cast<char *>(&value), sizeof(value)) != 0) {
+    _lastError = SOCK_ERRNO;
+    return false;
+  }
+  return true;
+}
+
+//
+// send() never writes partially: data is queued and written out in order,
+// waiting for the socket to become writable when the peer is slow to read.
+// It fails when the connection is gone or the peer stops reading, and the
+// socket is closed in both cases.
+//
 ssize_t Socket::send(void const *buffer, size_t length) {
   if (!connected()) {
     return -1;
   }
 
-  ssize_t nsent =
-      ::send(_handle, reinterpret_cast<const char *>(buffer), length, 0);
-  if (nsent < 0) {
-    int err = SOCK_ERRNO;
-    if (err != SOCK_WOULDBLOCK) {
-      close();
+  std::lock_guard<std::mutex> guard(_sendMutex);
+  _outbound.emplace_back(static_cast<char const *>(buffer), length);
+
+  if (_corkDepth == 0 && !flushOutbound()) {
+    return -1;
+  }
+  return length;
+}
+
+void Socket::cork() {
+  std::lock_guard<std::mutex> guard(_sendMutex);
+  _corkDepth++;
+}
+
+bool Socket::uncork() {
+  std::lock_guard<std::mutex> guard(_sendMutex);
+  if (_corkDepth > 0 && --_corkDepth > 0) {
+    return true;
+  }
+
+  return flushOutbound();
+}
+
+bool Socket::flushOutbound() {
+  while (!_outbound.empty()) {
+    if (!connected()) {
+      _outbound.clear();
+      _outboundOffset = 0;
+      return false;
+    }
+
+    ssize_t nsent = writeOutbound();
+    if (nsent < 0) {
+      int err = SOCK_ERRNO;
+#if defined(OS_POSIX)
+      if (err == EINTR) {
+        continue;
+      }
+#endif
+      if (err == SOCK_WOULDBLOCK) {
+        if (waitWritable()) {
+          continue;
+        }
+        err = SOCK_TIMEDOUT;
+      }
+
+      DS2LOG(Warning, "dropping %zu queued buffers, errno=%s",
+             _outbound.size(), SOCK_ERRNO_STRINGIFY(err));
+      closeHandle();
       _lastError = err;
+      continue;
     }
+
+    // Drop what has been written, remembering how far we got into the first
+    // buffer that was only partially written.
+    size_t remaining = nsent;
+    while (!_outbound.empty() &&
+           _outbound.front().size() - _outboundOffset <= remaining) {
+      remaining -= _outbound.front().size() - _outboundOffset;
+      _outbound.pop_front();
+      _outboundOffset = 0;
+    }
+    _outboundOffset += remaining;
+  }
+
+  return true;
+}
+
+ssize_t Socket::writeOutbound() {
+  size_t count = std::min(_outbound.size(), kMaxSendBuffers);
+
+#if defined(OS_WIN32)
+  WSABUF buffers[kMaxSendBuffers];
+  for (size_t n = 0; n < count; n++) {
+    size_t offset = (n == 0) ? _outboundOffset : 0;
+    buffers[n].buf = const_cast<char *>(_outbound[n].data()) + offset;
+    buffers[n].len = static_cast<ULONG>(_outbound[n].size() - offset);
+  }
+
+  DWORD nsent;
+  if (::WSASend(_handle, buffers, static_cast<DWORD>(count), &nsent, 0,
+                nullptr, nullptr) == SOCKET_ERROR) {
     return -1;
   }
   return nsent;
+#else
+  struct iovec buffers[kMaxSendBuffers];
+  for (size_t n = 0; n < count; n++) {
+    size_t offset = (n == 0) ? _outboundOffset : 0;
+    buffers[n].iov_base = const_cast<char *>(_outbound[n].data()) + offset;
+    buffers[n].iov_len = _outbound[n].size() - offset;
+  }
+
+  // A peer that went away must not kill us with SIGPIPE.
+  struct msghdr msg;
+  ::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = buffers;
+  msg.msg_iovlen = count;
+  return ::sendmsg(_handle, &msg, MSG_NOSIGNAL);
+#endif
+}
+
+bool Socket::waitWritable() {
+#if defined(OS_WIN32)
+  fd_set fds;
+  FD_ZERO(&fds);
+  FD_SET(_handle, &fds);
+  struct timeval tv;
+  tv.tv_sec = kSendTimeoutMs / 1000;
+  tv.tv_usec = (kSendTimeoutMs % 1000) * 1000;
+  return ::select(_handle + 1, nullptr, &fds, nullptr, &tv) == 1;
+#else
+  struct pollfd pfd;
+  pfd.fd = _handle;
+  pfd.events = POLLOUT;
+
+  // Restarting after EINTR may extend the wait; that's fine for a timeout
+  // this coarse.
+  int nfds;
+  do {
+    nfds = ::poll(&pfd, 1, kSendTimeoutMs);
+  } while (nfds < 0 && errno == EINTR);
+
+  // On POLLERR/POLLHUP, the next write reports the actual error.
+  return nfds == 1;
+#endif
 }
 
 ssize_t Socket::receive(void *buffer, size_t length) {
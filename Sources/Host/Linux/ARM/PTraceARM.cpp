@@ -119,7 +119,7 @@ ErrorCode PTrace::writeCPUState(ProcessThreadId const &ptid,
   return kSuccess;
 }
 
-ErrorCode PTrace::writeStoppoint(ProcessThreadId const &ptid, size_t idx,
+ErrorCode PTrace::writeStoppoint(ProcessThreadId const &ptid, int idx,
                                  uint32_t *val) {
   pid_t pid;
   CHK(ptidToPid(ptid, pid));
@@ -130,34 +130,44 @@ ErrorCode PTrace::writeStoppoint(ProcessThreadId const &ptid, size_t idx,
   return kSuccess;
 }
 
+//
+// The kernel validates the address against the length held in the control
+// register, and the other way around, on every write. Slots are disabled with
+// a null address, which is valid for any length; that is why the control
+// register goes first when a slot gets enabled.
+//
 ErrorCode PTrace::writeHardwareBreakpoint(ProcessThreadId const &ptid,
-                                          uint32_t addr, uint32_t ctrl,
+                                          uint64_t addr, uint32_t ctrl,
                                           size_t idx) {
-  ErrorCode error;
-
-  error = writeStoppoint(ptid, (idx << 1) + 1, &addr);
-  if (error != kSuccess)
-    return error;
-
-  error = writeStoppoint(ptid, (idx << 1) + 2, &ctrl);
-  if (error != kSuccess)
-    return error;
+  uint32_t addr32 = addr;
+  int addrIdx = (idx << 1) + 1;
+  int ctrlIdx = (idx << 1) + 2;
+
+  if (ctrl & 1) {
+    CHK(writeStoppoint(ptid, ctrlIdx, &ctrl));
+    CHK(writeStoppoint(ptid, addrIdx, &addr32));
+  } else {
+    CHK(writeStoppoint(ptid, addrIdx, &addr32));
+    CHK(writeStoppoint(ptid, ctrlIdx, &ctrl));
+  }
 
   return kSuccess;
 }
 
 ErrorCode PTrace::writeHardwareWatchpoint(ProcessThreadId const &ptid,
-                                          uint32_t addr, uint32_t ctrl,
+                                          uint64_t addr, uint32_t ctrl,
                                           size_t idx) {
-  ErrorCode error;
-
-  error = writeStoppoint(ptid, -((idx << 1) + 1), &addr);
-  if (error != kSuccess)
-    return error;
-
-  error = writeStoppoint(ptid, -((idx << 1) + 2), &ctrl);
-  if (error != kSuccess)
-    return error;
+  uint32_t addr32 = addr;
+  int addrIdx = -((idx << 1) + 1);
+  int ctrlIdx = -((idx << 1) + 2);
+
+  if (ctrl & 1) {
+    CHK(writeStoppoint(ptid, ctrlIdx, &ctrl));
+    CHK(writeStoppoint(ptid, addrIdx, &addr32));
+  } else {
+    CHK(writeStoppoint(ptid, addrIdx, &addr32));
+    CHK(writeStoppoint(ptid, ctrlIdx, &ctrl));
+  }
 
   return kSuccess;
 }
@@ -13,6 +13,7 @@
 #include "DebugServer2/Host/Platform.h"
 
 #include <asm/ptrace.h>
+#include <cstddef>
 #include <elf.h>
 #include <sys/ptrace.h>
 #include <sys/uio.h>
@@ -50,6 +51,42 @@ int PTrace::getMaxHardwareWatchpoints(ProcessThreadId const &ptid) {
   return getMaxStoppoints(ptid, NT_ARM_HW_WATCH);
 }
 
+int PTrace::getMaxWatchpointSize(ProcessThreadId const &ptid) {
+  // AArch64 watchpoints cover up to 8 bytes in a doubleword-aligned block.
+  return 8;
+}
+
+ErrorCode PTrace::writeStoppoint(ProcessThreadId const &ptid, int regSet,
+                                 uint64_t addr, uint32_t ctrl, size_t idx) {
+  struct user_hwdebug_state drs;
+  CHK(readRegisterSet(ptid, regSet, &drs, sizeof(drs)));
+
+  if (idx >= (drs.dbg_info & 0xff)) {
+    return kErrorInvalidArgument;
+  }
+
+  drs.dbg_regs[idx].addr = addr;
+  drs.dbg_regs[idx].ctrl = ctrl;
+
+  // The kernel reprograms every slot included in the buffer; stop at the one
+  // we changed.
+  size_t length = offsetof(struct user_hwdebug_state, dbg_regs) +
+                  (idx + 1) * sizeof(drs.dbg_regs[0]);
+  return writeRegisterSet(ptid, regSet, &drs, length);
+}
+
+ErrorCode PTrace::writeHardwareBreakpoint(ProcessThreadId const &ptid,
+                                          uint64_t addr, uint32_t ctrl,
+                                          size_t idx) {
+  return writeStoppoint(ptid, NT_ARM_HW_BREAK, addr, ctrl, idx);
+}
+
+ErrorCode PTrace::writeHardwareWatchpoint(ProcessThreadId const &ptid,
+                                          uint64_t addr, uint32_t ctrl,
+                                          size_t idx) {
+  return writeStoppoint(ptid, NT_ARM_HW_WATCH, addr, ctrl, idx);
+}
+
 ErrorCode PTrace::readCPUState(ProcessThreadId const &ptid,
                                ProcessInfo const &pinfo,
                                Architecture::CPUState &state) {
@@ -28,6 +28,12 @@ namespace ds2 {
 namespace Host {
 namespace Linux {
 
+// Trace clone events to track threads, and fork events so that children
+// don't run off with our breakpoints inserted.
+static unsigned long const kTraceOptions =
+    PTRACE_O_TRACECLONE | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK |
+    PTRACE_O_TRACEVFORKDONE;
+
 ErrorCode PTrace::wait(ProcessThreadId const &ptid, int *status) {
   pid_t pid;
   CHK(ptidToPid(ptid, pid));
@@ -61,17 +67,44 @@ ErrorCode PTrace::traceThat(ProcessId pid) {
   if (pid <= 0)
     return kErrorInvalidArgument;
 
-  unsigned long traceFlags = PTRACE_O_TRACECLONE;
+  if (wrapPtrace(PTRACE_SETOPTIONS, pid, nullptr, kTraceOptions) < 0) {
+    DS2LOG(Warning, "unable to set trace options on pid %d, error=%s", pid,
+           strerror(errno));
+    return Platform::TranslateError();
+  }
+
+  return kSuccess;
+}
+
+ErrorCode PTrace::attach(ProcessId pid) {
+  if (pid <= kAnyProcessId)
+    return kErrorProcessNotFound;
+
+  DS2LOG(Debug, "seizing pid %" PRIu64, (uint64_t)pid);
 
-  //
-  // Trace clone and exit events to track threads.
-  //
-  if (wrapPtrace(PTRACE_SETOPTIONS, pid, nullptr, traceFlags) < 0) {
-    DS2LOG(Warning, "unable to set PTRACE_O_TRACECLONE on pid %d, error=%s",
-           pid, strerror(errno));
+  if (wrapPtrace(PTRACE_SEIZE, pid, nullptr, kTraceOptions) < 0) {
+    // PTRACE_SEIZE is only available since Linux 3.4.
+    if (errno == EIO)
+      return super::attach(pid);
     return Platform::TranslateError();
   }
 
+  ErrorCode error = interrupt(pid);
+  if (error != kSuccess) {
+    wrapPtrace(PTRACE_DETACH, pid, nullptr, nullptr);
+    return error;
+  }
+
+  return kSuccess;
+}
+
+ErrorCode PTrace::interrupt(ProcessThreadId const &ptid) {
+  pid_t pid;
+  CHK(ptidToPid(ptid, pid));
+
+  if (wrapPtrace(PTRACE_INTERRUPT, pid, nullptr, nullptr) < 0)
+    return Platform::TranslateError();
+
   return kSuccess;
 }
 
@@ -249,6 +282,16 @@ ErrorCode PTrace::prepareAddressForResume(ProcessThreadId const &ptid,
   return kSuccess;
 }
 
+#if !defined(ARCH_X86) && !defined(ARCH_X86_64)
+ErrorCode PTrace::writeCPUState(ProcessThreadId const &ptid,
+                                ProcessInfo const &pinfo,
+                                Architecture::CPUState const &state,
+                                Architecture::CPUState const &) {
+  // No per-set tracking on these architectures yet, write everything.
+  return writeCPUState(ptid, pinfo, state);
+}
+#endif
+
 ErrorCode PTrace::step(ProcessThreadId const &ptid, ProcessInfo const &pinfo,
                        int signal, Address const &address) {
 #if defined(ARCH_ARM)
@@ -309,6 +352,18 @@ ErrorCode PTrace::readRegisterSet(ProcessThreadId const &ptid, int regSetCode,
   return kSuccess;
 }
 
+ErrorCode PTrace::readRegisterSetData(ProcessThreadId const &ptid,
+                                      int regSetCode, ByteVector &data) {
+  struct iovec iov = {data.data(), data.size()};
+
+  if (wrapPtrace(PTRACE_GETREGSET, ptid.validTid() ? ptid.tid : ptid.pid,
+                 regSetCode, &iov) < 0)
+    return Platform::TranslateError();
+
+  data.resize(iov.iov_len);
+  return kSuccess;
+}
+
 ErrorCode PTrace::writeRegisterSet(ProcessThreadId const &ptid, int regSetCode,
                                    void const *buffer, size_t length) {
   struct iovec iov = {const_cast<void *>(buffer), length};
@@ -16,12 +16,15 @@
 #include "DebugServer2/Utils/Log.h"
 #include "DebugServer2/Utils/String.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cerrno>
+#include <cinttypes>
 #include <cstdlib>
 #include <cstring>
 #include <elf.h>
 #include <libgen.h>
+#include <sys/syscall.h>
 
 using ds2::CPUType;
 using ds2::Support::ELFSupport;
@@ -541,6 +544,44 @@ bool ProcFS::ReadProcessIds(pid_t pid, pid_t &ppid, uid_t &uid, uid_t &euid,
   return true;
 }
 
+bool ProcFS::ReadStatm(pid_t pid, Statm &statm) {
+  FILE *fp = OpenFILE(pid, "statm");
+  if (fp == nullptr)
+    return false;
+
+  int nread = std::fscanf(fp,
+                          "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+                          " %" SCNu64 " %" SCNu64 " %" SCNu64,
+                          &statm.size, &statm.resident, &statm.shared,
+                          &statm.text, &statm.lib, &statm.data, &statm.dt);
+  std::fclose(fp);
+
+  return nread == 7;
+}
+
+bool ProcFS::ReadThreadCPUTime(pid_t pid, pid_t tid, uint64_t &usec) {
+  // schedstat has the time spent on the CPU in nanoseconds, stat only has it
+  // in clock ticks, which are usually 10ms.
+  FILE *fp = OpenFILE(pid, tid, "schedstat");
+  if (fp != nullptr) {
+    uint64_t nsec;
+    int nread = std::fscanf(fp, "%" SCNu64, &nsec);
+    std::fclose(fp);
+    if (nread == 1) {
+      usec = nsec / 1000;
+      return true;
+    }
+  }
+
+  Stat stat;
+  if (!ReadStat(pid, tid, stat))
+    return false;
+
+  static long const ticksPerSecond = ::sysconf(_SC_CLK_TCK);
+  usec = (stat.utime + stat.stime) * 1000000 / ticksPerSecond;
+  return true;
+}
+
 pid_t ProcFS::GetProcessParentPid(pid_t pid) {
   FILE *fp = OpenFILE(pid, "status");
   if (fp == nullptr)
@@ -846,6 +887,119 @@ bool ProcFS::EnumerateThreads(pid_t pid, std::function<void(pid_t)> const &cb) {
 
   return true;
 }
+
+bool ProcFS::EnumerateMemoryRegions(
+    pid_t pid, std::function<void(MemoryRegionInfo const &)> const &cb) {
+  FILE *fp = OpenFILE(pid, "maps");
+  if (fp == nullptr)
+    return false;
+
+  MemoryRegionInfo info;
+  bool success = true;
+
+  for (;;) {
+    // A line is a path plus less than a hundred characters of fields.
+    char buf[PATH_MAX * 2];
+    uint64_t start, end;
+    char r, w, x, p;
+    uint64_t offset;
+    unsigned int devMajor, devMinor;
+    uint64_t inode;
+    int nread = 0;
+
+    if (std::fgets(buf, sizeof(buf), fp) == nullptr) {
+      success = std::feof(fp);
+      break;
+    }
+
+    if (std::sscanf(buf,
+                    "%" PRIx64 "-%" PRIx64 " %c%c%c%c %" PRIx64
+                    " %x:%x %" PRIu64 "%n",
+                    &start, &end, &r, &w, &x, &p, &offset, &devMajor,
+                    &devMinor, &inode, &nread) != 10) {
+      continue;
+    }
+
+    // The path is what remains of the line, it may contain spaces.
+    char *path = buf + nread;
+    while (*path != '\0' && std::isspace(*path))
+      ++path;
+    size_t length = std::strlen(path);
+    while (length > 0 && std::isspace(path[length - 1]))
+      path[--length] = '\0';
+
+    info.clear();
+    info.start = start;
+    info.length = end - start;
+    if (r == 'r')
+      info.protection |= kProtectionRead;
+    if (w == 'w')
+      info.protection |= kProtectionWrite;
+    if (x == 'x')
+      info.protection |= kProtectionExecute;
+    info.name = path;
+    info.backingFile = path;
+    info.backingFileOffset = offset;
+    info.backingFileInode = inode;
+    cb(info);
+  }
+  std::fclose(fp);
+
+  return success;
+}
+
+namespace {
+// Reads the numeric entries of the directory open at fd with getdents(2)
+// and returns them in ascending order. Takes ownership of fd.
+static bool ReadNumericEntries(int fd, std::vector<pid_t> &ids) {
+  // Large enough for about 10k entries in a single call.
+  static size_t const kBufferSize = 256 * 1024;
+
+  struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+  };
+
+  if (fd < 0)
+    return false;
+
+  std::vector<char> buffer(kBufferSize);
+  ids.clear();
+
+  long nread;
+  do {
+    nread = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+    for (long offset = 0; offset < nread;) {
+      auto dp = reinterpret_cast<linux_dirent64 *>(buffer.data() + offset);
+      pid_t id = strtol(dp->d_name, nullptr, 10);
+      if (id > 0) {
+        ids.push_back(id);
+      }
+      offset += dp->d_reclen;
+    }
+  } while (nread > 0 || (nread < 0 && errno == EINTR));
+  close(fd);
+
+  if (nread < 0)
+    return false;
+
+  std::sort(ids.begin(), ids.end());
+  return true;
+}
+} // namespace
+
+bool ProcFS::ReadThreadIds(pid_t pid, std::vector<pid_t> &tids) {
+  return ReadNumericEntries(
+      OpenFd(pid, "task", O_RDONLY | O_DIRECTORY | O_CLOEXEC), tids);
+}
+
+bool ProcFS::ReadProcessList(std::vector<pid_t> &pids) {
+  return ReadNumericEntries(OpenFd("", O_RDONLY | O_DIRECTORY | O_CLOEXEC),
+                            pids);
+}
 } // namespace Linux
 } // namespace Host
 } // namespace ds2
@@ -0,0 +1,266 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Host/Linux/ProcessWatcher.h"
+#include "DebugServer2/Host/Linux/ProcFS.h"
+#include "DebugServer2/Host/Platform.h"
+#include "DebugServer2/Utils/Log.h"
+#include "DebugServer2/Utils/Paths.h"
+#include "DebugServer2/Utils/Stringify.h"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using ds2::Utils::Stringify;
+
+namespace ds2 {
+namespace Host {
+namespace Linux {
+
+std::chrono::milliseconds const ProcessWatcher::kExecGracePeriod(1000);
+std::chrono::microseconds const ProcessWatcher::kScanInterval(1000);
+
+namespace {
+// How long we wait for the kernel to acknowledge our subscription. It is sent
+// synchronously, so this only matters if it never comes.
+static int const kConnectorAckTimeout = 50;
+// How often a wait on the connector checks whether it was cancelled.
+static int const kCancelPollInterval = 100;
+
+static size_t const kConnectorBufferSize = 16 * 1024;
+
+// Older kernel headers declare the event types in an enum nested in struct
+// proc_event, newer ones at namespace scope; this names them either way.
+typedef decltype(proc_event::what) ProcEventType;
+} // namespace
+
+ProcessWatcher::ProcessWatcher(std::string const &name)
+    : _name(name), _fd(-1) {}
+
+ProcessWatcher::~ProcessWatcher() {
+  if (_fd >= 0) {
+    ::close(_fd);
+  }
+}
+
+ErrorCode ProcessWatcher::start(bool existing, ProcessId &pid) {
+  pid = kAnyProcessId;
+  _known.clear();
+
+  // Subscribe before listing the processes that are already there, so that
+  // a program started in between isn't missed.
+  if (!openConnector()) {
+    DS2LOG(Debug, "process connector unavailable, polling /proc instead");
+  }
+
+  std::vector<pid_t> pids;
+  if (!ProcFS::ReadProcessList(pids))
+    return Platform::TranslateError();
+
+  for (pid_t p : pids) {
+    if (existing && pid == kAnyProcessId && matches(p)) {
+      pid = p;
+    }
+    _known.emplace_back(p, Clock::time_point());
+  }
+
+  return kSuccess;
+}
+
+ErrorCode ProcessWatcher::wait(std::atomic<bool> const &cancel,
+                               ProcessId &pid) {
+  while (!cancel) {
+    if (usesConnector()) {
+      struct pollfd pfd;
+      pfd.fd = _fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      int ret = ::poll(&pfd, 1, kCancelPollInterval);
+      if (ret < 0 && errno != EINTR)
+        return Platform::TranslateError();
+      if (ret > 0 && readConnector(pid))
+        return kSuccess;
+    } else {
+      if (scan(true, pid))
+        return kSuccess;
+      std::this_thread::sleep_for(kScanInterval);
+    }
+  }
+
+  return kErrorInterrupted;
+}
+
+bool ProcessWatcher::matches(pid_t pid) const {
+  std::string path = ProcFS::GetProcessExecutablePath(pid);
+  if (path.empty())
+    return false;
+
+  return path == _name || ds2::Utils::Basename(path) == _name;
+}
+
+bool ProcessWatcher::openConnector() {
+  int fd = ::socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+  if (fd < 0)
+    return false;
+
+  struct sockaddr_nl addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = CN_IDX_PROC;
+  if (::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) <
+      0) {
+    DS2LOG(Debug, "unable to join the process connector group, error=%s",
+           Stringify::Errno(errno));
+    ::close(fd);
+    return false;
+  }
+
+  char request[NLMSG_SPACE(sizeof(struct cn_msg) +
+                           sizeof(enum proc_cn_mcast_op))];
+  std::memset(request, 0, sizeof(request));
+
+  auto header = reinterpret_cast<struct nlmsghdr *>(request);
+  header->nlmsg_len =
+      NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+  header->nlmsg_type = NLMSG_DONE;
+  header->nlmsg_pid = ::getpid();
+
+  auto message = reinterpret_cast<struct cn_msg *>(NLMSG_DATA(header));
+  message->id.idx = CN_IDX_PROC;
+  message->id.val = CN_VAL_PROC;
+  message->len = sizeof(enum proc_cn_mcast_op);
+  *reinterpret_cast<enum proc_cn_mcast_op *>(message->data) =
+      PROC_CN_MCAST_LISTEN;
+
+  if (::send(fd, request, header->nlmsg_len, 0) < 0) {
+    ::close(fd);
+    return false;
+  }
+
+  // The kernel silently ignores subscriptions from outside the initial
+  // namespaces, in which case no acknowledgement (and no event) ever comes.
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  while (::poll(&pfd, 1, kConnectorAckTimeout) > 0) {
+    char buffer[kConnectorBufferSize];
+    ssize_t nread = ::recv(fd, buffer, sizeof(buffer), 0);
+    if (nread <= 0)
+      break;
+
+    auto nlh = reinterpret_cast<struct nlmsghdr *>(buffer);
+    size_t length = nread;
+    for (; NLMSG_OK(nlh, length); nlh = NLMSG_NEXT(nlh, length)) {
+      auto msg = reinterpret_cast<struct cn_msg *>(NLMSG_DATA(nlh));
+      auto event = reinterpret_cast<struct proc_event *>(msg->data);
+      if (event->what != ProcEventType::PROC_EVENT_NONE)
+        continue;
+
+      if (event->event_data.ack.err != 0) {
+        DS2LOG(Debug, "process connector refused subscription, error=%s",
+               Stringify::Errno(event->event_data.ack.err));
+        ::close(fd);
+        return false;
+      }
+
+      _fd = fd;
+      return true;
+    }
+  }
+
+  ::close(fd);
+  return false;
+}
+
+bool ProcessWatcher::readConnector(ProcessId &pid) {
+  char buffer[kConnectorBufferSize];
+
+  for (;;) {
+    ssize_t nread = ::recv(_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (nread < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == ENOBUFS) {
+        // Some events were dropped; look for the ones we missed in /proc.
+        DS2LOG(Warning, "process connector overrun, scanning /proc");
+        if (scan(true, pid))
+          return true;
+        continue;
+      }
+      return false;
+    }
+
+    auto nlh = reinterpret_cast<struct nlmsghdr *>(buffer);
+    size_t length = nread;
+    for (; NLMSG_OK(nlh, length); nlh = NLMSG_NEXT(nlh, length)) {
+      auto msg = reinterpret_cast<struct cn_msg *>(NLMSG_DATA(nlh));
+      auto event = reinterpret_cast<struct proc_event *>(msg->data);
+      if (event->what != ProcEventType::PROC_EVENT_EXEC)
+        continue;
+
+      pid_t tgid = event->event_data.exec.process_tgid;
+      if (matches(tgid)) {
+        pid = tgid;
+        return true;
+      }
+    }
+  }
+}
+
+bool ProcessWatcher::scan(bool match, ProcessId &pid) {
+  std::vector<pid_t> pids;
+  if (!ProcFS::ReadProcessList(pids))
+    return false;
+
+  // Both lists are sorted, walk them side by side to find out which
+  // processes are new.
+  Clock::time_point now = Clock::now();
+  std::vector<std::pair<pid_t, Clock::time_point>> known;
+  known.reserve(pids.size());
+
+  bool found = false;
+  auto it = _known.begin();
+  for (pid_t p : pids) {
+    while (it != _known.end() && it->first < p) {
+      ++it;
+    }
+
+    Clock::time_point firstSeen = now;
+    if (it != _known.end() && it->first == p) {
+      firstSeen = it->second;
+    }
+
+    // A process that was forked a short while ago may call execve(2) later
+    // on, so keep looking at it for some time.
+    if (match && !found && now - firstSeen < kExecGracePeriod &&
+        matches(p)) {
+      pid = p;
+      found = true;
+      // Don't return this one again if the caller can't attach to it.
+      firstSeen = Clock::time_point();
+    }
+
+    known.emplace_back(p, firstSeen);
+  }
+
+  _known.swap(known);
+  return found;
+}
+} // namespace Linux
+} // namespace Host
+} // namespace ds2
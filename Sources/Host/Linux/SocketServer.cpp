@@ -0,0 +1,249 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Host/Linux/SocketServer.h"
+#include "DebugServer2/Host/Platform.h"
+#include "DebugServer2/Utils/Log.h"
+#include "DebugServer2/Utils/Stringify.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+using ds2::Utils::Stringify;
+
+namespace ds2 {
+namespace Host {
+namespace Linux {
+
+static uint32_t const kClientEvents = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+static size_t const kMaxEvents = 64;
+
+SocketServer::SocketServer(std::unique_ptr<Socket> listener,
+                           HandlerFactory const &factory,
+                           size_t maxConnections, size_t workerCount)
+    : _listener(std::move(listener)), _factory(factory),
+      _maxConnections(maxConnections), _workerCount(workerCount),
+      _epollFd(-1), _accepting(false), _stopping(false) {
+  if (_maxConnections == 0) {
+    _maxConnections = kDefaultMaxConnections;
+  }
+
+  if (_workerCount == 0) {
+    _workerCount = std::thread::hardware_concurrency();
+    if (_workerCount == 0) {
+      _workerCount = 4;
+    }
+  }
+}
+
+SocketServer::~SocketServer() {
+  {
+    std::lock_guard<std::mutex> guard(_lock);
+    _stopping = true;
+  }
+  _ready.notify_all();
+
+  for (auto &worker : _workers) {
+    worker.join();
+  }
+
+  _queue.clear();
+  _connections.clear();
+
+  if (_epollFd >= 0) {
+    ::close(_epollFd);
+  }
+}
+
+bool SocketServer::arm(int fd, Connection *connection, uint32_t events,
+                       bool add) {
+  struct epoll_event ev;
+  ev.events = events;
+  ev.data.ptr = connection;
+
+  if (::epoll_ctl(_epollFd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &ev) < 0) {
+    DS2LOG(Warning, "unable to %s fd %d in epoll set, errno=%s",
+           add ? "add" : "re-arm", fd, Stringify::Errno(errno));
+    return false;
+  }
+
+  return true;
+}
+
+ErrorCode SocketServer::run() {
+  if (!_listener || !_listener->listening()) {
+    return kErrorInvalidArgument;
+  }
+
+  _epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (_epollFd < 0) {
+    return Platform::TranslateError();
+  }
+
+  // The listening socket is drained in a loop every time it becomes
+  // readable, so it must never block.
+  int listenFd = _listener->handle();
+  int flags = ::fcntl(listenFd, F_GETFL, 0);
+  if (flags < 0 || ::fcntl(listenFd, F_SETFL, flags | O_NONBLOCK) < 0) {
+    return Platform::TranslateError();
+  }
+
+  if (!arm(listenFd, nullptr, EPOLLIN, true)) {
+    return Platform::TranslateError();
+  }
+  _accepting = true;
+
+  for (size_t n = 0; n < _workerCount; n++) {
+    _workers.emplace_back(&SocketServer::workerLoop, this);
+  }
+
+  DS2LOG(Debug, "serving up to %zu connections with %zu workers",
+         _maxConnections, _workerCount);
+
+  for (;;) {
+    struct epoll_event events[kMaxEvents];
+    int nfds = ::epoll_wait(_epollFd, events, kMaxEvents, -1);
+    if (nfds < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Platform::TranslateError();
+    }
+
+    for (int n = 0; n < nfds; n++) {
+      if (events[n].data.ptr == nullptr) {
+        acceptConnections();
+      } else {
+        dispatch(static_cast<Connection *>(events[n].data.ptr),
+                 events[n].events);
+      }
+    }
+  }
+}
+
+void SocketServer::acceptConnections() {
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> guard(_lock);
+      if (_connections.size() >= _maxConnections) {
+        // Stop polling the listening socket, new clients will wait in the
+        // kernel backlog until a slot frees up.
+        DS2LOG(Debug, "connection limit (%zu) reached, pausing accept",
+               _maxConnections);
+        arm(_listener->handle(), nullptr, 0, false);
+        _accepting = false;
+        return;
+      }
+    }
+
+    std::unique_ptr<Socket> client = _listener->accept();
+    if (!client) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        DS2LOG(Warning, "unable to accept connection: %s",
+               _listener->error().c_str());
+      }
+      return;
+    }
+
+    auto connection = ds2::make_unique<Connection>();
+    connection->handler = _factory(client.get());
+    connection->socket = std::move(client);
+    connection->state = ConnectionState::Idle;
+    connection->events = 0;
+
+    // Connections are identified by address rather than by descriptor: a
+    // socket closing itself on error would otherwise let a new client reuse
+    // its descriptor while a worker still owns the old one.
+    Connection *key = connection.get();
+    std::lock_guard<std::mutex> guard(_lock);
+    _connections[key] = std::move(connection);
+    if (!arm(key->socket->handle(), key, kClientEvents, true)) {
+      _connections.erase(key);
+    }
+  }
+}
+
+void SocketServer::dispatch(Connection *connection, uint32_t events) {
+  std::lock_guard<std::mutex> guard(_lock);
+
+  if (_connections.find(connection) == _connections.end()) {
+    return;
+  }
+
+  // EPOLLONESHOT guarantees we don't get here while a worker owns the
+  // connection.
+  DS2ASSERT(connection->state == ConnectionState::Idle);
+  connection->state = ConnectionState::Processing;
+  connection->events = events;
+  _queue.push_back(connection);
+  _ready.notify_one();
+}
+
+void SocketServer::workerLoop() {
+  for (;;) {
+    Connection *connection;
+
+    {
+      std::unique_lock<std::mutex> guard(_lock);
+      _ready.wait(guard, [this] { return _stopping || !_queue.empty(); });
+      if (_stopping) {
+        return;
+      }
+      connection = _queue.front();
+      _queue.pop_front();
+    }
+
+    process(connection);
+  }
+}
+
+void SocketServer::process(Connection *connection) {
+  Socket *socket = connection->socket.get();
+
+  if (connection->events & EPOLLIN) {
+    // Socket hides the buffered Channel::receive overload.
+    Channel *channel = socket;
+    std::string data;
+    if (channel->receive(data) && !connection->handler->onData(data)) {
+      connection->state = ConnectionState::Closing;
+    }
+  }
+
+  // Data still pending when the peer hung up has been consumed above, we
+  // can safely drop the connection now.
+  if ((connection->events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) ||
+      !socket->connected()) {
+    connection->state = ConnectionState::Closing;
+  }
+
+  std::lock_guard<std::mutex> guard(_lock);
+
+  if (connection->state != ConnectionState::Closing &&
+      arm(socket->handle(), connection, kClientEvents, false)) {
+    connection->state = ConnectionState::Idle;
+    return;
+  }
+
+  // A socket that closed itself has already been dropped from the epoll set
+  // by the kernel, and its descriptor may belong to someone else by now.
+  if (socket->valid()) {
+    ::epoll_ctl(_epollFd, EPOLL_CTL_DEL, socket->handle(), nullptr);
+  }
+  _connections.erase(connection);
+
+  if (!_accepting && _connections.size() < _maxConnections) {
+    _accepting = arm(_listener->handle(), nullptr, EPOLLIN, false);
+  }
+}
+} // namespace Linux
+} // namespace Host
+} // namespace ds2
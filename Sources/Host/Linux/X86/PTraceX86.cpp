@@ -14,6 +14,7 @@
 #include "DebugServer2/Host/Platform.h"
 
 #include <cstddef>
+#include <cstring>
 #include <elf.h>
 #include <sys/ptrace.h>
 #include <sys/uio.h>
@@ -231,6 +232,59 @@ ErrorCode PTrace::writeCPUState(ProcessThreadId const &ptid,
 
   return kSuccess;
 }
+ErrorCode PTrace::writeCPUState(ProcessThreadId const &ptid,
+                                ProcessInfo const &,
+                                Architecture::CPUState const &state,
+                                Architecture::CPUState const &previous) {
+  pid_t pid;
+  CHK(ptidToPid(ptid, pid));
+
+  //
+  // Convert both states to the kernel layout and only write the sets that
+  // differ; zero everything first so padding doesn't show up as a change.
+  //
+  user_regs_struct gprs, oldGPRs;
+  std::memset(&gprs, 0, sizeof(gprs));
+  std::memset(&oldGPRs, 0, sizeof(oldGPRs));
+  Architecture::X86::state32_to_user(gprs, state);
+  Architecture::X86::state32_to_user(oldGPRs, previous);
+
+  if (std::memcmp(&gprs, &oldGPRs, sizeof(gprs)) != 0) {
+    if (wrapPtrace(PTRACE_SETREGS, pid, nullptr, &gprs) < 0)
+      return Platform::TranslateError();
+  }
+
+  struct xsave_struct xfpregs, oldXFPRegs;
+  std::memset(&xfpregs, 0, sizeof(xfpregs));
+  std::memset(&oldXFPRegs, 0, sizeof(oldXFPRegs));
+  state32_to_user(xfpregs, state);
+  state32_to_user(oldXFPRegs, previous);
+
+  if (std::memcmp(&xfpregs, &oldXFPRegs, sizeof(xfpregs)) != 0) {
+    struct iovec fpregs_iovec;
+    fpregs_iovec.iov_base = &xfpregs;
+    fpregs_iovec.iov_len = sizeof(xfpregs);
+
+    // See writeCPUState above regarding failures.
+    wrapPtrace(PTRACE_SETREGSET, pid, NT_X86_XSTATE, &fpregs_iovec);
+  }
+
+  size_t debugRegOffset = offsetof(struct user, u_debugreg);
+  size_t debugRegSize = sizeof(((struct user *)nullptr)->u_debugreg[0]);
+  for (size_t i = 0; i < array_sizeof(state.dr.dr); ++i) {
+    // dr4 and dr5 are reserved and not used
+    if (i == 4 || i == 5 || state.dr.dr[i] == previous.dr.dr[i]) {
+      continue;
+    }
+
+    if (wrapPtrace(PTRACE_POKEUSER, pid, debugRegOffset + i * debugRegSize,
+                   state.dr.dr[i]) < 0) {
+      return Platform::TranslateError();
+    }
+  }
+
+  return kSuccess;
+}
 } // namespace Linux
 } // namespace Host
 } // namespace ds2
@@ -13,7 +13,10 @@
 #include "DebugServer2/Host/Linux/ExtraWrappers.h"
 #include "DebugServer2/Host/Platform.h"
 
+#include <algorithm>
+#include <cpuid.h>
 #include <cstddef>
+#include <cstring>
 #include <elf.h>
 #include <sys/ptrace.h>
 #include <sys/uio.h>
@@ -62,12 +65,19 @@ static inline void user_to_state32(ds2::Architecture::X86_64::CPUState32 &state,
   //
   //  EAVX State
   //
+  // The AVX component is in its init state (all zeroes) when its XSTATE_BV
+  // bit is clear, whatever the buffer holds.
+  bool avxInUse = (xfpregs.header.xfeatures_mask & XFeature::X86_AVX) != 0;
   auto ymmh = reinterpret_cast<uint8_t const *>(xfpregs.ymmh);
   static const size_t avxSize = sizeof(state.avx.regs[0]);
   static const size_t ymmhSize = avxSize - sseRegSize;
   for (size_t n = 0; n < array_sizeof(state.avx.regs); n++) {
     auto avxHigh = reinterpret_cast<uint8_t *>(&state.avx.regs[n]) + sseRegSize;
-    memcpy(avxHigh, ymmh + n * ymmhSize, ymmhSize);
+    if (avxInUse) {
+      memcpy(avxHigh, ymmh + n * ymmhSize, ymmhSize);
+    } else {
+      memset(avxHigh, 0, ymmhSize);
+    }
   }
 }
 
@@ -112,8 +122,7 @@ state32_to_user(struct xsave_struct &xfpregs,
   if (state.xcr0 & XFeature::X86_AVX) {
     xfpregs.header.xfeatures_mask |= XFeature::X86_AVX;
   }
-  // TODO: Support xcomp_bv. See 13.4.2 XSAVE Header in Intels' 64 and IA32
-  // Architecture Manual to understand the purpose of xcomp_bv.
+  // NT_X86_XSTATE always uses the standard format; see ExpandXSaveArea.
   xfpregs.header.xcomp_bv = 0;
 
   //
@@ -148,7 +157,7 @@ static inline void user_to_state64(ds2::Architecture::X86_64::CPUState64 &state,
     memcpy(state.x87.regs[n].data, st_space + n * x87RegSize, x87DataSize);
   }
 
-  // TODO: This hack is necessary because we don't handle EAVX registers.
+  // xmm16-31 only exist in the Hi16_ZMM component.
   size_t numSSEState = array_sizeof(state.sse.regs);
   size_t numSSEUser =
       sizeof(xfpregs.fpregs.xmm_space) / sizeof(state.sse.regs[0]);
@@ -170,12 +179,18 @@ static inline void user_to_state64(ds2::Architecture::X86_64::CPUState64 &state,
   //
   //  EAVX State
   //
+  // See user_to_state32 regarding the init state.
+  bool avxInUse = (xfpregs.header.xfeatures_mask & XFeature::X86_AVX) != 0;
   auto ymmh = reinterpret_cast<uint8_t const *>(xfpregs.ymmh);
   static const size_t avxSize = sizeof(state.avx.regs[0]);
   static const size_t ymmhSize = avxSize - sseRegSize;
   for (size_t n = 0; n < numSSE; n++) {
     auto avxHigh = reinterpret_cast<uint8_t *>(&state.avx.regs[n]) + sseRegSize;
-    memcpy(avxHigh, ymmh + n * ymmhSize, ymmhSize);
+    if (avxInUse) {
+      memcpy(avxHigh, ymmh + n * ymmhSize, ymmhSize);
+    } else {
+      memset(avxHigh, 0, ymmhSize);
+    }
   }
 }
 
@@ -199,7 +214,7 @@ state64_to_user(struct xsave_struct &xfpregs,
     memcpy(st_space + n * x87RegSize, state.x87.regs[n].data, x87DataSize);
   }
 
-  // This hack is necessary because we don't handle EAVX registers
+  // xmm16-31 only exist in the Hi16_ZMM component.
   size_t numSSEState = array_sizeof(state.sse.regs);
   size_t numSSEUser =
       sizeof(xfpregs.fpregs.xmm_space) / sizeof(state.sse.regs[0]);
@@ -226,8 +241,16 @@ state64_to_user(struct xsave_struct &xfpregs,
   if (state.xcr0 & XFeature::X86_AVX) {
     xfpregs.header.xfeatures_mask |= XFeature::X86_AVX;
   }
-  // TODO: Support xcomp_bv. See 13.4.2 XSAVE Header in Intels' 64 and IA32
-  // Architecture Manual to understand the purpose of xcomp_bv.
+  if (state.xcr0 & XFeature::X86_AVX_512_OPMASK) {
+    xfpregs.header.xfeatures_mask |= XFeature::X86_AVX_512_OPMASK;
+  }
+  if (state.xcr0 & XFeature::X86_AVX_512_HI256) {
+    xfpregs.header.xfeatures_mask |= XFeature::X86_AVX_512_HI256;
+  }
+  if (state.xcr0 & XFeature::X86_AVX_512_ZMM) {
+    xfpregs.header.xfeatures_mask |= XFeature::X86_AVX_512_ZMM;
+  }
+  // NT_X86_XSTATE always uses the standard format; see ExpandXSaveArea.
   xfpregs.header.xcomp_bv = 0;
 
   //
@@ -243,9 +266,275 @@ state64_to_user(struct xsave_struct &xfpregs,
   }
 }
 
+//
+// Layout of the XSAVE area, from CPUID leaf 0xD. See "XSAVE-Managed State" in
+// Intel's 64 and IA32 Architecture Manual, volume 1.
+//
+static size_t const kXSaveMaxComponents = 63;
+static size_t const kXSaveExtendedOffset = sizeof(struct xsave_struct) -
+                                           sizeof(((xsave_struct *)0)->ymmh);
+static uint64_t const kXCompBVCompacted = 1ULL << 63;
+
+struct XSaveLayout {
+  struct Component {
+    uint32_t offset; // Standard format offset, 0 for supervisor components.
+    uint32_t size;
+    bool aligned; // 64-byte aligned in the compacted format.
+  };
+
+  size_t size; // Standard format size for every feature XCR0 can enable.
+  Component components[kXSaveMaxComponents];
+};
+
+static XSaveLayout ComputeXSaveLayout() {
+  XSaveLayout layout;
+  std::memset(&layout, 0, sizeof(layout));
+  layout.size = sizeof(struct xsave_struct);
+
+  if (__get_cpuid_max(0, nullptr) < 0xd) {
+    return layout;
+  }
+
+  unsigned int eax, ebx, ecx, edx;
+  __cpuid_count(0xd, 0, eax, ebx, ecx, edx);
+  layout.size = std::max<size_t>(layout.size, ecx);
+
+  for (size_t n = 2; n < kXSaveMaxComponents; n++) {
+    __cpuid_count(0xd, n, eax, ebx, ecx, edx);
+    layout.components[n].size = eax;
+    layout.components[n].offset = (ecx & 1) ? 0 : ebx;
+    layout.components[n].aligned = (ecx & 2) != 0;
+  }
+
+  return layout;
+}
+
+static inline XSaveLayout const &GetXSaveLayout() {
+  static XSaveLayout const layout = ComputeXSaveLayout();
+  return layout;
+}
+
+// Returns the offset of component `n` in a standard format XSAVE area, or 0
+// if the area doesn't hold `size` bytes of it.
+static inline size_t XSaveComponentOffset(ByteVector const &area, size_t n,
+                                          size_t size) {
+  XSaveLayout::Component const &component = GetXSaveLayout().components[n];
+  if (component.offset < kXSaveExtendedOffset || component.size < size ||
+      component.offset + size > area.size()) {
+    return 0;
+  }
+  return component.offset;
+}
+
+//
+// Rewrites a compacted format XSAVE area (XSAVEC/XSAVES, flagged by bit 63 of
+// xcomp_bv) in the standard format, where every component lives at the
+// offset CPUID reports for it. Components are packed in the order of the
+// xcomp_bv bits; those that are in their init state keep their space but
+// hold nothing meaningful, so they are left zeroed.
+//
+static void ExpandXSaveArea(ByteVector &area) {
+  struct xsave_hdr header;
+  std::memcpy(&header, &area[offsetof(struct xsave_struct, header)],
+              sizeof(header));
+  if (!(header.xcomp_bv & kXCompBVCompacted)) {
+    return;
+  }
+
+  XSaveLayout const &layout = GetXSaveLayout();
+  ByteVector expanded(area.size(), 0);
+  std::copy(area.begin(), area.begin() + kXSaveExtendedOffset,
+            expanded.begin());
+
+  size_t offset = kXSaveExtendedOffset;
+  for (size_t n = 2; n < kXSaveMaxComponents; n++) {
+    if (!(header.xcomp_bv & (1ULL << n))) {
+      continue;
+    }
+
+    XSaveLayout::Component const &component = layout.components[n];
+    if (component.size == 0) {
+      // We can't locate anything past a component we know nothing about.
+      break;
+    }
+
+    if (component.aligned) {
+      offset = (offset + 63) & ~static_cast<size_t>(63);
+    }
+
+    if ((header.xfeatures_mask & (1ULL << n)) && component.offset != 0 &&
+        offset + component.size <= area.size() &&
+        component.offset + component.size <= expanded.size()) {
+      std::memcpy(&expanded[component.offset], &area[offset], component.size);
+    }
+
+    offset += component.size;
+  }
+
+  header.xcomp_bv = 0;
+  std::memcpy(&expanded[offsetof(struct xsave_struct, header)], &header,
+              sizeof(header));
+  area.swap(expanded);
+}
+
+//
+// AVX-512 state: the opmask registers, the upper 256 bits of zmm0-15
+// (ZMM_Hi256) and zmm16-31 (Hi16_ZMM). Components whose XSTATE_BV bit is
+// clear are in their init state, all zeroes, and aren't copied.
+//
+static void
+user_to_state64_avx512(ds2::Architecture::X86_64::CPUState64 &state,
+                       ByteVector const &area, uint64_t xfeatures) {
+  static const size_t zmmHighOffset = sizeof(state.avx.regs[0]);
+  static const size_t zmmHighSize = sizeof(state.eavx.regs[0]) - zmmHighOffset;
+  static const size_t numZMMLow = 16;
+
+  size_t offset = XSaveComponentOffset(area, 5, sizeof(state.kmask));
+  if ((xfeatures & XFeature::X86_AVX_512_OPMASK) && offset != 0) {
+    std::memcpy(&state.kmask, &area[offset], sizeof(state.kmask));
+  } else {
+    std::memset(&state.kmask, 0, sizeof(state.kmask));
+  }
+
+  offset = XSaveComponentOffset(area, 6, numZMMLow * zmmHighSize);
+  for (size_t n = 0; n < numZMMLow; n++) {
+    auto zmmHigh = reinterpret_cast<uint8_t *>(&state.eavx.regs[n]) +
+                   zmmHighOffset;
+    if ((xfeatures & XFeature::X86_AVX_512_HI256) && offset != 0) {
+      std::memcpy(zmmHigh, &area[offset + n * zmmHighSize], zmmHighSize);
+    } else {
+      std::memset(zmmHigh, 0, zmmHighSize);
+    }
+  }
+
+  static const size_t zmmSize = sizeof(state.eavx.regs[0]);
+  static const size_t numZMMHigh = array_sizeof(state.eavx.regs) - numZMMLow;
+  offset = XSaveComponentOffset(area, 7, numZMMHigh * zmmSize);
+  if ((xfeatures & XFeature::X86_AVX_512_ZMM) && offset != 0) {
+    std::memcpy(&state.eavx.regs[numZMMLow], &area[offset],
+                numZMMHigh * zmmSize);
+  } else {
+    std::memset(&state.eavx.regs[numZMMLow], 0, numZMMHigh * zmmSize);
+  }
+}
+
+static void
+state64_to_user_avx512(ByteVector &area,
+                       ds2::Architecture::X86_64::CPUState64 const &state) {
+  static const size_t zmmHighOffset = sizeof(state.avx.regs[0]);
+  static const size_t zmmHighSize = sizeof(state.eavx.regs[0]) - zmmHighOffset;
+  static const size_t numZMMLow = 16;
+
+  size_t offset = XSaveComponentOffset(area, 5, sizeof(state.kmask));
+  if (offset != 0) {
+    std::memcpy(&area[offset], &state.kmask, sizeof(state.kmask));
+  }
+
+  offset = XSaveComponentOffset(area, 6, numZMMLow * zmmHighSize);
+  if (offset != 0) {
+    for (size_t n = 0; n < numZMMLow; n++) {
+      auto zmmHigh = reinterpret_cast<uint8_t const *>(&state.eavx.regs[n]) +
+                     zmmHighOffset;
+      std::memcpy(&area[offset + n * zmmHighSize], zmmHigh, zmmHighSize);
+    }
+  }
+
+  static const size_t zmmSize = sizeof(state.eavx.regs[0]);
+  static const size_t numZMMHigh = array_sizeof(state.eavx.regs) - numZMMLow;
+  offset = XSaveComponentOffset(area, 7, numZMMHigh * zmmSize);
+  if (offset != 0) {
+    std::memcpy(&area[offset], &state.eavx.regs[numZMMLow],
+                numZMMHigh * zmmSize);
+  }
+}
+
+// `area` must be at least sizeof(struct xsave_struct) long.
+static void DecodeXSaveArea(Architecture::CPUState &state,
+                            ByteVector const &area) {
+  struct xsave_struct xfpregs;
+  std::memcpy(&xfpregs, area.data(), sizeof(xfpregs));
+
+  if (state.is32) {
+    user_to_state32(state.state32, xfpregs);
+  } else {
+    user_to_state64(state.state64, xfpregs);
+    user_to_state64_avx512(state.state64, area, xfpregs.header.xfeatures_mask);
+  }
+}
+
+// Same requirement as DecodeXSaveArea; components we don't know about are
+// left untouched.
+static void EncodeXSaveArea(ByteVector &area,
+                            Architecture::CPUState const &state) {
+  struct xsave_struct xfpregs;
+  std::memcpy(&xfpregs, area.data(), sizeof(xfpregs));
+
+  if (state.is32) {
+    state32_to_user(xfpregs, state.state32);
+  } else {
+    state64_to_user(xfpregs, state.state64);
+  }
+
+  std::memcpy(area.data(), &xfpregs, sizeof(xfpregs));
+
+  if (!state.is32) {
+    state64_to_user_avx512(area, state.state64);
+  }
+}
+
+ErrorCode PTrace::readXSaveArea(pid_t pid, ByteVector &area, size_t &length) {
+  area.assign(GetXSaveLayout().size, 0);
+
+  struct iovec iov;
+  iov.iov_base = area.data();
+  iov.iov_len = area.size();
+
+  if (wrapPtrace(PTRACE_GETREGSET, pid, NT_X86_XSTATE, &iov) < 0)
+    return Platform::TranslateError();
+
+  // The kernel returns the size of its XSAVE area, which is the exact size
+  // PTRACE_SETREGSET expects back.
+  length = iov.iov_len;
+  ExpandXSaveArea(area);
+
+  return kSuccess;
+}
+
+ErrorCode PTrace::writeXSaveArea(pid_t pid,
+                                 Architecture::CPUState const &state) {
+  // Start from the kernel's copy so that the components we don't handle
+  // (MPX, PKRU, ...) are written back unchanged.
+  ByteVector area;
+  size_t length;
+
+  // TODO: If this fails, XSAVE is most likely unsupported and we should
+  // fallback to FXSAVE to write the legacy portion of our state (x87, MMX,
+  // SSE).
+  if (readXSaveArea(pid, area, length) != kSuccess)
+    return kSuccess;
+
+  EncodeXSaveArea(area, state);
+
+  struct iovec iov;
+  iov.iov_base = area.data();
+  iov.iov_len = length;
+
+  if (wrapPtrace(PTRACE_SETREGSET, pid, NT_X86_XSTATE, &iov) < 0)
+    return Platform::TranslateError();
+
+  return kSuccess;
+}
+
 ErrorCode PTrace::readCPUState(ProcessThreadId const &ptid,
                                ProcessInfo const &pinfo,
                                Architecture::CPUState &state) {
+  CHK(readBaseCPUState(ptid, pinfo, state));
+  return readExtendedCPUState(ptid, pinfo, state);
+}
+
+ErrorCode PTrace::readBaseCPUState(ProcessThreadId const &ptid,
+                                   ProcessInfo const &pinfo,
+                                   Architecture::CPUState &state) {
   pid_t pid;
   CHK(ptidToPid(ptid, pid));
 
@@ -264,28 +553,6 @@ ErrorCode PTrace::readCPUState(ProcessThreadId const &ptid,
     Architecture::X86::user_to_state64(state.state64, gprs);
   }
 
-  //
-  // Read SSE and AVX
-  //
-  struct xsave_struct xfpregs;
-  struct iovec fpregs_iovec;
-  fpregs_iovec.iov_base = &xfpregs;
-  fpregs_iovec.iov_len = sizeof(xfpregs);
-
-  // TODO: If this fails (i.e. ptrace returns < 0), it means XSAVE is most
-  // likely unsupported and we can't expect XSAVE to work. In this case, we
-  // should fallback to FXSAVE and only read the legacy portion of our xsave
-  // state (x87, MMX, SSE).
-  // If this call fails, don't return failure, since AVX may not be available
-  // on this CPU.
-  if (wrapPtrace(PTRACE_GETREGSET, pid, NT_X86_XSTATE, &fpregs_iovec) == 0) {
-    if (pinfo.pointerSize == sizeof(uint32_t)) {
-      user_to_state32(state.state32, xfpregs);
-    } else {
-      user_to_state64(state.state64, xfpregs);
-    }
-  }
-
   // Read the debug registers
   size_t debugRegOffset = offsetof(struct user, u_debugreg);
   size_t debugRegSize = sizeof(((struct user *)0)->u_debugreg[0]);
@@ -312,6 +579,32 @@ ErrorCode PTrace::readCPUState(ProcessThreadId const &ptid,
   return kSuccess;
 }
 
+ErrorCode PTrace::readExtendedCPUState(ProcessThreadId const &ptid,
+                                       ProcessInfo const &pinfo,
+                                       Architecture::CPUState &state) {
+  pid_t pid;
+  CHK(ptidToPid(ptid, pid));
+
+  state.is32 = (pinfo.pointerSize == sizeof(uint32_t));
+
+  //
+  // Read x87, SSE, AVX and AVX-512
+  //
+  ByteVector area;
+  size_t length;
+
+  // TODO: If this fails, it means XSAVE is most likely unsupported. In this
+  // case, we should fallback to FXSAVE and only read the legacy portion of
+  // our xsave state (x87, MMX, SSE).
+  // If this call fails, don't return failure, since AVX may not be available
+  // on this CPU.
+  if (readXSaveArea(pid, area, length) == kSuccess) {
+    DecodeXSaveArea(state, area);
+  }
+
+  return kSuccess;
+}
+
 ErrorCode PTrace::writeCPUState(ProcessThreadId const &ptid,
                                 ProcessInfo const &pinfo,
                                 Architecture::CPUState const &state) {
@@ -337,26 +630,73 @@ ErrorCode PTrace::writeCPUState(ProcessThreadId const &ptid,
     return Platform::TranslateError();
 
   //
-  // Write SSE and AVX
+  // Write x87, SSE, AVX and AVX-512, unless the state came from
+  // readBaseCPUState and doesn't have them.
   //
-  struct xsave_struct xfpregs;
-  struct iovec fpregs_iovec;
-  fpregs_iovec.iov_base = &xfpregs;
-  fpregs_iovec.iov_len = sizeof(xfpregs);
+  if (state.hasExtendedState()) {
+    CHK(writeXSaveArea(pid, state));
+  }
 
+  // Write the debug registers
+  size_t debugRegOffset = offsetof(struct user, u_debugreg);
+  size_t debugRegSize = sizeof(((struct user *)0)->u_debugreg[0]);
+  for (size_t i = 0; i < array_sizeof(state.state64.dr.dr); ++i) {
+    // dr4 and dr5 are reserved and not used
+    if (i == 4 || i == 5) {
+      continue;
+    }
+
+    if (wrapPtrace(PTRACE_POKEUSER, pid, debugRegOffset + i * debugRegSize,
+                   state.is32 ? state.state32.dr.dr[i]
+                              : state.state64.dr.dr[i]) < 0) {
+      return Platform::TranslateError();
+    }
+  }
+
+  return kSuccess;
+}
+
+ErrorCode PTrace::writeCPUState(ProcessThreadId const &ptid,
+                                ProcessInfo const &pinfo,
+                                Architecture::CPUState const &state,
+                                Architecture::CPUState const &previous) {
+  pid_t pid;
+  CHK(ptidToPid(ptid, pid));
+
+  if (state.is32 != previous.is32)
+    return writeCPUState(ptid, pinfo, state);
+
+  //
+  // Convert both states to the kernel layout and only write the sets that
+  // differ; zero everything first so padding doesn't show up as a change.
+  //
+  user_regs_struct gprs, oldGPRs;
+  std::memset(&gprs, 0, sizeof(gprs));
+  std::memset(&oldGPRs, 0, sizeof(oldGPRs));
   if (state.is32) {
-    state32_to_user(xfpregs, state.state32);
+    Architecture::X86::state32_to_user(gprs, state.state32);
+    Architecture::X86::state32_to_user(oldGPRs, previous.state32);
   } else {
-    state64_to_user(xfpregs, state.state64);
+    Architecture::X86::state64_to_user(gprs, state.state64);
+    Architecture::X86::state64_to_user(oldGPRs, previous.state64);
+  }
+
+  if (std::memcmp(&gprs, &oldGPRs, sizeof(gprs)) != 0) {
+    if (wrapPtrace(PTRACE_SETREGS, pid, nullptr, &gprs) < 0)
+      return Platform::TranslateError();
   }
 
-  // TODO: If this fails (i.e. ptrace returns < 0), it means XSAVE is most
-  // likely unsupported and we can't expect XSAVE to work. In this case, we
-  // should fallback to FXSAVE and only write the legacy portion of our xsave
-  // state (x87, MMX, SSE).
-  wrapPtrace(PTRACE_SETREGSET, pid, NT_X86_XSTATE, &fpregs_iovec);
+  if (state.hasExtendedState()) {
+    ByteVector area(GetXSaveLayout().size, 0);
+    ByteVector oldArea(area.size(), 0);
+    EncodeXSaveArea(area, state);
+    EncodeXSaveArea(oldArea, previous);
+
+    if (area != oldArea) {
+      CHK(writeXSaveArea(pid, state));
+    }
+  }
 
-  // Write the debug registers
   size_t debugRegOffset = offsetof(struct user, u_debugreg);
   size_t debugRegSize = sizeof(((struct user *)0)->u_debugreg[0]);
   for (size_t i = 0; i < array_sizeof(state.state64.dr.dr); ++i) {
@@ -365,9 +705,16 @@ ErrorCode PTrace::writeCPUState(ProcessThreadId const &ptid,
       continue;
     }
 
+    uint64_t value =
+        state.is32 ? state.state32.dr.dr[i] : state.state64.dr.dr[i];
+    uint64_t oldValue =
+        state.is32 ? previous.state32.dr.dr[i] : previous.state64.dr.dr[i];
+    if (value == oldValue) {
+      continue;
+    }
+
     if (wrapPtrace(PTRACE_POKEUSER, pid, debugRegOffset + i * debugRegSize,
-                   state.is32 ? state.state32.dr.dr[i]
-                              : state.state64.dr.dr[i]) < 0) {
+                   value) < 0) {
       return Platform::TranslateError();
     }
   }
@@ -24,6 +24,10 @@
 #include <fcntl.h>
 #include <libgen.h>
 #include <poll.h>
+#if defined(OS_LINUX)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -56,7 +60,10 @@ static bool open_terminal(int fds[2]) {
     goto error_fd0;
 #endif
 
-  fds[1] = ::open(slave, O_RDWR);
+  // Like the files below, this would otherwise become our controlling
+  // terminal if we don't have one, and we would get a SIGHUP once the child
+  // closes it.
+  fds[1] = ::open(slave, O_RDWR | O_NOCTTY);
   if (fds[1] == -1)
     goto error_fd0;
 
@@ -74,14 +81,57 @@ static inline void close_terminal(int fds[2]) {
   ::close(fds[1]);
 }
 
+static bool open_wakeup(int fds[2]) {
+#if defined(OS_LINUX)
+  fds[0] = fds[1] = ::eventfd(0, EFD_CLOEXEC);
+  return fds[0] != -1;
+#else
+  if (::pipe(fds) == -1)
+    return false;
+
+  ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  return true;
+#endif
+}
+
+static void close_wakeup(int fds[2]) {
+  if (fds[1] != fds[0])
+    ::close(fds[1]);
+  ::close(fds[0]);
+  fds[0] = fds[1] = -1;
+}
+
+// Size of the buffer output is read into; large enough to empty a pty or
+// pipe buffer in a single read.
+static size_t const kRedirectBufferSize = 64 * 1024;
+
+// Once asked to stop, the redirection thread forwards what is left in the
+// pipes, but no more than this; a background child of the inferior could
+// otherwise keep it alive forever.
+static size_t const kMaxFlushSize = 1024 * 1024;
+
 ProcessSpawner::ProcessSpawner()
-    : _exitStatus(0), _signalCode(0), _pid(0), _shell(false) {}
+    : _exitStatus(0), _signalCode(0), _pid(0), _shell(false) {
+  _wakeupFds[0] = _wakeupFds[1] = -1;
+}
 
 ProcessSpawner::~ProcessSpawner() { flushAndExit(); }
 
-void ProcessSpawner::flushAndExit() {
-  if (_delegateThread.joinable())
-    _delegateThread.join();
+void ProcessSpawner::flushAndExit() { stopRedirectionThread(); }
+
+void ProcessSpawner::stopRedirectionThread() {
+  if (!_delegateThread.joinable())
+    return;
+
+  uint64_t value = 1;
+  if (::write(_wakeupFds[1], &value, sizeof(value)) < 0) {
+    DS2LOG(Warning, "unable to wake redirection thread up: %s",
+           Stringify::Errno(errno));
+  }
+
+  _delegateThread.join();
+  close_wakeup(_wakeupFds);
 }
 
 bool ProcessSpawner::setExecutable(std::string const &path) {
@@ -407,8 +457,18 @@ ErrorCode ProcessSpawner::run(std::function<bool()> preExecAction) {
     }
   }
 
+  if (startRedirectThread && !open_wakeup(_wakeupFds)) {
+    DS2LOG(Error, "failed to create wakeup descriptor: %s",
+           Stringify::Errno(errno));
+    close_terminal(term);
+    return Platform::TranslateError();
+  }
+
   _pid = ::fork();
   if (_pid < 0) {
+    if (startRedirectThread) {
+      close_wakeup(_wakeupFds);
+    }
     close_terminal(term);
     DS2LOG(Error, "failed to fork: %s", Stringify::Errno(errno));
     return Platform::TranslateError();
@@ -551,9 +611,9 @@ ErrorCode ProcessSpawner::wait() {
   }
 
   //
-  // Wait also the termination of the thread.
+  // The process is gone, forward what it left behind and stop the thread.
   //
-  _delegateThread.join();
+  stopRedirectionThread();
 
   _pid = 0;
   if (WIFEXITED(status)) {
@@ -578,69 +638,145 @@ bool ProcessSpawner::isRunning() const {
 //
 // Redirector Thread
 //
+size_t ProcessSpawner::forwardOutput(RedirectDescriptor &descriptor,
+                                    std::vector<char> &buf) {
+  ssize_t nread;
+  do {
+    nread = ::read(descriptor.fd, buf.data(), buf.size());
+  } while (nread < 0 && errno == EINTR);
+
+  // A pty master returns EIO rather than EOF once the other side is closed.
+  if (nread <= 0)
+    return 0;
+
+  if (descriptor.mode == kRedirectBuffer) {
+    _outputBuffer.append(buf.data(), nread);
+  } else {
+    descriptor.delegate(buf.data(), nread);
+  }
+  return nread;
+}
+
 void ProcessSpawner::redirectionThread() {
-  for (;;) {
-    struct pollfd pfds[3];
-    struct pollfd *ppfds = pfds;
-    int nfds = 0;
+  // stdout and stderr share the same terminal when both are redirected, make
+  // sure we only watch it once.
+  RedirectDescriptor *watched[3];
+  size_t nwatched = 0;
+  for (auto &descriptor : _descriptors) {
+    if (descriptor.mode != kRedirectBuffer &&
+        descriptor.mode != kRedirectDelegate)
+      continue;
+
+    bool duplicate = false;
+    for (size_t n = 0; n < nwatched; n++) {
+      duplicate |= (watched[n]->fd == descriptor.fd);
+    }
+    if (!duplicate) {
+      watched[nwatched++] = &descriptor;
+    }
+  }
+
+#if defined(OS_LINUX)
+  int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) {
+    DS2LOG(Error, "unable to create epoll instance: %s",
+           Stringify::Errno(errno));
+    nwatched = 0;
+  } else {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, _wakeupFds[0], &ev);
+    for (size_t n = 0; n < nwatched; n++) {
+      ev.data.ptr = watched[n];
+      ::epoll_ctl(epollFd, EPOLL_CTL_ADD, watched[n]->fd, &ev);
+    }
+  }
+#endif
 
+  std::vector<char> buf(kRedirectBufferSize);
+  size_t flushed = 0;
+  bool stopping = false;
+
+  while (nwatched > 0 && flushed < kMaxFlushSize) {
+    RedirectDescriptor *ready[3];
+    size_t nready = 0;
+    bool wakeup = false;
+    // Once stopping, only forward what is already there.
+    int timeout = stopping ? 0 : -1;
+
+#if defined(OS_LINUX)
+    struct epoll_event events[4];
+    int nfds = ::epoll_wait(epollFd, events, 4, timeout);
+    for (int n = 0; n < nfds; n++) {
+      if (events[n].data.ptr == nullptr) {
+        wakeup = true;
+      } else {
+        ready[nready++] =
+            static_cast<RedirectDescriptor *>(events[n].data.ptr);
+      }
+    }
+#else
+    struct pollfd pfds[4];
     std::memset(pfds, 0, sizeof(pfds));
-    for (size_t n = 0; n < 3; n++) {
-      switch (_descriptors[n].mode) {
-      case kRedirectBuffer:
-      case kRedirectDelegate:
-        ppfds->fd = _descriptors[n].fd;
-        ppfds->events = (n == 0) ? POLLOUT : POLLIN;
-        ppfds++;
-        nfds++;
-        break;
+    for (size_t n = 0; n < nwatched; n++) {
+      pfds[n].fd = watched[n]->fd;
+      pfds[n].events = POLLIN;
+    }
+    pfds[nwatched].fd = stopping ? -1 : _wakeupFds[0];
+    pfds[nwatched].events = POLLIN;
 
-      default:
-        break;
+    int nfds = ::poll(pfds, nwatched + 1, timeout);
+    for (size_t n = 0; nfds > 0 && n < nwatched; n++) {
+      if (pfds[n].revents != 0) {
+        ready[nready++] = watched[n];
       }
     }
+    wakeup = (nfds > 0 && pfds[nwatched].revents != 0);
+#endif
+
+    if (nfds < 0) {
+      if (errno == EINTR)
+        continue;
+      DS2LOG(Error, "unable to wait for output: %s", Stringify::Errno(errno));
+      break;
+    }
 
-    nfds = ::poll(pfds, nfds, 100);
-    if (nfds < 0)
+    if (nfds == 0)
       break;
 
-    bool done = false;
-    bool hup = false;
-    for (int n = 0; n < nfds; n++) {
-      if (pfds[n].revents & POLLHUP) {
-        hup = true;
+    if (wakeup) {
+      stopping = true;
+#if defined(OS_LINUX)
+      ::epoll_ctl(epollFd, EPOLL_CTL_DEL, _wakeupFds[0], nullptr);
+#endif
+    }
+
+    for (size_t n = 0; n < nready; n++) {
+      size_t nread = forwardOutput(*ready[n], buf);
+      if (nread > 0) {
+        flushed += stopping ? nread : 0;
+        continue;
       }
 
-      RedirectDescriptor *descriptor = nullptr;
-      for (int index = 0; index < 3; index++) {
-        if (_descriptors[index].fd == pfds[n].fd &&
-            (_descriptors[index].mode == kRedirectBuffer ||
-             _descriptors[index].mode == kRedirectDelegate)) {
-          descriptor = &_descriptors[index];
+      // The inferior side is closed, stop watching this descriptor.
+#if defined(OS_LINUX)
+      ::epoll_ctl(epollFd, EPOLL_CTL_DEL, ready[n]->fd, nullptr);
+#endif
+      for (size_t m = 0; m < nwatched; m++) {
+        if (watched[m] == ready[n]) {
+          watched[m] = watched[--nwatched];
           break;
         }
       }
-      DS2ASSERT(descriptor != nullptr);
-
-      if (pfds[n].events & POLLIN) {
-        if (pfds[n].revents & POLLIN) {
-          char buf[128];
-          ssize_t nread = ::read(pfds[n].fd, buf, sizeof(buf));
-          if (nread > 0) {
-            if (descriptor->mode == kRedirectBuffer) {
-              _outputBuffer.insert(_outputBuffer.end(), &buf[0], &buf[nread]);
-            } else {
-              descriptor->delegate(buf, nread);
-            }
-            done = true;
-          }
-        }
-      }
     }
+  }
 
-    if (!done && hup)
-      break;
+#if defined(OS_LINUX)
+  if (epollFd >= 0) {
+    ::close(epollFd);
   }
+#endif
 
   for (auto &_descriptor : _descriptors) {
     if (_descriptor.fd != -1) {
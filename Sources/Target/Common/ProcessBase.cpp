@@ -143,7 +143,7 @@ ErrorCode ProcessBase::resume(int signal, std::set<Thread *> const &excluded) {
     case Thread::kStopped:
     case Thread::kStepped: {
       Architecture::CPUState state;
-      thread->readCPUState(state);
+      thread->readBaseCPUState(state);
       DS2LOG(Debug,
              "resuming tid %" PRI_PID " in state %s from pc %" PRI_PTR
              " with signal %d",
@@ -188,6 +188,15 @@ void ProcessBase::getThreadIds(std::vector<ThreadId> &tids) {
   }
 }
 
+ErrorCode ProcessBase::getProfileData(ProfileData &data) {
+  return kErrorUnsupported;
+}
+
+ErrorCode ProcessBase::saveCore(std::string const &pathHint,
+                                std::string &path) {
+  return kErrorUnsupported;
+}
+
 ds2::Target::Thread *ProcessBase::thread(ThreadId tid) const {
   auto it = _threads.find(tid);
   return (it == _threads.end()) ? nullptr : it->second;
@@ -228,15 +237,26 @@ ErrorCode ProcessBase::readMemoryBuffer(Address const &address, size_t length,
   return kSuccess;
 }
 
-ErrorCode ProcessBase::writeMemoryBuffer(Address const &address,
-                                         ByteVector const &buffer,
-                                         size_t *nwritten) {
+ErrorCode ProcessBase::readMemoryRanges(MemoryRange::Collection const &ranges,
+                                        std::vector<ByteVector> &buffers) {
   if (_pid == kAnyProcessId)
     return kErrorProcessNotFound;
-  else if (!address.valid())
-    return kErrorInvalidArgument;
 
-  return writeMemory(address, buffer.data(), buffer.size(), nwritten);
+  buffers.resize(ranges.size());
+  for (size_t n = 0; n < ranges.size(); n++) {
+    if (readMemoryBuffer(ranges[n].start, ranges[n].length, buffers[n]) !=
+        kSuccess) {
+      buffers[n].clear();
+    }
+  }
+
+  return kSuccess;
+}
+
+ErrorCode ProcessBase::writeMemoryBuffer(Address const &address,
+                                         ByteVector const &buffer,
+                                         size_t *nwritten) {
+  return writeMemoryBuffer(address, buffer, buffer.size(), nwritten);
 }
 
 ErrorCode ProcessBase::writeMemoryBuffer(Address const &address,
@@ -251,6 +271,11 @@ ErrorCode ProcessBase::writeMemoryBuffer(Address const &address,
     length = buffer.size();
   }
 
+#if defined(ARCH_ARM) || defined(ARCH_ARM64)
+  // The debugger may be patching code we have already decoded.
+  _singleStepCache.invalidate(address.value(), length);
+#endif
+
   return writeMemory(address, buffer.data(), length, nwritten);
 }
 
@@ -23,6 +23,10 @@ ThreadBase::ThreadBase(Process *process, ThreadId tid)
   _process->insert(this);
 }
 
+ErrorCode ThreadBase::readBaseCPUState(Architecture::CPUState &state) {
+  return readCPUState(state);
+}
+
 ErrorCode ThreadBase::modifyRegisters(
     std::function<void(Architecture::CPUState &state)> action) {
   Architecture::CPUState state;
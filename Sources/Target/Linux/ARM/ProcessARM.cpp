@@ -269,7 +269,7 @@ ErrorCode Process::allocateMemory(size_t size, uint32_t protection,
   // We need to know if the process is running in Thumb or ARM mode.
   //
   Architecture::CPUState state;
-  CHK(ptrace().readCPUState(_currentThread->tid(), info, state));
+  CHK(_currentThread->readCPUState(state));
 
   int POSIXProtection = convertMemoryProtectionToPOSIX(protection);
 
@@ -304,7 +304,7 @@ ErrorCode Process::deallocateMemory(uint64_t address, size_t size) {
   // We need to know if the process is running in Thumb or ARM mode.
   //
   Architecture::CPUState state;
-  CHK(ptrace().readCPUState(_currentThread->tid(), info, state));
+  CHK(_currentThread->readCPUState(state));
 
   ByteVector codestr;
   if (state.isThumb()) {
@@ -322,8 +322,7 @@ ErrorCode Process::deallocateMemory(uint64_t address, size_t size) {
   // Code inject and execute
   //
   uint64_t result = 0;
-  CHK(ptrace().execute(_currentThread->tid(), info, &codestr[0], codestr.size(),
-                       result));
+  CHK(executeCode(codestr, result));
 
   if ((int)result < 0) {
     int error = -result;
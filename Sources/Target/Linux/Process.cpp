@@ -9,7 +9,9 @@
 //
 
 #include "DebugServer2/Target/Process.h"
+#include "DebugServer2/Core/AgentExpression.h"
 #include "DebugServer2/Core/BreakpointManager.h"
+#include "DebugServer2/Core/SoftwareBreakpointManager.h"
 #include "DebugServer2/Host/Linux/ExtraWrappers.h"
 #include "DebugServer2/Host/Linux/PTrace.h"
 #include "DebugServer2/Host/Linux/ProcFS.h"
@@ -19,18 +21,23 @@
 #include "DebugServer2/Utils/String.h"
 #include "DebugServer2/Utils/Stringify.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
 #include <elf.h>
 #include <limits>
+#include <set>
 #include <sys/ptrace.h>
 #include <sys/wait.h>
+#include <time.h>
 #if defined(HAVE_PROCESS_VM_READV) || defined(HAVE_PROCESS_VM_WRITEV)
 #include <sys/uio.h>
 #endif
 #include <unistd.h>
+#include <vector>
 
 using ds2::Host::Platform;
 using ds2::Host::Linux::ProcFS;
@@ -43,46 +50,31 @@ namespace ds2 {
 namespace Target {
 namespace Linux {
 
+Process::Process()
+    : super(), _followForks(false), _followVForks(false), _pendingVForks(0) {}
+
+static pid_t blocking_waitpid(pid_t pid, int *status, int flags) {
+  pid_t ret;
+  do {
+    ret = ::waitpid(pid, status, flags);
+  } while (ret == -1 && errno == EINTR);
+
+  return ret;
+}
+
 ErrorCode Process::attach(int waitStatus) {
+  int signal = 0;
+
   if (waitStatus <= 0) {
     CHK(ptrace().attach(_pid));
     _flags |= kFlagAttachedProcess;
     CHK(ptrace().wait(_pid, &waitStatus));
+    CHK(waitAttachStop(_pid, waitStatus, signal));
     ptrace().traceThat(_pid);
   }
 
   if (_flags & kFlagAttachedProcess) {
-    //
-    // Enumerate all the tasks and create a Thread
-    // object for every entry.
-    //
-    bool keepGoing = true;
-
-    //
-    // Try to find threads of the newly attached process in multiple
-    // rounds so that we avoid race conditions with threads being
-    // created before we stop the creator.
-    //
-    while (keepGoing) {
-      keepGoing = false;
-
-      ProcFS::EnumerateThreads(_pid, [&](pid_t tid) {
-        //
-        // Attach the thread to the debugger and wait
-        //
-        if (thread(tid) != nullptr || tid == _pid)
-          return;
-
-        keepGoing = true;
-        auto thread = new Thread(this, tid);
-        if (ptrace().attach(tid) == kSuccess) {
-          int status;
-          ptrace().wait(tid, &status);
-          ptrace().traceThat(tid);
-          thread->updateStopInfo(status);
-        }
-      });
-    }
+    CHK(attachThreads());
   }
 
   //
@@ -90,22 +82,299 @@ ErrorCode Process::attach(int waitStatus) {
   //
   _currentThread = new Thread(this, _pid);
   _currentThread->updateStopInfo(waitStatus);
+  if (signal != 0) {
+    _currentThread->_stopInfo.signal = signal;
+    _currentThread->_stopInfo.reason = StopInfo::kReasonSignalStop;
+  }
 
   return kSuccess;
 }
 
-static pid_t blocking_waitpid(pid_t pid, int *status, int flags) {
-  pid_t ret;
-  do {
-    ret = ::waitpid(pid, status, flags);
-  } while (ret == -1 && errno == EINTR);
+//
+// PTrace::attach leaves an interrupt pending on `tid` (a SIGSTOP on kernels
+// without PTRACE_SEIZE), but a seized thread can report other stops first: a
+// signal, or an event of the clone(2) or fork(2) call it was in. The thread
+// is restarted past those until its PTRACE_EVENT_STOP comes. `status` is the
+// first stop on input and the attach stop on output; the signal of a
+// signal-delivery-stop is returned in `signal`, to be reported instead.
+//
+ErrorCode Process::waitAttachStop(pid_t tid, int &status, int &signal) {
+  signal = 0;
 
-  return ret;
+  while (WIFSTOPPED(status)) {
+    int event = status >> 16;
+    if (event == PTRACE_EVENT_STOP ||
+        (event == 0 && WSTOPSIG(status) == SIGSTOP)) {
+      break;
+    }
+
+    ProcessThreadId ptid(_pid, tid);
+    if (event == PTRACE_EVENT_FORK || event == PTRACE_EVENT_VFORK) {
+      // The debugger can't have asked for fork events yet.
+      unsigned long childPid;
+      if (ptrace().getEventMessage(ptid, childPid) == kSuccess) {
+        detachChild(static_cast<ProcessId>(childPid));
+      }
+    } else if (event == 0 && signal == 0) {
+      signal = WSTOPSIG(status);
+    }
+
+    DS2LOG(Debug, "tid %d stopped before its attach stop, %s", tid,
+           Stringify::WaitStatus(status));
+
+    // That stop consumed the interrupt; a new one is reported as soon as the
+    // thread runs again, before it gets back to user space. Threads attached
+    // without PTRACE_SEIZE fail this, and still have their SIGSTOP queued.
+    ptrace().interrupt(ptid);
+
+    ProcessInfo info;
+    CHK(getInfo(info));
+    CHK(ptrace().resume(ptid, info));
+    if (blocking_waitpid(tid, &status, __WALL) != tid) {
+      return kErrorProcessNotFound;
+    }
+  }
+
+  return kSuccess;
+}
+
+//
+// Attaches to every thread of the process besides the main one, and creates
+// a Thread object for each of them. All the threads found in a scan of the
+// task directory are interrupted before waiting for any of them, and the
+// directory is scanned again until it doesn't change, since threads we
+// haven't reached yet can still create new ones.
+//
+ErrorCode Process::attachThreads() {
+  std::set<pid_t> tried;
+  std::set<pid_t> pending;
+  std::vector<pid_t> tids;
+  bool keepGoing = true;
+
+  tried.insert(_pid);
+
+  while (keepGoing) {
+    keepGoing = false;
+
+    if (!ProcFS::ReadThreadIds(_pid, tids)) {
+      return kErrorProcessNotFound;
+    }
+
+    for (auto tid : tids) {
+      if (!tried.insert(tid).second) {
+        continue;
+      }
+
+      // This fails for threads that exited already, and for threads that
+      // were cloned by one we already traced, which are attached
+      // automatically and get picked up below or by Process::wait.
+      keepGoing = true;
+      if (ptrace().attach(tid) == kSuccess) {
+        pending.insert(tid);
+      }
+    }
+  }
+
+  DS2LOG(Debug, "attaching to %zu threads", pending.size());
+
+  while (!pending.empty()) {
+    int status;
+    pid_t tid = blocking_waitpid(-1, &status, __WALL);
+    if (tid <= 0) {
+      DS2LOG(Error, "failed to wait for %zu threads, error=%s", pending.size(),
+             Stringify::Errno(errno));
+      return kErrorProcessNotFound;
+    }
+
+    int signal = 0;
+    if (pending.erase(tid) != 0) {
+      CHK(waitAttachStop(tid, status, signal));
+    }
+
+    auto threadIt = _threads.find(tid);
+    if (WIFEXITED(status) || WIFSIGNALED(status)) {
+      if (threadIt != _threads.end()) {
+        removeThread(tid);
+      }
+      continue;
+    }
+
+    if (threadIt == _threads.end() && stashChildStop(tid, status)) {
+      continue;
+    }
+
+    // Threads attached without PTRACE_SEIZE still need their options.
+    if (status >> 16 != PTRACE_EVENT_STOP) {
+      ptrace().traceThat(tid);
+    }
+
+    Thread *thread =
+        threadIt != _threads.end() ? threadIt->second : new Thread(this, tid);
+    thread->updateStopInfo(status);
+    if (signal != 0) {
+      thread->_stopInfo.signal = signal;
+      thread->_stopInfo.reason = StopInfo::kReasonSignalStop;
+    }
+  }
+
+  return kSuccess;
+}
+
+// A stop from a task we don't know about is either a new thread, or the
+// initial stop of a child created by fork(2) or vfork(2), which can be
+// collected before the fork event of its parent. The stops of children are
+// kept until Process::Adopt picks them up.
+bool Process::stashChildStop(pid_t tid, int status) {
+  ProcFS::Stat stat;
+  if (ProcFS::ReadStat(_pid, tid, stat)) {
+    return false;
+  }
+
+  DS2LOG(Debug, "child %d stopped before the fork event of its parent", tid);
+  _childStops[tid] = status;
+  return true;
+}
+
+ds2::Target::Process *Process::Adopt(ProcessId pid, Process *parent) {
+  int status;
+  auto it = parent->_childStops.find(pid);
+  if (it != parent->_childStops.end()) {
+    status = it->second;
+    parent->_childStops.erase(it);
+  } else if (blocking_waitpid(pid, &status, __WALL) != pid) {
+    DS2LOG(Error, "failed to wait for child %d, error=%s", pid,
+           Stringify::Errno(errno));
+    return nullptr;
+  }
+
+  if (!WIFSTOPPED(status)) {
+    DS2LOG(Warning, "child %d is gone, %s", pid, Stringify::WaitStatus(status));
+    return nullptr;
+  }
+
+  // The child is traced with the options of its parent already, and isn't
+  // waited for again by POSIX::Process::initialize.
+  auto process = ds2::make_unique<Target::Process>();
+  if (process->ProcessBase::initialize(pid, parent->_flags) != kSuccess ||
+      process->attach(status) != kSuccess) {
+    return nullptr;
+  }
+
+  process->softwareBreakpointManager()->inherit(
+      *parent->softwareBreakpointManager());
+
+  return process.release();
+}
+
+void Process::detachChild(ProcessId pid) {
+  DS2LOG(Debug, "detaching from child %d", pid);
+
+  std::unique_ptr<ds2::Target::Process> child(Adopt(pid, this));
+  ErrorCode error =
+      (child != nullptr) ? child->detach() : ptrace().detach(pid);
+  if (error != kSuccess) {
+    DS2LOG(Warning, "unable to detach from child %d, error=%s", pid,
+           Stringify::Error(error));
+  }
+}
+
+// Handles a fork, vfork or vfork-done stop of `thread` while the process is
+// running. Returns true if the debugger wants to see it; otherwise the child,
+// if any, has been detached and the caller restarts the thread.
+bool Process::handleForkEvent(Thread *thread) {
+  StopInfo const &info = thread->_stopInfo;
+  BreakpointManager *bpm = softwareBreakpointManager();
+
+  if (info.reason == StopInfo::kReasonVForkDone) {
+    // The child doesn't use our memory anymore.
+    if (_pendingVForks > 0 && --_pendingVForks == 0) {
+      bpm->enable();
+    }
+    return _followVForks;
+  }
+
+  bool vfork = (info.reason == StopInfo::kReasonVFork);
+  if (vfork && _pendingVForks++ == 0) {
+    // The child runs in our address space until it calls execve(2) or exits,
+    // and must not trap on our breakpoints in the meantime.
+    bpm->disable();
+  }
+
+  if (vfork ? _followVForks : _followForks) {
+    return true;
+  }
+
+  detachChild(info.childPid);
+  return false;
+}
+
+#if defined(HAVE_PROCESS_VM_READV)
+// Reads up to this size are served from the page cache. While unwinding,
+// the debugger walks up the stack one frame at a time, so stack misses fetch
+// a few pages more in that direction.
+static size_t const kMaxCachedReadSize = 512;
+static size_t const kStackPrefetchPages = 4;
+static size_t const kStackWindowSize = 1024 * 1024;
+
+bool Process::fillMemoryCache(uint64_t address, size_t length) {
+  size_t pageSize = _memoryCache.pageSize();
+  uint64_t mask = ~static_cast<uint64_t>(pageSize - 1);
+  uint64_t start = address & mask;
+  uint64_t end = (address + length + pageSize - 1) & mask;
+  if (end <= start) {
+    return false;
+  }
+
+  if (!_stackHint.valid()) {
+    Architecture::CPUState state;
+    if (_currentThread != nullptr &&
+        _currentThread->readBaseCPUState(state) == kSuccess) {
+      _stackHint = state.sp();
+    } else {
+      _stackHint = 0;
+    }
+  }
+
+  uint64_t sp = _stackHint.value() & mask;
+  if (sp != 0 && address >= sp && address - sp < kStackWindowSize) {
+    end = std::max<uint64_t>(end, start + kStackPrefetchPages * pageSize);
+  }
+
+  ByteVector buffer(end - start);
+  struct iovec local_iov = {buffer.data(), buffer.size()};
+  struct iovec remote_iov = {reinterpret_cast<void *>(start), buffer.size()};
+  auto id = _currentThread == nullptr ? _pid : _currentThread->tid();
+
+  // Prefetched pages may not be mapped, keep whatever we got.
+  ssize_t ret = process_vm_readv(id, &local_iov, 1, &remote_iov, 1, 0);
+  if (ret <= 0) {
+    return false;
+  }
+
+  _memoryCache.insert(start, buffer.data(), ret);
+  return true;
+}
+#endif
+
+void Process::flushMemoryCache() {
+  _memoryCache.clear();
+  _stackHint.clear();
 }
 
 ErrorCode Process::readMemory(Address const &address, void *data, size_t length,
                               size_t *count) {
 #if defined(HAVE_PROCESS_VM_READV)
+  if (length > 0 && length <= kMaxCachedReadSize) {
+    if (_memoryCache.read(address, data, length) ||
+        (fillMemoryCache(address, length) &&
+         _memoryCache.read(address, data, length))) {
+      if (count != nullptr) {
+        *count = length;
+      }
+      return kSuccess;
+    }
+  }
+
   // Using process_vm_readv() is faster than using ptrace() because we can do
   // bigger reads that ptrace() (which can only read a word at a time); the
   // drawback is that process_vm_readv() cannot bypass page-level permissions
@@ -134,8 +403,69 @@ ErrorCode Process::readMemory(Address const &address, void *data, size_t length,
   return super::readMemory(address, data, length, count);
 }
 
+ErrorCode Process::readMemoryRanges(MemoryRange::Collection const &ranges,
+                                    std::vector<ByteVector> &buffers) {
+#if defined(HAVE_PROCESS_VM_READV)
+  buffers.resize(ranges.size());
+
+  auto id = _currentThread == nullptr ? _pid : _currentThread->tid();
+  std::vector<struct iovec> localIov;
+  std::vector<struct iovec> remoteIov;
+
+  //
+  // process_vm_readv() reads the remote ranges in order and stops at the
+  // first one it can't read entirely. Everything before that point is done;
+  // the faulting range goes through ptrace(2), then we resume the batch
+  // right after it.
+  //
+  size_t first = 0;
+  while (first < ranges.size()) {
+    size_t last = std::min(ranges.size(), first + IOV_MAX);
+
+    localIov.clear();
+    remoteIov.clear();
+    for (size_t n = first; n < last; n++) {
+      buffers[n].resize(ranges[n].length);
+      localIov.push_back({buffers[n].data(), ranges[n].length});
+      remoteIov.push_back(
+          {reinterpret_cast<void *>(ranges[n].start.value()),
+           ranges[n].length});
+    }
+
+    ssize_t ret = process_vm_readv(id, localIov.data(), localIov.size(),
+                                   remoteIov.data(), remoteIov.size(), 0);
+    size_t remaining = (ret < 0) ? 0 : ret;
+
+    while (first < last && remaining >= ranges[first].length) {
+      remaining -= ranges[first].length;
+      first++;
+    }
+
+    if (first == last) {
+      continue;
+    }
+
+    // If ptrace(2) fails too, keep whatever process_vm_readv() got.
+    size_t nread = 0;
+    if (super::readMemory(ranges[first].start, buffers[first].data(),
+                          ranges[first].length, &nread) != kSuccess) {
+      nread = remaining;
+    }
+    buffers[first].resize(nread);
+    first++;
+  }
+
+  return kSuccess;
+#else
+  return super::readMemoryRanges(ranges, buffers);
+#endif
+}
+
 ErrorCode Process::writeMemory(Address const &address, void const *data,
                                size_t length, size_t *count) {
+  ErrorCode error = kErrorUnknown;
+  size_t nwritten = 0;
+
 #if defined(HAVE_PROCESS_VM_WRITEV)
   // See comment in Process::readMemory.
   if (length > sizeof(uintptr_t)) {
@@ -146,16 +476,30 @@ ErrorCode Process::writeMemory(Address const &address, void const *data,
 
     ssize_t ret = process_vm_writev(id, &local_iov, 1, &remote_iov, 1, 0);
     if (ret >= 0) {
-      if (count != nullptr) {
-        *count = ret;
-      }
-      return kSuccess;
+      nwritten = ret;
+      error = kSuccess;
     }
   }
 #endif
 
   // Fallback to super::writeMemory, which uses ptrace(2).
-  return super::writeMemory(address, data, length, count);
+  if (error != kSuccess) {
+    error = super::writeMemory(address, data, length, &nwritten);
+  }
+
+  // Write through to the cache. On failure we don't know what made it to
+  // the inferior, so forget the whole range.
+  if (error == kSuccess && nwritten == length) {
+    _memoryCache.update(address, data, length);
+  } else {
+    _memoryCache.invalidate(address, length);
+  }
+
+  if (error == kSuccess && count != nullptr) {
+    *count = nwritten;
+  }
+
+  return error;
 }
 
 ErrorCode Process::checkMemoryErrorCode(uint64_t address) {
@@ -171,11 +515,236 @@ ErrorCode Process::checkMemoryErrorCode(uint64_t address) {
   return kSuccess;
 }
 
+ErrorCode Process::suspend() {
+  std::set<Thread *> pending;
+  std::set<ThreadId> exited;
+
+  // Signal every running thread first, and only then collect the stop
+  // notifications: the threads stop concurrently and we pay for a single
+  // round of waitpid(2) calls instead of a kill/wait pair per thread. We
+  // trust the state we track for each thread rather than reading it back
+  // from /proc, since every transition goes through ptrace or waitpid.
+  for (auto const &it : _threads) {
+    Thread *thread = it.second;
+
+    switch (thread->_state) {
+    case Thread::kInvalid:
+      DS2BUG("trying to suspend tid %" PRI_PID " in state %s", thread->tid(),
+             Stringify::ThreadState(thread->_state));
+      break;
+
+    case Thread::kStepped:
+    case Thread::kStopped:
+      break;
+
+    case Thread::kTerminated:
+      exited.insert(thread->tid());
+      break;
+
+    case Thread::kRunning: {
+      ErrorCode error = ptrace().suspend(ProcessThreadId(_pid, thread->tid()));
+      if (error == kSuccess) {
+        pending.insert(thread);
+      } else if (error == kErrorProcessNotFound) {
+        // The thread is already gone and has been reaped. If it hasn't,
+        // Process::wait will ignore its exit status.
+        DS2LOG(Debug, "tried to suspend tid %" PRI_PID " which is already dead",
+               thread->tid());
+        exited.insert(thread->tid());
+      } else {
+        DS2LOG(Warning, "failed suspending tid %" PRI_PID ", error=%s",
+               thread->tid(), Stringify::Error(error));
+        return error;
+      }
+    } break;
+    }
+  }
+
+  DS2LOG(Debug, "suspending %zu threads", pending.size());
+
+  while (!pending.empty()) {
+    int status;
+    ThreadId tid = blocking_waitpid(-1, &status, __WALL);
+    if (tid <= 0) {
+      DS2LOG(Error, "failed to wait for %zu threads, error=%s", pending.size(),
+             Stringify::Errno(errno));
+      return kErrorProcessNotFound;
+    }
+
+    auto threadIt = _threads.find(tid);
+    if (threadIt == _threads.end()) {
+      // A thread spawned after we started signaling others; it starts in
+      // the stopped state so there is nothing to wait for.
+      if (!(WIFEXITED(status) || WIFSIGNALED(status)) &&
+          !stashChildStop(tid, status)) {
+        DS2LOG(Debug, "creating new thread tid=%" PRI_PID, tid);
+        new Thread(this, tid);
+      }
+      continue;
+    }
+
+    Thread *thread = threadIt->second;
+    thread->updateStopInfo(status);
+    pending.erase(thread);
+
+    if (thread->_state == Thread::kTerminated) {
+      exited.insert(tid);
+    }
+  }
+
+  for (auto tid : exited) {
+    removeThread(tid);
+  }
+
+  return _threads.empty() ? kErrorProcessNotFound : kSuccess;
+}
+
+// Returns true if `thread` stopped on a conditional software breakpoint and
+// none of the conditions hold. The thread's PC is moved back to the
+// breakpoint address, which is returned in `address`.
+bool Process::breakpointConditionFailed(Thread *thread, Address &address) {
+  SoftwareBreakpointManager *bpm = softwareBreakpointManager();
+  if (bpm == nullptr || !bpm->hasConditions()) {
+    return false;
+  }
+
+  BreakpointManager::Site site;
+  if (bpm->hit(thread, site) < 0 || site.conditions.empty()) {
+    return false;
+  }
+
+  for (auto const &condition : site.conditions) {
+    uint64_t result;
+    ErrorCode error = AgentExpression::Evaluate(condition, thread, result);
+    if (error != kSuccess) {
+      // Let the debugger decide what to do with a condition we can't
+      // evaluate.
+      DS2LOG(Debug, "cannot evaluate condition at %" PRI_PTR ", error=%s",
+             PRI_PTR_CAST(site.address.value()), Stringify::Error(error));
+      return false;
+    }
+
+    if (result != 0) {
+      return false;
+    }
+  }
+
+  DS2LOG(Debug, "condition false at %" PRI_PTR " for tid %" PRI_PID,
+         PRI_PTR_CAST(site.address.value()), thread->tid());
+  address = site.address;
+  return true;
+}
+
+// Executes the instruction under the breakpoint at `address` and lets the
+// process run again. Other threads must not run past the breakpoint while it
+// is lifted, so they are stopped for the duration of the step. If one of them
+// reported an event in the meantime, everything is left stopped and that
+// thread is returned in `reported`.
+ErrorCode Process::stepOverBreakpoint(Thread *thread, Address const &address,
+                                      Thread *&reported) {
+  std::set<ThreadId> running;
+  std::set<ThreadId> known;
+
+  reported = nullptr;
+
+  for (auto const &it : _threads) {
+    known.insert(it.first);
+    if (it.second->_state == Thread::kRunning) {
+      running.insert(it.first);
+    }
+  }
+
+  CHK(suspend());
+
+  SoftwareBreakpointManager *bpm = softwareBreakpointManager();
+  CHK(bpm->disableSite(address));
+
+  ErrorCode error = thread->step();
+  if (error == kSuccess) {
+    int status;
+    if (blocking_waitpid(thread->tid(), &status, __WALL) == thread->tid()) {
+      thread->updateStopInfo(status);
+    } else {
+      error = kErrorProcessNotFound;
+    }
+  }
+
+  CHK(bpm->enableSite(address));
+  if (error != kSuccess) {
+    return error;
+  }
+
+  auto isPassthru = [this](Thread *candidate) {
+    return candidate->_stopInfo.event == StopInfo::kEventStop &&
+           _passthruSignals.find(candidate->_stopInfo.signal) !=
+               _passthruSignals.end();
+  };
+
+  switch (thread->_stopInfo.event) {
+  case StopInfo::kEventExit:
+  case StopInfo::kEventKill:
+    if (thread->tid() == _pid && _threads.size() == 1) {
+      reported = thread;
+      return kSuccess;
+    }
+    removeThread(thread->tid());
+    thread = nullptr;
+    break;
+
+  case StopInfo::kEventStop:
+    if (thread->_stopInfo.reason != StopInfo::kReasonTrace &&
+        !isPassthru(thread)) {
+      reported = thread;
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  for (auto tid : running) {
+    auto it = _threads.find(tid);
+    if (reported == nullptr && it != _threads.end() &&
+        it->second->_stopInfo.event == StopInfo::kEventStop &&
+        !isPassthru(it->second)) {
+      reported = it->second;
+    }
+  }
+
+  if (reported != nullptr) {
+    // The stepping thread must not look like it was stepped by the debugger.
+    if (thread != nullptr && thread != reported) {
+      thread->_stopInfo.event = StopInfo::kEventNone;
+      thread->_stopInfo.reason = StopInfo::kReasonNone;
+    }
+    return kSuccess;
+  }
+
+  if (thread != nullptr) {
+    CHK(thread->resume(isPassthru(thread) ? thread->_stopInfo.signal : 0));
+  }
+
+  for (auto const &it : _threads) {
+    Thread *other = it.second;
+    if (other == thread ||
+        (known.count(it.first) != 0 && running.count(it.first) == 0)) {
+      continue;
+    }
+
+    // Threads we stopped, or that were spawned while we were stopping them.
+    other->resume(isPassthru(other) ? other->_stopInfo.signal : 0);
+  }
+
+  return kSuccess;
+}
+
 ErrorCode Process::wait() {
   int status, signal;
   bool stepping;
   ProcessInfo info;
   ThreadId tid;
+  Address address;
+  Thread *reported;
 
   // We have at least one thread when we start waiting on a process.
   DS2ASSERT(!_threads.empty());
@@ -186,6 +755,9 @@ ErrorCode Process::wait() {
       return kErrorProcessNotFound;
     }
 
+    // Other threads may still be running, anything cached so far is stale.
+    flushMemoryCache();
+
     DS2LOG(Debug, "tid %" PRI_PID " %s", tid, Stringify::WaitStatus(status));
 
     auto threadIt = _threads.find(tid);
@@ -195,15 +767,24 @@ ErrorCode Process::wait() {
       // WIFSIGNALED() status (i.e.: it terminated), it means we already
       // cleaned up the thread object (e.g.: in Process::suspend), but we
       // hadn't waitpid()'d it yet. Avoid re-creating a Thread object here.
-      if (WIFEXITED(status) || WIFSIGNALED(status)) {
+      if (WIFEXITED(status) || WIFSIGNALED(status) ||
+          stashChildStop(tid, status)) {
         goto continue_waiting;
       }
 
-      // A new thread has appeared that we didn't know about. Create the
-      // Thread object and return.
+      // A new thread has appeared that we didn't know about. Its parent
+      // reported the clone event separately and has already been restarted,
+      // so register the thread, arm its hardware breakpoints and let it run
+      // without stopping the rest of the process.
       DS2LOG(Debug, "creating new thread tid=%d", tid);
       _currentThread = new Thread(this, tid);
-      return kSuccess;
+      _currentThread->beforeResume();
+      ErrorCode error = _currentThread->resume();
+      if (error != kSuccess) {
+        DS2LOG(Warning, "failed resuming new thread tid=%d, error=%s", tid,
+               Stringify::Error(error));
+      }
+      goto continue_waiting;
     } else {
       _currentThread = threadIt->second;
     }
@@ -304,11 +885,41 @@ ErrorCode Process::wait() {
       DS2LOG(Debug, "stopped tid=%" PRI_PID " status=%#x signal=%s", tid,
              status, Stringify::Signal(signal));
 
-      if (_passthruSignals.find(signal) != _passthruSignals.end()) {
+      if (_currentThread->_stopInfo.reason == StopInfo::kReasonFork ||
+          _currentThread->_stopInfo.reason == StopInfo::kReasonVFork ||
+          _currentThread->_stopInfo.reason == StopInfo::kReasonVForkDone) {
+        if (handleForkEvent(_currentThread)) {
+          break;
+        }
+        if (stepping) {
+          _currentThread->step();
+        } else {
+          _currentThread->resume();
+        }
+        goto continue_waiting;
+      } else if (_passthruSignals.find(signal) != _passthruSignals.end()) {
         DS2LOG(Debug, "%s passed through to thread %" PRI_PID ", not stopping",
                Stringify::Signal(signal), tid);
         _currentThread->resume(signal);
         goto continue_waiting;
+      } else if (!stepping &&
+                 _currentThread->_stopInfo.reason ==
+                     StopInfo::kReasonBreakpoint &&
+                 breakpointConditionFailed(_currentThread, address)) {
+        //
+        // Conditional breakpoint whose condition doesn't hold, step over it
+        // without bothering the debugger.
+        //
+        if (stepOverBreakpoint(_currentThread, address, reported) !=
+            kSuccess) {
+          break;
+        }
+        if (reported == nullptr) {
+          goto continue_waiting;
+        }
+        _currentThread = reported;
+        tid = reported->tid();
+        break;
       } else {
         //
         // This is a signal that we want to transmit back to the
@@ -333,6 +944,9 @@ ErrorCode Process::wait() {
     suspend();
   }
 
+  // Drop pages that were read while some threads were still running.
+  flushMemoryCache();
+
   if ((WIFEXITED(status) || WIFSIGNALED(status)) && tid == _pid) {
     _terminated = true;
   }
@@ -340,6 +954,38 @@ ErrorCode Process::wait() {
   return kSuccess;
 }
 
+// While the child of a vfork(2) runs in our address space, the software
+// breakpoints stay out of it; Process::handleForkEvent inserts them again.
+ErrorCode Process::beforeResume() {
+  if (_pendingVForks == 0) {
+    return super::beforeResume();
+  }
+
+  if (!isAlive()) {
+    return kErrorProcessNotFound;
+  }
+
+  enumerateThreads([](ds2::Target::Thread *thread) { thread->beforeResume(); });
+  return kSuccess;
+}
+
+ErrorCode Process::afterResume() {
+  if (_pendingVForks == 0) {
+    return super::afterResume();
+  }
+
+  if (!isAlive()) {
+    return kSuccess;
+  }
+
+  BreakpointManager *hwBpm = hardwareBreakpointManager();
+  if (hwBpm != nullptr) {
+    hwBpm->disable();
+  }
+
+  return kSuccess;
+}
+
 ErrorCode Process::terminate() {
   ErrorCode error = super::terminate();
   if (error == kSuccess || error == kErrorProcessNotFound) {
@@ -431,76 +1077,36 @@ ErrorCode Process::getMemoryRegionInfo(Address const &address,
 
   info.clear();
 
-  FILE *fp = ProcFS::OpenFILE(_pid, "maps");
-  if (fp == nullptr) {
-    return Platform::TranslateError();
-  }
-
   uint64_t last = 0;
   bool found = false;
 
-  while (!found) {
-    // Each line can contain one path and some additional addresses and
-    // such, so PATH_MAX * 2 should be enough.
-    char buf[PATH_MAX * 2];
-    uint64_t start, end;
-    char r, w, x, p;
-    uint64_t offset;
-    unsigned int devMinor, devMajor;
-    uint64_t inode;
-    char name[PATH_MAX + 1];
-    int nread;
-
-    if (::fgets(buf, sizeof(buf), fp) == nullptr) {
-      if (::feof(fp)) {
-        break;
-      } else {
-        DS2ASSERT(errno != 0);
-        return Platform::TranslateError();
-      }
-    }
-
-    if (::sscanf(buf,
-                 "%" PRIx64 "-%" PRIx64 " %c%c%c%c %" PRIx64 " %x:%x %" PRIu64
-                 " %" STR(PATH_MAX) "s%n",
-                 &start, &end, &r, &w, &x, &p, &offset, &devMinor, &devMajor,
-                 &inode, name, &nread) != 11) {
-      continue;
-    }
+  bool success =
+      ProcFS::EnumerateMemoryRegions(_pid, [&](MemoryRegionInfo const &region) {
+        if (found) {
+          return;
+        }
 
-    if (address >= last && address < start) {
-      //
-      // A hole.
-      //
-      info.start = last;
-      info.length = start - last;
-      info.name = name;
-      found = true;
-    } else if (address >= start && address < end) {
-      //
-      // A defined region.
-      //
-      info.start = start;
-      info.length = end - start;
-      info.protection = 0;
-      if (r == 'r')
-        info.protection |= ds2::kProtectionRead;
-      if (w == 'w')
-        info.protection |= ds2::kProtectionWrite;
-      if (x == 'x')
-        info.protection |= ds2::kProtectionExecute;
-      while (buf[nread] != '\0' && std::isspace(buf[nread]))
-        ++nread;
-      info.name = name;
-      info.backingFile = buf + nread;
-      info.backingFileOffset = offset;
-      info.backingFileInode = inode;
-      found = true;
-    } else {
-      last = end;
-    }
+        uint64_t end = region.start + region.length;
+        if (address >= last && address < region.start) {
+          //
+          // A hole.
+          //
+          info.start = last;
+          info.length = region.start - last;
+          found = true;
+        } else if (address >= region.start && address < end) {
+          //
+          // A defined region.
+          //
+          info = region;
+          found = true;
+        } else {
+          last = end;
+        }
+      });
+  if (!success) {
+    return Platform::TranslateError();
   }
-  std::fclose(fp);
 
   if (!found) {
     info.start = last;
@@ -524,14 +1130,73 @@ ErrorCode Process::getMemoryRegionInfo(Address const &address,
   return kSuccess;
 }
 
+ErrorCode Process::getProfileData(ProfileData &data) {
+  data.clear();
+
+  // Everything comes from /proc: the thread waiting on the inferior owns
+  // `_threads`, and we don't want to stop anything to sample it.
+  ProcFS::Statm statm;
+  if (!ProcFS::ReadStatm(_pid, statm)) {
+    return kErrorProcessNotFound;
+  }
+
+  size_t pageSize = Platform::GetPageSize();
+  data.virtualMemory = statm.size * pageSize;
+  data.residentMemory = statm.resident * pageSize;
+  data.sharedMemory = statm.shared * pageSize;
+  data.hostMemory = static_cast<uint64_t>(::sysconf(_SC_PHYS_PAGES)) * pageSize;
+  data.cpuCount = ::sysconf(_SC_NPROCESSORS_ONLN);
+
+  struct timespec now;
+  ::clock_gettime(CLOCK_REALTIME, &now);
+  data.timestamp =
+      static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+
+  ProcFS::EnumerateThreads(_pid, [&](pid_t tid) {
+    ProfileData::ThreadUsage usage;
+    // The thread might have exited since we listed it.
+    if (!ProcFS::ReadThreadCPUTime(_pid, tid, usage.cpuTime)) {
+      return;
+    }
+    usage.tid = tid;
+    usage.name = ProcFS::GetThreadName(_pid, tid);
+    data.cpuTime += usage.cpuTime;
+    data.threads.push_back(usage);
+  });
+
+  return kSuccess;
+}
+
 ErrorCode Process::executeCode(ByteVector const &codestr, uint64_t &result) {
   ProcessInfo info;
 
   CHK(getInfo(info));
-  CHK(ptrace().execute(_currentThread->tid(), info, &codestr[0], codestr.size(),
-                       result));
 
-  return kSuccess;
+  // The injected code may change the memory map. ptrace().execute() saves
+  // and restores the registers itself, so pending changes have to be in the
+  // kernel before and the cached copy can't be trusted after.
+  flushMemoryCache();
+  CHK(_currentThread->flushCPUState());
+  ErrorCode error = ptrace().execute(_currentThread->tid(), info, &codestr[0],
+                                     codestr.size(), result);
+  _currentThread->invalidateCPUState();
+
+  return error;
+}
+
+void Process::prepareForDetach() {
+  super::prepareForDetach();
+
+  // Threads won't be resumed by us again, write back their pending register
+  // changes now.
+  for (auto &it : _threads) {
+    ErrorCode error = it.second->flushCPUState();
+    if (error != kSuccess) {
+      DS2LOG(Warning, "failed writing back registers of tid %" PRI_PID
+                      ", error=%s",
+             it.first, Stringify::Error(error));
+    }
+  }
 }
 } // namespace Linux
 } // namespace Target
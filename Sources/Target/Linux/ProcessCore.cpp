@@ -0,0 +1,435 @@
+//
+// Copyright (c) 2014-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the University of Illinois/NCSA Open
+// Source License found in the LICENSE file in the root directory of this
+// source tree. An additional grant of patent rights can be found in the
+// PATENTS file in the same directory.
+//
+
+#include "DebugServer2/Host/Linux/ProcFS.h"
+#include "DebugServer2/Host/Platform.h"
+#include "DebugServer2/Target/Process.h"
+#include "DebugServer2/Target/Thread.h"
+#include "DebugServer2/Utils/Log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <sys/procfs.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using ds2::Host::Linux::ProcFS;
+using ds2::Host::Platform;
+
+namespace ds2 {
+namespace Target {
+namespace Linux {
+
+namespace {
+
+#if defined(PLATFORM_ANDROID)
+static char const kDefaultTempDirectory[] = "/data/local/tmp";
+#else
+static char const kDefaultTempDirectory[] = "/tmp";
+#endif
+
+// Memory is copied to the core file this many bytes at a time.
+static size_t const kCoreChunkSize = 1024 * 1024;
+// Large enough for any register set we write, including an XSAVE area with
+// every AVX-512 component.
+static size_t const kMaxRegisterSetSize = 16 * 1024;
+
+// The process states as the kernel numbers them in NT_PRPSINFO.
+static char const kPRPSInfoStates[] = "RSDTZW";
+
+static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static void Append(ByteVector &data, void const *bytes, size_t length) {
+  auto begin = static_cast<uint8_t const *>(bytes);
+  data.insert(data.end(), begin, begin + length);
+}
+
+static void AppendNote(ByteVector &notes, char const *name, uint32_t type,
+                       void const *desc, size_t length) {
+  ElfW(Nhdr) header;
+  header.n_namesz = std::strlen(name) + 1;
+  header.n_descsz = length;
+  header.n_type = type;
+
+  Append(notes, &header, sizeof(header));
+  Append(notes, name, header.n_namesz);
+  notes.resize(AlignUp(notes.size(), 4));
+  Append(notes, desc, length);
+  notes.resize(AlignUp(notes.size(), 4));
+}
+
+static void TicksToTimeval(uint64_t ticks, struct timeval &tv) {
+  static long const kTicksPerSecond = ::sysconf(_SC_CLK_TCK);
+  tv.tv_sec = ticks / kTicksPerSecond;
+  tv.tv_usec = (ticks % kTicksPerSecond) * 1000000 / kTicksPerSecond;
+}
+
+static ErrorCode WriteAll(int fd, void const *data, size_t length,
+                          uint64_t offset) {
+  auto bytes = static_cast<uint8_t const *>(data);
+  while (length > 0) {
+    ssize_t nwritten = ::pwrite(fd, bytes, length, offset);
+    if (nwritten < 0) {
+      if (errno == EINTR)
+        continue;
+      return Platform::TranslateError();
+    }
+    bytes += nwritten;
+    length -= nwritten;
+    offset += nwritten;
+  }
+  return kSuccess;
+}
+
+// Writes the pages of data that aren't entirely zero; the file was extended
+// to its final size beforehand, so the others read back as zeros without
+// taking any space.
+static ErrorCode WriteNonZeroPages(int fd, uint8_t const *data, size_t length,
+                                   uint64_t offset, ByteVector const &zero) {
+  size_t const pageSize = zero.size();
+  size_t run = 0;
+  size_t runLength = 0;
+
+  for (size_t n = 0; n < length; n += pageSize) {
+    size_t size = std::min(pageSize, length - n);
+    if (std::memcmp(data + n, zero.data(), size) != 0) {
+      if (runLength == 0) {
+        run = n;
+      }
+      runLength += size;
+      continue;
+    }
+
+    if (runLength > 0) {
+      CHK(WriteAll(fd, data + run, runLength, offset + run));
+      runLength = 0;
+    }
+  }
+
+  if (runLength > 0) {
+    CHK(WriteAll(fd, data + run, runLength, offset + run));
+  }
+
+  return kSuccess;
+}
+} // namespace
+
+ErrorCode Process::saveCore(std::string const &pathHint, std::string &path) {
+  ErrorCode error = updateInfo();
+  if (error != kSuccess && error != kErrorAlreadyExist)
+    return error;
+
+  // The notes are made of our own prstatus and register structures.
+  if (CPUTypeIs64Bit(_info.cpuType) != (sizeof(void *) == 8))
+    return kErrorUnsupported;
+
+  int fd = -1;
+  if (!pathHint.empty()) {
+    path = pathHint;
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  }
+
+  if (fd < 0) {
+    char const *directory = std::getenv("TMPDIR");
+    if (directory == nullptr || *directory == '\0') {
+      directory = kDefaultTempDirectory;
+    }
+    path = std::string(directory) + "/ds2-core-XXXXXX";
+    fd = ::mkostemp(&path[0], O_CLOEXEC);
+    if (fd < 0)
+      return Platform::TranslateError();
+  }
+
+  DS2LOG(Debug, "writing core file of pid %d to %s", _pid, path.c_str());
+
+  error = writeCore(fd);
+  ::close(fd);
+
+  if (error != kSuccess) {
+    ::unlink(path.c_str());
+  }
+
+  return error;
+}
+
+ErrorCode Process::writeCore(int fd) {
+  size_t const pageSize = Platform::GetPageSize();
+
+  //
+  // Gather the mappings first; those we can't read are still described, but
+  // take no space in the file.
+  //
+  MemoryRegionInfo::Collection regions;
+  if (!ProcFS::EnumerateMemoryRegions(_pid,
+                                      [&](MemoryRegionInfo const &region) {
+                                        regions.push_back(region);
+                                      }))
+    return kErrorProcessNotFound;
+
+  //
+  // Process-wide notes.
+  //
+  ByteVector notes;
+
+  ProcFS::Stat stat;
+  if (!ProcFS::ReadStat(_pid, stat))
+    return kErrorProcessNotFound;
+
+  struct elf_prpsinfo prpsinfo;
+  std::memset(&prpsinfo, 0, sizeof(prpsinfo));
+  char const *state = std::strchr(kPRPSInfoStates, stat.state);
+  prpsinfo.pr_state = (state != nullptr) ? state - kPRPSInfoStates : 0;
+  prpsinfo.pr_sname = stat.state;
+  prpsinfo.pr_zomb = (stat.state == Host::Linux::kProcStateZombie);
+  prpsinfo.pr_nice = stat.nice;
+  prpsinfo.pr_flag = stat.flags;
+  prpsinfo.pr_pid = _pid;
+  prpsinfo.pr_ppid = stat.ppid;
+  prpsinfo.pr_pgrp = stat.pgrp;
+  prpsinfo.pr_sid = stat.sid;
+  pid_t ppid;
+  uid_t uid, euid;
+  gid_t gid, egid;
+  if (ProcFS::ReadProcessIds(_pid, ppid, uid, euid, gid, egid)) {
+    prpsinfo.pr_uid = uid;
+    prpsinfo.pr_gid = gid;
+  }
+  std::strncpy(prpsinfo.pr_fname, stat.tcomm, sizeof(prpsinfo.pr_fname) - 1);
+  std::string args = ProcFS::GetProcessArgumentsAsString(_pid, true);
+  std::strncpy(prpsinfo.pr_psargs, args.c_str(),
+               sizeof(prpsinfo.pr_psargs) - 1);
+  AppendNote(notes, "CORE", NT_PRPSINFO, &prpsinfo, sizeof(prpsinfo));
+
+  std::string auxv;
+  if (getAuxiliaryVector(auxv) == kSuccess) {
+    AppendNote(notes, "CORE", NT_AUXV, auxv.data(), auxv.size());
+  }
+
+  // NT_FILE: count and page size, then a (start, end, offset in pages)
+  // triple for each file mapping, then their paths.
+  std::vector<unsigned long> files(2);
+  std::string paths;
+  for (auto const &region : regions) {
+    if (region.backingFile.empty() || region.backingFile[0] != '/')
+      continue;
+
+    files.push_back(region.start.value());
+    files.push_back(region.start.value() + region.length);
+    files.push_back(region.backingFileOffset / pageSize);
+    paths.append(region.backingFile.c_str(), region.backingFile.size() + 1);
+  }
+  files[0] = (files.size() - 2) / 3;
+  files[1] = pageSize;
+  ByteVector fileNote;
+  Append(fileNote, files.data(), files.size() * sizeof(unsigned long));
+  Append(fileNote, paths.data(), paths.size());
+  AppendNote(notes, "CORE", NT_FILE, fileNote.data(), fileNote.size());
+
+  //
+  // Per-thread notes. Debuggers take the first thread as the one that
+  // stopped, so the current thread goes first.
+  //
+  std::vector<Thread *> threads;
+  if (_currentThread != nullptr) {
+    threads.push_back(_currentThread);
+  }
+  for (auto const &it : _threads) {
+    if (it.second != _currentThread) {
+      threads.push_back(it.second);
+    }
+  }
+
+  for (Thread *thread : threads) {
+    ProcessThreadId ptid(_pid, thread->tid());
+
+    // Pending register writes only exist in our cache.
+    if (thread->flushCPUState() != kSuccess) {
+      DS2LOG(Warning, "unable to flush registers of tid %d", thread->tid());
+    }
+
+    ByteVector regs(sizeof(elf_gregset_t));
+    if (ptrace().readRegisterSetData(ptid, NT_PRSTATUS, regs) != kSuccess) {
+      DS2LOG(Warning, "unable to read registers of tid %d", thread->tid());
+      continue;
+    }
+
+    ByteVector fpregs(kMaxRegisterSetSize);
+    bool fpvalid = ptrace().readRegisterSetData(ptid, NT_PRFPREG, fpregs) ==
+                   kSuccess;
+
+    struct elf_prstatus prstatus;
+    std::memset(&prstatus, 0, sizeof(prstatus));
+    prstatus.pr_info.si_signo = thread->stopInfo().signal;
+    prstatus.pr_cursig = thread->stopInfo().signal;
+    prstatus.pr_pid = thread->tid();
+    prstatus.pr_ppid = stat.ppid;
+    prstatus.pr_pgrp = stat.pgrp;
+    prstatus.pr_sid = stat.sid;
+    ProcFS::Stat threadStat;
+    if (ProcFS::ReadStat(_pid, thread->tid(), threadStat)) {
+      TicksToTimeval(threadStat.utime, prstatus.pr_utime);
+      TicksToTimeval(threadStat.stime, prstatus.pr_stime);
+      TicksToTimeval(threadStat.cutime, prstatus.pr_cutime);
+      TicksToTimeval(threadStat.cstime, prstatus.pr_cstime);
+    }
+    std::memcpy(&prstatus.pr_reg, regs.data(),
+                std::min(regs.size(), sizeof(prstatus.pr_reg)));
+    prstatus.pr_fpvalid = fpvalid;
+    AppendNote(notes, "CORE", NT_PRSTATUS, &prstatus, sizeof(prstatus));
+
+    siginfo_t si;
+    if (thread == _currentThread &&
+        ptrace().getSigInfo(ptid, si) == kSuccess) {
+      AppendNote(notes, "CORE", NT_SIGINFO, &si, sizeof(si));
+    }
+
+    if (fpvalid) {
+      AppendNote(notes, "CORE", NT_PRFPREG, fpregs.data(), fpregs.size());
+    }
+
+#if defined(ARCH_X86) || defined(ARCH_X86_64)
+    ByteVector xstate(kMaxRegisterSetSize);
+    if (ptrace().readRegisterSetData(ptid, NT_X86_XSTATE, xstate) ==
+        kSuccess) {
+      AppendNote(notes, "LINUX", NT_X86_XSTATE, xstate.data(), xstate.size());
+    }
+#endif
+  }
+
+  //
+  // Lay out the file: headers, notes, then the contents of each mapping,
+  // page-aligned. A process with more than PN_XNUM - 1 mappings gets the
+  // actual count in the first section header, as the kernel does.
+  //
+  size_t phnum = regions.size() + 1;
+  bool extendedNumbering = (phnum >= PN_XNUM);
+
+  ElfW(Ehdr) ehdr;
+  std::memset(&ehdr, 0, sizeof(ehdr));
+  std::memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+  ehdr.e_ident[EI_CLASS] = (sizeof(void *) == 8) ? ELFCLASS64 : ELFCLASS32;
+  ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+  ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+  ehdr.e_ident[EI_OSABI] = ELFOSABI_NONE;
+  ehdr.e_type = ET_CORE;
+  ehdr.e_machine = ProcFS::GetProcessELFMachineType(_pid);
+  ehdr.e_version = EV_CURRENT;
+  ehdr.e_phoff = sizeof(ehdr);
+  ehdr.e_ehsize = sizeof(ehdr);
+  ehdr.e_phentsize = sizeof(ElfW(Phdr));
+  ehdr.e_phnum = extendedNumbering ? PN_XNUM : phnum;
+
+  std::vector<ElfW(Phdr)> phdrs(phnum);
+  std::memset(phdrs.data(), 0, phdrs.size() * sizeof(ElfW(Phdr)));
+
+  uint64_t offset = sizeof(ehdr) + phnum * sizeof(ElfW(Phdr));
+  phdrs[0].p_type = PT_NOTE;
+  phdrs[0].p_offset = offset;
+  phdrs[0].p_filesz = notes.size();
+  phdrs[0].p_align = 4;
+  offset = AlignUp(offset + notes.size(), pageSize);
+
+  for (size_t n = 0; n < regions.size(); n++) {
+    auto &phdr = phdrs[n + 1];
+    auto const &region = regions[n];
+    phdr.p_type = PT_LOAD;
+    phdr.p_offset = offset;
+    phdr.p_vaddr = region.start.value();
+    phdr.p_memsz = region.length;
+    phdr.p_filesz =
+        (region.protection & kProtectionRead) ? region.length : 0;
+    phdr.p_align = pageSize;
+    if (region.protection & kProtectionRead)
+      phdr.p_flags |= PF_R;
+    if (region.protection & kProtectionWrite)
+      phdr.p_flags |= PF_W;
+    if (region.protection & kProtectionExecute)
+      phdr.p_flags |= PF_X;
+    offset += phdr.p_filesz;
+  }
+
+  ElfW(Shdr) shdr;
+  if (extendedNumbering) {
+    std::memset(&shdr, 0, sizeof(shdr));
+    shdr.sh_info = phnum;
+    ehdr.e_shoff = offset;
+    ehdr.e_shentsize = sizeof(shdr);
+    ehdr.e_shnum = 1;
+    offset += sizeof(shdr);
+  }
+
+  if (::ftruncate(fd, offset) < 0)
+    return Platform::TranslateError();
+
+  CHK(WriteAll(fd, &ehdr, sizeof(ehdr), 0));
+  CHK(WriteAll(fd, phdrs.data(), phdrs.size() * sizeof(ElfW(Phdr)),
+               ehdr.e_phoff));
+  CHK(WriteAll(fd, notes.data(), notes.size(), phdrs[0].p_offset));
+  if (extendedNumbering) {
+    CHK(WriteAll(fd, &shdr, sizeof(shdr), ehdr.e_shoff));
+  }
+
+  //
+  // Copy memory in large chunks with process_vm_readv(2). A chunk stops
+  // short at the first page that can't be read (e.g. past the end of a
+  // mapped file); that page is left as a hole and the copy goes on after it.
+  //
+  ByteVector buffer(kCoreChunkSize);
+  ByteVector const zero(pageSize, 0);
+  uint64_t unreadable = 0;
+
+  for (size_t n = 0; n < regions.size(); n++) {
+    auto const &phdr = phdrs[n + 1];
+    uint64_t address = phdr.p_vaddr;
+    uint64_t end = phdr.p_vaddr + phdr.p_filesz;
+
+    while (address < end) {
+      size_t length = std::min<uint64_t>(buffer.size(), end - address);
+#if defined(HAVE_PROCESS_VM_READV)
+      struct iovec local = {buffer.data(), length};
+      struct iovec remote = {reinterpret_cast<void *>(address), length};
+      ssize_t ret = ::process_vm_readv(_pid, &local, 1, &remote, 1, 0);
+      size_t nread = (ret < 0) ? 0 : ret;
+#else
+      size_t nread = 0;
+      if (readMemory(address, buffer.data(), length, &nread) != kSuccess) {
+        nread = 0;
+      }
+#endif
+
+      CHK(WriteNonZeroPages(fd, buffer.data(), nread,
+                            phdr.p_offset + (address - phdr.p_vaddr), zero));
+
+      if (nread < length) {
+        nread = AlignUp(address + nread + 1, pageSize) - address;
+        unreadable++;
+      }
+      address += nread;
+    }
+  }
+
+  if (unreadable > 0) {
+    DS2LOG(Debug, "%" PRIu64 " pages could not be read and were left empty",
+           unreadable);
+  }
+
+  return kSuccess;
+}
+} // namespace Linux
+} // namespace Target
+} // namespace ds2
@@ -31,7 +31,113 @@ namespace ds2 {
 namespace Target {
 namespace Linux {
 
-Thread::Thread(Process *process, ThreadId tid) : super(process, tid) {}
+Thread::Thread(Process *process, ThreadId tid)
+    : super(process, tid), _cpuStateValid(false), _cpuStateDirty(false) {
+#if defined(ARCH_X86_64)
+  _extendedCPUStateValid = false;
+#endif
+}
+
+ErrorCode Thread::readCPUState(Architecture::CPUState &state) {
+  CHK(fetchCPUState(true));
+  state = _cpuState;
+  return kSuccess;
+}
+
+ErrorCode Thread::readBaseCPUState(Architecture::CPUState &state) {
+  CHK(fetchCPUState(false));
+  state = _cpuState;
+  return kSuccess;
+}
+
+ErrorCode Thread::writeCPUState(Architecture::CPUState const &state) {
+  // We need the kernel's view of the registers to know what changed later.
+  // A state from readBaseCPUState doesn't have the extended registers, and
+  // writing it back leaves them alone.
+#if defined(ARCH_X86_64)
+  CHK(fetchCPUState(state.hasExtendedState()));
+  if (!state.hasExtendedState() && _extendedCPUStateValid) {
+    // Our copy of the extended registers is about to be dropped; make sure
+    // the kernel has it so that it can be read again.
+    CHK(flushCPUState());
+    _extendedCPUStateValid = false;
+  }
+#else
+  CHK(fetchCPUState(true));
+#endif
+
+  _cpuState = state;
+  _cpuStateDirty = true;
+  return kSuccess;
+}
+
+ErrorCode Thread::fetchCPUState(bool extended) {
+#if defined(ARCH_X86_64)
+  if (_cpuStateValid && (_extendedCPUStateValid || !extended)) {
+    return kSuccess;
+  }
+
+  ProcessInfo info;
+  ProcessThreadId ptid(process()->pid(), tid());
+  CHK(_process->getInfo(info));
+
+  if (!_cpuStateValid) {
+    _kernelCPUState = Architecture::CPUState();
+    CHK(process()->ptrace().readBaseCPUState(ptid, info, _kernelCPUState));
+    _cpuState = _kernelCPUState;
+    _cpuStateValid = true;
+    _extendedCPUStateValid = false;
+  }
+
+  if (extended) {
+    // Pending writes can only be to the base registers at this point; send
+    // them first so that both copies get the extended registers from the
+    // kernel.
+    CHK(flushCPUState());
+    CHK(process()->ptrace().readExtendedCPUState(ptid, info, _kernelCPUState));
+    _cpuState = _kernelCPUState;
+    _extendedCPUStateValid = true;
+  }
+#else
+  if (!_cpuStateValid) {
+    CHK(super::readCPUState(_kernelCPUState));
+    _cpuState = _kernelCPUState;
+    _cpuStateValid = true;
+  }
+#endif
+
+  return kSuccess;
+}
+
+ErrorCode Thread::flushCPUState() {
+  if (!_cpuStateDirty) {
+    return kSuccess;
+  }
+
+  ProcessInfo info;
+  CHK(_process->getInfo(info));
+  CHK(process()->ptrace().writeCPUState(
+      ProcessThreadId(process()->pid(), tid()), info, _cpuState,
+      _kernelCPUState));
+
+  _kernelCPUState = _cpuState;
+  _cpuStateDirty = false;
+  return kSuccess;
+}
+
+ErrorCode Thread::step(int signal, Address const &address) {
+  CHK(flushCPUState());
+  ErrorCode error = super::step(signal, address);
+  invalidateCPUState();
+  return error;
+}
+
+ErrorCode Thread::resume(int signal, Address const &address) {
+  CHK(flushCPUState());
+  ErrorCode error = super::resume(signal, address);
+  invalidateCPUState();
+  return error;
+}
 
 ErrorCode Thread::updateStopInfo(int waitStatus) {
   super::updateStopInfo(waitStatus);
@@ -66,10 +172,17 @@ ErrorCode Thread::updateStopInfo(int waitStatus) {
     // (3) we sent the process a SIGSTOP (with kill(2)) to interrupt it
     //     entirely. This happens when the user hits Ctrl-C and the debugger
     //     sends us a "\x03" for instance;
-    // (4) the inferior received a SIGSTOP because of ptrace attach. We have to
-    //     mark the thread as stopped for a trap;
+    // (4) the inferior received a SIGSTOP because of ptrace attach, or was
+    //     interrupted after PTRACE_SEIZE and reported a PTRACE_EVENT_STOP with
+    //     SIGTRAP. We have to mark the thread as stopped for a trap;
     // (5) the inferior received a SIGTRAP. This is usually because of a
     //     breakpoint, single step or such;
+    // (6) a seized inferior entered a group-stop, which is also reported as a
+    //     PTRACE_EVENT_STOP, with the stopping signal;
+    // (7) a thread called fork(2) or vfork(2), or the child of a vfork(2)
+    //     released the memory of its parent. These are reported like (1), with
+    //     PTRACE_EVENT_FORK, PTRACE_EVENT_VFORK or PTRACE_EVENT_VFORK_DONE, and
+    //     Linux::Process::wait decides whether the debugger gets to see them;
 
     siginfo_t si;
     ProcessThreadId ptid(process()->pid(), tid());
@@ -83,6 +196,26 @@ ErrorCode Thread::updateStopInfo(int waitStatus) {
     if (waitStatus >> 8 == (SIGTRAP | (PTRACE_EVENT_CLONE << 8))) { // (1)
       _stopInfo.event = StopInfo::kEventNone;
       _stopInfo.reason = StopInfo::kReasonThreadSpawn;
+    } else if (waitStatus >> 8 == (SIGTRAP | (PTRACE_EVENT_FORK << 8)) ||
+               waitStatus >> 8 ==
+                   (SIGTRAP | (PTRACE_EVENT_VFORK << 8))) { // (7)
+      unsigned long childPid;
+      CHK(process()->ptrace().getEventMessage(ptid, childPid));
+      _stopInfo.reason = (waitStatus >> 16 == PTRACE_EVENT_FORK)
+                             ? StopInfo::kReasonFork
+                             : StopInfo::kReasonVFork;
+      _stopInfo.childPid = static_cast<ProcessId>(childPid);
+    } else if (waitStatus >> 8 ==
+               (SIGTRAP | (PTRACE_EVENT_VFORK_DONE << 8))) { // (7)
+      _stopInfo.reason = StopInfo::kReasonVForkDone;
+    } else if (waitStatus >> 16 == PTRACE_EVENT_STOP) {
+      if (_stopInfo.signal == SIGTRAP) { // (4)
+        // Report the same stop as a regular attach would.
+        _stopInfo.signal = SIGSTOP;
+        _stopInfo.reason = StopInfo::kReasonTrap;
+      } else { // (6)
+        _stopInfo.reason = StopInfo::kReasonSignalStop;
+      }
     } else if (si.si_code == SI_TKILL && si.si_pid == getpid()) { // (2)
       // The only signal we are supposed to send to the inferior is a SIGSTOP.
       DS2ASSERT(_stopInfo.signal == SIGSTOP);
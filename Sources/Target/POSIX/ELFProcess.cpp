@@ -503,11 +503,36 @@ ErrorCode ELFProcess::enumerateSharedLibraries(
   Address address;
   CHK(getSharedLibraryInfoAddress(address));
 
+#if defined(ARCH_ARM) || defined(ARCH_ARM64)
+  //
+  // The debugger asks for the library list after each dynamic linker event;
+  // if a library went away, the code we decoded in it may have been replaced.
+  //
+  uint64_t signature = 0;
+  auto wrapped = [&](SharedLibraryInfo const &library) {
+    signature = signature * 31 + library.svr4.baseAddress;
+    signature = signature * 31 + std::hash<std::string>()(library.path);
+    cb(library);
+  };
+
+  ErrorCode error;
+  if (CPUTypeIs64Bit(_info.cpuType)) {
+    error = EnumerateLinkMap<uint64_t>(this, address, wrapped);
+  } else {
+    error = EnumerateLinkMap<uint32_t>(this, address, wrapped);
+  }
+
+  if (error == kSuccess) {
+    _singleStepCache.updateLibraries(signature);
+  }
+  return error;
+#else
   if (CPUTypeIs64Bit(_info.cpuType)) {
     return EnumerateLinkMap<uint64_t>(this, address, cb);
   } else {
     return EnumerateLinkMap<uint32_t>(this, address, cb);
   }
+#endif
 }
 } // namespace POSIX
 } // namespace Target
@@ -243,6 +243,9 @@ void Thread::updateState(DEBUG_EVENT const &de) {
   case UNLOAD_DLL_DEBUG_EVENT:
     DS2LOG(Debug, "DLL unloaded, base=%" PRI_PTR,
            PRI_PTR_CAST(de.u.UnloadDll.lpBaseOfDll));
+#if defined(ARCH_ARM)
+    process()->singleStepCache().clear();
+#endif
     _state = kStopped;
     _stopInfo.event = StopInfo::kEventStop;
     _stopInfo.reason = StopInfo::kReasonLibraryEvent;
@@ -17,22 +17,33 @@
 #if defined(PLATFORM_ANDROID)
 #include <android/log.h>
 #endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
 #include <fcntl.h>
+#include <functional>
 #include <limits.h>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #if !defined(OS_WIN32)
 #include <cerrno>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #endif
 #include <vector>
 
 namespace ds2 {
+
+LogLevel gLogLevel;
+
 namespace {
 
-LogLevel sLogLevel;
 bool sColorsEnabled = false;
 // stderr is handled a bit differently on Windows, especially when running
 // under powershell. We can simply use stdout for log output.
@@ -42,6 +53,128 @@ FILE *sOutputStream = stdout;
 FILE *sOutputStream = stderr;
 #endif
 std::string sOutputFilename;
+std::atomic<bool> sAsynchronous(true);
+// Orders the records of different threads, see DrainRings.
+std::atomic<uint64_t> sSequence(0);
+
+//
+// Log records are produced on the logging thread without being formatted.
+// Each record holds a sequence number, the level, the format string and call
+// site pointers (all of which have static storage), followed by the raw
+// arguments which
+// are extracted from the va_list according to the format string. Strings
+// are copied since they usually don't outlive the call.
+//
+enum ArgumentKind : uint8_t {
+  kArgumentInt,
+  kArgumentLong,
+  kArgumentLongLong,
+  kArgumentIntMax,
+  kArgumentSize,
+  kArgumentPtrDiff,
+  kArgumentDouble,
+  kArgumentLongDouble,
+  kArgumentPointer,
+  kArgumentString,
+};
+
+struct RecordHeader {
+  uint64_t sequence;
+  int level;
+  char const *classname;
+  char const *funcname;
+  char const *format;
+};
+
+// Single-producer single-consumer byte ring. The owning thread pushes
+// records, the writer thread pops them; neither takes a lock.
+class LogRing {
+public:
+  static size_t const kCapacity = 256 * 1024;
+
+private:
+  std::unique_ptr<char[]> _buffer;
+  std::atomic<size_t> _head;
+  std::atomic<size_t> _tail;
+
+public:
+  std::atomic<bool> orphaned;
+
+public:
+  LogRing()
+      : _buffer(new char[kCapacity]), _head(0), _tail(0), orphaned(false) {}
+
+private:
+  void copyIn(size_t offset, void const *data, size_t length) {
+    offset %= kCapacity;
+    size_t first = std::min(length, kCapacity - offset);
+    std::memcpy(&_buffer[offset], data, first);
+    std::memcpy(&_buffer[0], static_cast<char const *>(data) + first,
+                length - first);
+  }
+
+  void copyOut(size_t offset, void *data, size_t length) const {
+    offset %= kCapacity;
+    size_t first = std::min(length, kCapacity - offset);
+    std::memcpy(data, &_buffer[offset], first);
+    std::memcpy(static_cast<char *>(data) + first, &_buffer[0],
+                length - first);
+  }
+
+public:
+  bool empty() const {
+    return _tail.load(std::memory_order_relaxed) ==
+           _head.load(std::memory_order_acquire);
+  }
+
+  bool push(std::string const &record) {
+    uint32_t length = record.size();
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t tail = _tail.load(std::memory_order_acquire);
+    if (sizeof(length) + length > kCapacity - (head - tail)) {
+      return false;
+    }
+
+    copyIn(head, &length, sizeof(length));
+    copyIn(head + sizeof(length), record.data(), length);
+    _head.store(head + sizeof(length) + length, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(std::string &record) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    uint32_t length;
+    copyOut(tail, &length, sizeof(length));
+    record.resize(length);
+    copyOut(tail + sizeof(length), &record[0], length);
+    _tail.store(tail + sizeof(length) + length, std::memory_order_release);
+    return true;
+  }
+};
+
+struct LogWriter {
+  std::mutex lock; // Protects `rings` and the output stream.
+  std::condition_variable wakeup;
+  std::vector<LogRing *> rings;
+  bool running = false;
+  bool hooksInstalled = false;
+  uint32_t generation = 0;
+};
+
+struct ThreadLogRing {
+  LogRing *ring = nullptr;
+  uint32_t generation = 0;
+
+  ~ThreadLogRing() {
+    if (ring != nullptr) {
+      ring->orphaned = true;
+    }
+  }
+};
 } // namespace
 
 #if defined(PLATFORM_ANDROID)
@@ -71,9 +204,16 @@ static void androidLogcat(int level, char const *functag, char const *message) {
 }
 #endif
 
-LogLevel GetLogLevel() { return sLogLevel; }
+// The writer is never destroyed, it can be used until the very end of the
+// process, including from atexit() handlers.
+static LogWriter &GetLogWriter() {
+  static LogWriter *writer = new LogWriter;
+  return *writer;
+}
+
+LogLevel GetLogLevel() { return gLogLevel; }
 
-void SetLogLevel(LogLevel level) { sLogLevel = level; }
+void SetLogLevel(LogLevel level) { gLogLevel = level; }
 
 std::string const &GetLogOutputFilename() { return sOutputFilename; }
 
@@ -93,31 +233,341 @@ void SetLogOutputFilename(std::string const &filename) {
   fchmod(fileno(stream), 0644);
   fcntl(fileno(stream), F_SETFD, FD_CLOEXEC);
 #endif
+  FlushLog();
+
+  std::lock_guard<std::mutex> guard(GetLogWriter().lock);
+  if (sOutputStream != stdout && sOutputStream != stderr) {
+    fclose(sOutputStream);
+  }
   sOutputStream = stream;
   sOutputFilename = filename;
 }
 
 void SetLogColorsEnabled(bool enabled) { sColorsEnabled = enabled; }
 
-static void vLog(int level, char const *classname, char const *funcname,
-                 char const *format, va_list ap) {
-  if (level < sLogLevel) {
-    return;
+void SetLogAsynchronous(bool enabled) {
+  if (!enabled) {
+    FlushLog();
   }
+  sAsynchronous = enabled;
+}
 
-  std::stringstream ss;
+template <typename T> static void AppendValue(std::string &out, T value) {
+  out.append(reinterpret_cast<char const *>(&value), sizeof(value));
+}
+
+template <typename T> static T ReadValue(char const *&cur, char const *end) {
+  T value;
+  DS2ASSERT(cur + sizeof(value) <= end);
+  std::memcpy(&value, cur, sizeof(value));
+  cur += sizeof(value);
+  return value;
+}
+
+// Walks a printf-style format string and calls `cb` for each conversion
+// specification with the specification itself, the number of `*` widths and
+// precisions it uses and the kind of the argument it consumes. Literal text
+// is passed with a null kind pointer.
+static void
+ParseFormat(char const *format,
+            std::function<void(char const *, size_t, int,
+                               ArgumentKind const *)> const &cb) {
+  char const *cur = format;
+  while (*cur != '\0') {
+    char const *text = cur;
+    while (*cur != '\0' && *cur != '%') {
+      cur++;
+    }
+    if (cur != text) {
+      cb(text, cur - text, 0, nullptr);
+    }
+    if (*cur == '\0') {
+      break;
+    }
+
+    char const *spec = cur++;
+    if (*cur == '%') {
+      cb(cur, 1, 0, nullptr);
+      cur++;
+      continue;
+    }
+
+    int stars = 0;
+    while (*cur != '\0' && std::strchr("-+ #0'", *cur) != nullptr) {
+      cur++;
+    }
+    if (*cur == '*') {
+      stars++;
+      cur++;
+    }
+    while (*cur >= '0' && *cur <= '9') {
+      cur++;
+    }
+    if (*cur == '.') {
+      cur++;
+      if (*cur == '*') {
+        stars++;
+        cur++;
+      }
+      while (*cur >= '0' && *cur <= '9') {
+        cur++;
+      }
+    }
+
+    ArgumentKind kind = kArgumentInt;
+    bool longDouble = false;
+    switch (*cur) {
+    case 'h':
+      cur += (cur[1] == 'h') ? 2 : 1;
+      break;
+    case 'l':
+      if (cur[1] == 'l') {
+        kind = kArgumentLongLong;
+        cur += 2;
+      } else {
+        kind = kArgumentLong;
+        cur += 1;
+      }
+      break;
+    case 'q':
+      kind = kArgumentLongLong;
+      cur++;
+      break;
+    case 'j':
+      kind = kArgumentIntMax;
+      cur++;
+      break;
+    case 'z':
+      kind = kArgumentSize;
+      cur++;
+      break;
+    case 't':
+      kind = kArgumentPtrDiff;
+      cur++;
+      break;
+    case 'L':
+      longDouble = true;
+      cur++;
+      break;
+    default:
+      break;
+    }
+
+    switch (*cur) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+      break;
+    case 'c':
+      kind = kArgumentInt;
+      break;
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      kind = longDouble ? kArgumentLongDouble : kArgumentDouble;
+      break;
+    case 's':
+      kind = kArgumentString;
+      break;
+    case 'p':
+    case 'n':
+      kind = kArgumentPointer;
+      break;
+    default:
+      DS2BUG("unsupported log format `%s'", format);
+    }
+
+    cur++;
+    cb(spec, cur - spec, stars, &kind);
+  }
+}
 
-  std::vector<char> buffer;
-  size_t required_bytes = 128;
+static void EncodeArguments(char const *format, va_list ap,
+                            std::string &out) {
+  ParseFormat(format, [&](char const *, size_t, int stars,
+                          ArgumentKind const *kind) {
+    if (kind == nullptr) {
+      return;
+    }
 
-  do {
-    va_list ap_copy;
-    va_copy(ap_copy, ap);
-    buffer.resize(required_bytes + 1);
-    required_bytes =
-        ds2::Utils::VSNPrintf(buffer.data(), buffer.size(), format, ap_copy);
-    va_end(ap_copy);
-  } while (required_bytes >= buffer.size());
+    for (int n = 0; n < stars; n++) {
+      AppendValue(out, va_arg(ap, int));
+    }
+
+    switch (*kind) {
+    case kArgumentInt:
+      AppendValue(out, va_arg(ap, int));
+      break;
+    case kArgumentLong:
+      AppendValue(out, va_arg(ap, long));
+      break;
+    case kArgumentLongLong:
+      AppendValue(out, va_arg(ap, long long));
+      break;
+    case kArgumentIntMax:
+      AppendValue(out, va_arg(ap, intmax_t));
+      break;
+    case kArgumentSize:
+      AppendValue(out, va_arg(ap, size_t));
+      break;
+    case kArgumentPtrDiff:
+      AppendValue(out, va_arg(ap, ptrdiff_t));
+      break;
+    case kArgumentDouble:
+      AppendValue(out, va_arg(ap, double));
+      break;
+    case kArgumentLongDouble:
+      AppendValue(out, va_arg(ap, long double));
+      break;
+    case kArgumentPointer:
+      AppendValue(out, va_arg(ap, void *));
+      break;
+    case kArgumentString: {
+      char const *str = va_arg(ap, char const *);
+      if (str == nullptr) {
+        str = "(null)";
+      }
+      uint32_t length = std::strlen(str);
+      AppendValue(out, length);
+      out.append(str, length);
+    } break;
+    }
+  });
+}
+
+// Packets may contain anything, make sure they don't mess up the terminal.
+static void EscapeForTerm(std::string &str) {
+  static char const digits[] = "0123456789abcdef";
+  std::string escaped;
+  for (char n : str) {
+    unsigned c = static_cast<unsigned>(n & 0xff);
+    if (c < 0x20 || c > 0x7f) {
+      escaped += "\\x";
+      escaped += digits[c >> 4];
+      escaped += digits[c & 15];
+    } else {
+      escaped += n;
+    }
+  }
+  str.swap(escaped);
+}
+
+template <typename T>
+static void AppendFormatted(std::string &out, std::string const &spec,
+                            int const *stars, int nstars, T value) {
+  char buffer[128];
+  std::vector<char> large;
+  char *str = buffer;
+  size_t size = sizeof(buffer);
+
+  for (;;) {
+    int required;
+    switch (nstars) {
+    case 0:
+      required = ds2::Utils::SNPrintf(str, size, spec.c_str(), value);
+      break;
+    case 1:
+      required = ds2::Utils::SNPrintf(str, size, spec.c_str(), stars[0], value);
+      break;
+    default:
+      required = ds2::Utils::SNPrintf(str, size, spec.c_str(), stars[0],
+                                      stars[1], value);
+      break;
+    }
+    if (required < 0) {
+      return;
+    }
+    if (static_cast<size_t>(required) < size) {
+      out.append(str, required);
+      return;
+    }
+    large.resize(required + 1);
+    str = large.data();
+    size = large.size();
+  }
+}
+
+static void FormatArguments(int level, char const *format, char const *args,
+                            char const *end, std::string &out) {
+  ParseFormat(format, [&](char const *spec, size_t length, int nstars,
+                          ArgumentKind const *kind) {
+    if (kind == nullptr) {
+      out.append(spec, length);
+      return;
+    }
+
+    std::string specStr(spec, length);
+    int stars[2];
+    for (int n = 0; n < nstars; n++) {
+      stars[n] = ReadValue<int>(args, end);
+    }
+
+    switch (*kind) {
+    case kArgumentInt:
+      AppendFormatted(out, specStr, stars, nstars, ReadValue<int>(args, end));
+      break;
+    case kArgumentLong:
+      AppendFormatted(out, specStr, stars, nstars, ReadValue<long>(args, end));
+      break;
+    case kArgumentLongLong:
+      AppendFormatted(out, specStr, stars, nstars,
+                      ReadValue<long long>(args, end));
+      break;
+    case kArgumentIntMax:
+      AppendFormatted(out, specStr, stars, nstars,
+                      ReadValue<intmax_t>(args, end));
+      break;
+    case kArgumentSize:
+      AppendFormatted(out, specStr, stars, nstars,
+                      ReadValue<size_t>(args, end));
+      break;
+    case kArgumentPtrDiff:
+      AppendFormatted(out, specStr, stars, nstars,
+                      ReadValue<ptrdiff_t>(args, end));
+      break;
+    case kArgumentDouble:
+      AppendFormatted(out, specStr, stars, nstars,
+                      ReadValue<double>(args, end));
+      break;
+    case kArgumentLongDouble:
+      AppendFormatted(out, specStr, stars, nstars,
+                      ReadValue<long double>(args, end));
+      break;
+    case kArgumentPointer:
+      if (specStr.back() == 'n') {
+        // Nothing to print, and nothing to write back to.
+        ReadValue<void *>(args, end);
+        break;
+      }
+      AppendFormatted(out, specStr, stars, nstars,
+                      ReadValue<void *>(args, end));
+      break;
+    case kArgumentString: {
+      uint32_t strLength = ReadValue<uint32_t>(args, end);
+      DS2ASSERT(args + strLength <= end);
+      std::string str(args, strLength);
+      args += strLength;
+      if (level == kLogLevelPacket) {
+        EscapeForTerm(str);
+      }
+      AppendFormatted(out, specStr, stars, nstars, str.c_str());
+    } break;
+    }
+  });
+}
+
+// Formats a full log line, with its prefix, and appends it to `out`.
+static void FormatLine(int level, char const *classname, char const *funcname,
+                       std::string const &message, std::string &out) {
+  std::stringstream ss;
 
   std::stringstream functag;
   if (classname != nullptr)
@@ -167,18 +617,203 @@ static void vLog(int level, char const *classname, char const *funcname,
     ss << label << ':';
   }
 
-  ss << ' ' << buffer.data() << std::endl;
+  ss << ' ' << message << std::endl;
 
 // Pollute system loggers (logcat, dbgview) if they are available.
 #if defined(OS_WIN32)
   OutputDebugStringA(ss.str().c_str());
 #elif defined(PLATFORM_ANDROID)
-  androidLogcat(level, functag.str().c_str(), buffer.data());
+  androidLogcat(level, functag.str().c_str(), message.c_str());
 #endif
 
-  fputs(ss.str().c_str(), sOutputStream);
+  out += ss.str();
+}
+
+// Formats and writes every pending record. The writer lock must be held.
+//
+// Each thread has its own ring, so the records of all rings are sorted by
+// sequence number before being written out; this keeps the log in the order
+// the events happened in across threads.
+static void DrainRings(LogWriter &writer) {
+  std::vector<std::pair<uint64_t, std::string>> records;
+  std::string record;
+  std::string message;
+  std::string output;
+
+  for (auto it = writer.rings.begin(); it != writer.rings.end();) {
+    LogRing *ring = *it;
+    // Check for orphans first, a thread could push a last record between
+    // our last pop() and the check.
+    bool orphaned = ring->orphaned;
+
+    while (ring->pop(record)) {
+      RecordHeader header;
+      DS2ASSERT(record.size() >= sizeof(header));
+      std::memcpy(&header, record.data(), sizeof(header));
+      records.emplace_back(header.sequence, std::move(record));
+      record.clear();
+    }
+
+    if (orphaned) {
+      delete ring;
+      it = writer.rings.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  std::sort(records.begin(), records.end(),
+            [](std::pair<uint64_t, std::string> const &lhs,
+               std::pair<uint64_t, std::string> const &rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  for (auto const &entry : records) {
+    RecordHeader header;
+    std::memcpy(&header, entry.second.data(), sizeof(header));
+
+    message.clear();
+    FormatArguments(header.level, header.format, &entry.second[sizeof(header)],
+                    &entry.second[0] + entry.second.size(), message);
+    FormatLine(header.level, header.classname, header.funcname, message,
+               output);
+  }
+
+  if (!output.empty()) {
+    fputs(output.c_str(), sOutputStream);
+    fflush(sOutputStream);
+  }
+}
+
+static void WriterThread(uint32_t generation) {
+  LogWriter &writer = GetLogWriter();
+  std::unique_lock<std::mutex> guard(writer.lock);
+
+  // A fork()'d child doesn't inherit this thread, and will start its own.
+  while (writer.running && writer.generation == generation) {
+    writer.wakeup.wait_for(guard, std::chrono::milliseconds(10));
+    DrainRings(writer);
+  }
+}
+
+static void FlushLogAtExit() { FlushLog(); }
+
+#if defined(OS_POSIX)
+static void PrepareFork() { GetLogWriter().lock.lock(); }
+
+static void ParentFork() { GetLogWriter().lock.unlock(); }
+
+// The child only has the thread that called fork(), and it will most likely
+// exec() or _exit() soon, so log synchronously from now on. Long-lived
+// children can turn asynchronous logging back on.
+static void ChildFork() {
+  LogWriter &writer = GetLogWriter();
+  writer.running = false;
+  writer.rings.clear();
+  writer.generation++;
+  sAsynchronous = false;
+  writer.lock.unlock();
+}
+#endif
+
+// Returns the calling thread's ring, registering it and starting the writer
+// thread if needed. The writer lock must be held.
+static LogRing *RegisterThreadRing(LogWriter &writer) {
+  if (!writer.hooksInstalled) {
+#if defined(OS_POSIX)
+    ::pthread_atfork(PrepareFork, ParentFork, ChildFork);
+#endif
+    std::atexit(FlushLogAtExit);
+    writer.hooksInstalled = true;
+  }
+
+  if (!writer.running) {
+    writer.running = true;
+    std::thread(WriterThread, writer.generation).detach();
+  }
+
+  auto ring = new LogRing;
+  writer.rings.push_back(ring);
+  return ring;
+}
+
+static LogRing *GetThreadRing() {
+  static thread_local ThreadLogRing threadRing;
+  LogWriter &writer = GetLogWriter();
+
+  if (threadRing.ring == nullptr ||
+      threadRing.generation != writer.generation) {
+    std::lock_guard<std::mutex> guard(writer.lock);
+    threadRing.ring = RegisterThreadRing(writer);
+    threadRing.generation = writer.generation;
+  }
+
+  return threadRing.ring;
+}
+
+void FlushLog() {
+  LogWriter &writer = GetLogWriter();
+
+  // This can be called while handling a fatal signal, possibly on the writer
+  // thread itself; don't risk deadlocking.
+  std::unique_lock<std::mutex> guard(writer.lock, std::try_to_lock);
+  if (guard.owns_lock()) {
+    DrainRings(writer);
+  }
+}
+
+static void vLog(int level, char const *classname, char const *funcname,
+                 char const *format, va_list ap) {
+  if (level < gLogLevel) {
+    return;
+  }
+
+  static thread_local std::string record;
+  RecordHeader header = {sSequence.fetch_add(1, std::memory_order_relaxed),
+                         level, classname, funcname, format};
+
+  record.clear();
+  record.append(reinterpret_cast<char const *>(&header), sizeof(header));
+  EncodeArguments(format, ap, record);
+
+  if (level != kLogLevelFatal && sAsynchronous &&
+      record.size() + sizeof(uint32_t) <= LogRing::kCapacity) {
+    LogRing *ring = GetThreadRing();
+    while (!ring->push(record)) {
+      GetLogWriter().wakeup.notify_one();
+      std::this_thread::yield();
+    }
+    return;
+  }
+
+  std::string message;
+  std::string output;
+  FormatArguments(level, format, &record[sizeof(header)],
+                  &record[0] + record.size(), message);
+  FormatLine(level, classname, funcname, message, output);
+
+  // Synchronous path: make sure whatever was logged before this goes out
+  // first, and that the stream isn't replaced while we write to it. A fatal
+  // error can come from a thread that holds the lock already; write anyway
+  // rather than deadlock.
+  LogWriter &writer = GetLogWriter();
+  std::unique_lock<std::mutex> guard(writer.lock, std::defer_lock);
+  if (level == kLogLevelFatal) {
+    guard.try_lock();
+  } else {
+    guard.lock();
+  }
+  if (guard.owns_lock()) {
+    DrainRings(writer);
+  }
+
+  fputs(output.c_str(), sOutputStream);
   fflush(sOutputStream);
 
+  if (guard.owns_lock()) {
+    guard.unlock();
+  }
+
   if (level == kLogLevelFatal) {
     ds2::Utils::PrintBacktrace();
     abort();
@@ -49,6 +49,9 @@ void Daemonize() {
   open("/dev/null", O_RDONLY);
   open("/dev/null", O_WRONLY);
   open("/dev/null", O_WRONLY);
+
+  // See SetLogAsynchronous(); the log writer thread didn't survive fork().
+  ds2::SetLogAsynchronous(true);
 }
 } // namespace Utils
 } // namespace ds2
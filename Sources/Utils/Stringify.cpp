@@ -79,6 +79,9 @@ char const *Stringify::StopReason(StopInfo::Reason reason) {
     DO_STRINGIFY(StopInfo::kReasonThreadSpawn)
     DO_STRINGIFY(StopInfo::kReasonThreadEntry)
     DO_STRINGIFY(StopInfo::kReasonThreadExit)
+    DO_STRINGIFY(StopInfo::kReasonFork)
+    DO_STRINGIFY(StopInfo::kReasonVFork)
+    DO_STRINGIFY(StopInfo::kReasonVForkDone)
 #if defined(OS_WIN32)
     DO_STRINGIFY(StopInfo::kReasonMemoryError)
     DO_STRINGIFY(StopInfo::kReasonMemoryAlignment)
@@ -11,21 +11,31 @@
 #include "DebugServer2/Core/BreakpointManager.h"
 #include "DebugServer2/Core/SessionThread.h"
 #include "DebugServer2/GDBRemote/DebugSessionImpl.h"
+#include "DebugServer2/GDBRemote/PacketRecorder.h"
 #include "DebugServer2/GDBRemote/PlatformSessionImpl.h"
 #include "DebugServer2/GDBRemote/ProtocolHelpers.h"
+#include "DebugServer2/GDBRemote/ReplaySessionDelegateImpl.h"
 #include "DebugServer2/GDBRemote/SlaveSessionImpl.h"
 #include "DebugServer2/Host/Platform.h"
+#if defined(OS_LINUX)
+#include "DebugServer2/Host/Linux/SocketServer.h"
+#endif
+#include "DebugServer2/Host/MemoryChannel.h"
 #include "DebugServer2/Host/QueueChannel.h"
 #include "DebugServer2/Host/Socket.h"
 #include "DebugServer2/Utils/Daemon.h"
 #include "DebugServer2/Utils/Log.h"
 #include "DebugServer2/Utils/OptParse.h"
 #include "DebugServer2/Utils/String.h"
+#include "DebugServer2/Utils/Stringify.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <fcntl.h>
 #include <iomanip>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -35,10 +45,13 @@
 #endif
 
 using ds2::GDBRemote::DebugSessionImpl;
+using ds2::GDBRemote::PacketRecorder;
 using ds2::GDBRemote::PlatformSessionImpl;
+using ds2::GDBRemote::ReplaySessionDelegateImpl;
 using ds2::GDBRemote::Session;
 using ds2::GDBRemote::SessionDelegate;
 using ds2::GDBRemote::SlaveSessionImpl;
+using ds2::Host::MemoryChannel;
 using ds2::Host::Platform;
 using ds2::Host::QueueChannel;
 using ds2::Host::Socket;
@@ -47,6 +60,8 @@ static std::string gDefaultPort = "12345";
 static std::string gDefaultHost = "127.0.0.1";
 static bool gDaemonize = false;
 static bool gGDBCompat = false;
+static int gBacklog = Socket::kDefaultBacklog;
+static std::string gRecordFile;
 
 #if defined(OS_POSIX)
 static void CloseFD() {
@@ -97,7 +112,7 @@ static std::unique_ptr<Socket> CreateTCPSocket(std::string const &host,
              socket->port().c_str());
     }
   } else {
-    if (!socket->listen(host, port)) {
+    if (!socket->listen(host, port, gBacklog)) {
       DS2LOG(Fatal, "cannot listen on [%s:%s]: %s", host.c_str(), port.c_str(),
              socket->error().c_str());
     } else {
@@ -129,7 +144,7 @@ static std::unique_ptr<Socket> CreateUNIXSocket(std::string const &path,
 
   auto socket = ds2::make_unique<Socket>();
 
-  if (!socket->listen(path, abstract)) {
+  if (!socket->listen(path, abstract, gBacklog)) {
     DS2LOG(Fatal, "cannot listen on %s: %s", path.c_str(),
            socket->error().c_str());
   } else {
@@ -196,9 +211,13 @@ static int RunDebugServer(Socket *socket, SessionDelegate *impl) {
                              : ds2::GDBRemote::kCompatibilityModeLLDB);
   QueueChannel qchannel(socket);
   SessionThread thread(&qchannel, &session);
+  PacketRecorder recorder;
 
   session.setDelegate(impl);
   session.create(&qchannel);
+  if (!gRecordFile.empty() && recorder.open(gRecordFile)) {
+    session.setRecorder(&recorder);
+  }
 
   DS2LOG(Debug, "Debug session starting");
   thread.start();
@@ -276,6 +295,12 @@ static int GdbserverMain(int argc, char **argv) {
                  "connect back to the debugger at [HOST]:PORT");
   opts.addOption(ds2::OptParse::boolOption, "native-regs", 'r',
                  "use native registers (no-op)", true);
+  opts.addOption(ds2::OptParse::stringOption, "expedite-stack", 'x',
+                 "bytes of stack memory to send with stop replies");
+  opts.addOption(ds2::OptParse::stringOption, "output-rate-limit", 'L',
+                 "maximum bytes per second of inferior output to forward");
+  opts.addOption(ds2::OptParse::stringOption, "record-packets", 'P',
+                 "record received packets to a file for 'ds2 replay'");
 
 #if defined(OS_POSIX)
   opts.addOption(ds2::OptParse::stringOption, "fd", 'F',
@@ -333,6 +358,7 @@ static int GdbserverMain(int argc, char **argv) {
                       : atoi(opts.getString("attach").c_str());
 
   gGDBCompat = opts.getBool("gdb-compat");
+  gRecordFile = opts.getString("record-packets");
   if (gGDBCompat && args.empty() && attachPid < 0) {
     // In GDB compatibility mode, we need a process to attach to or a command
     // line so we can launch it.
@@ -401,6 +427,22 @@ static int GdbserverMain(int argc, char **argv) {
   else
     impl = ds2::make_unique<DebugSessionImpl>();
 
+  if (!opts.getString("expedite-stack").empty()) {
+    int size = std::atoi(opts.getString("expedite-stack").c_str());
+    if (size < 0) {
+      opts.usageDie("--expedite-stack must be a non-negative number");
+    }
+    impl->setExpeditedStackSize(size);
+  }
+
+  if (!opts.getString("output-rate-limit").empty()) {
+    int rate = std::atoi(opts.getString("output-rate-limit").c_str());
+    if (rate < 0) {
+      opts.usageDie("--output-rate-limit must be a non-negative number");
+    }
+    impl->setOutputRateLimit(rate);
+  }
+
 #if defined(OS_POSIX)
   return RunDebugServer(
       (fd >= 0 || reverse) ? socket.get() : socket->accept().get(), impl.get());
@@ -421,6 +463,14 @@ static int PlatformMain(int argc, char **argv) {
                  "specify the [host]:port to listen on");
   opts.addOption(ds2::OptParse::boolOption, "server", 's',
                  "create a new process for each client (default)", true);
+  opts.addOption(ds2::OptParse::stringOption, "backlog", 'b',
+                 "maximum number of pending connections");
+  opts.addOption(ds2::OptParse::stringOption, "max-connections", 'm',
+                 "maximum number of clients served at once");
+  opts.addOption(ds2::OptParse::stringOption, "workers", 'w',
+                 "number of threads processing client requests");
+  opts.addOption(ds2::OptParse::stringOption, "server-pool", 'p',
+                 "number of debug servers to keep ready for clients");
 
   opts.parse(argc, argv);
   HandleSharedOptions(opts);
@@ -429,17 +479,58 @@ static int PlatformMain(int argc, char **argv) {
     opts.usageDie("--listen required in platform mode");
   }
 
-  struct PlatformClient {
+  // Counts left empty get their default, which callers see as zero.
+  auto getCount = [&opts](char const *name, long minimum) -> long {
+    std::string const &value = opts.getString(name);
+    if (value.empty()) {
+      return 0;
+    }
+
+    char *end;
+    long count = std::strtol(value.c_str(), &end, 10);
+    if (*end != '\0' || count < minimum) {
+      opts.usageDie("--%s must be a %s number", name,
+                    minimum > 0 ? "positive" : "non-negative");
+    }
+    return count;
+  };
+
+  if (!opts.getString("backlog").empty()) {
+    gBacklog = getCount("backlog", 1);
+  }
+
+  long serverPool = getCount("server-pool", 0);
+#if defined(OS_LINUX)
+  // SocketServer picks its own default for a count of zero.
+  long maxConnections = getCount("max-connections", 1);
+  long workers = getCount("workers", 1);
+#endif
+
+  struct PlatformClient
+#if defined(OS_LINUX)
+      : public ds2::Host::Linux::SocketServer::ConnectionHandler
+#endif
+  {
     std::unique_ptr<Socket> socket;
     PlatformSessionImpl impl;
     Session session;
 
-    PlatformClient(std::unique_ptr<Socket> socket_)
-        : socket(std::move(socket_)),
-          session(ds2::GDBRemote::kCompatibilityModeLLDB) {
+    PlatformClient(Socket *socket_)
+        : session(ds2::GDBRemote::kCompatibilityModeLLDB) {
       session.setDelegate(&impl);
-      session.create(socket.get());
+      session.create(socket_);
+    }
+
+    PlatformClient(std::unique_ptr<Socket> socket_)
+        : PlatformClient(socket_.get()) {
+      socket = std::move(socket_);
+    }
+
+#if defined(OS_LINUX)
+    bool onData(std::string const &data) override {
+      return session.parse(data);
     }
+#endif
   };
 
   std::unique_ptr<Socket> serverSocket =
@@ -449,6 +540,25 @@ static int PlatformMain(int argc, char **argv) {
     ds2::Utils::Daemonize();
   }
 
+  // Debug servers are spawned from background threads, start after we're
+  // done forking.
+  if (serverPool > 0) {
+    PlatformSessionImpl::SetDebugServerPoolSize(serverPool);
+  }
+
+#if defined(OS_LINUX)
+  // Serve every client from a single epoll set and a bounded pool of
+  // workers instead of spawning one thread per connection.
+  ds2::Host::Linux::SocketServer server(
+      std::move(serverSocket),
+      [](Socket *socket) { return ds2::make_unique<PlatformClient>(socket); },
+      maxConnections, workers);
+
+  ds2::ErrorCode error = server.run();
+  DS2LOG(Error, "platform server stopped: %s",
+         ds2::Utils::Stringify::Error(error));
+  return EXIT_FAILURE;
+#else
   do {
     std::unique_ptr<Socket> clientSocket = serverSocket->accept();
     auto platformClient =
@@ -464,6 +574,7 @@ static int PlatformMain(int argc, char **argv) {
 
     thread.detach();
   } while (true);
+#endif
 }
 
 static int SlaveMain(int argc, char **argv) {
@@ -471,18 +582,29 @@ static int SlaveMain(int argc, char **argv) {
 
   ds2::OptParse opts;
   AddSharedOptions(opts);
+  // Used by the debug server pool of the platform, which wants its servers
+  // to be its own children.
+  opts.addOption(ds2::OptParse::boolOption, "no-fork", 'F',
+                 "serve from this process instead of a forked child", true);
   opts.parse(argc, argv);
   HandleSharedOptions(opts);
 
   std::unique_ptr<Socket> server = CreateTCPSocket(gDefaultHost, "0", false);
   std::string port = server->port();
 
-  pid_t pid = ::fork();
+  pid_t pid = opts.getBool("no-fork") ? 0 : ::fork();
   if (pid < 0) {
     DS2LOG(Fatal, "cannot fork: %s", strerror(errno));
   }
 
   if (pid == 0) {
+    if (opts.getBool("no-fork")) {
+      // Our standard output is closed below, which tells our parent the
+      // line is complete.
+      ::fprintf(stdout, "%s %d\n", port.c_str(), ::getpid());
+      ::fflush(stdout);
+    }
+
     // When in slave mode, output is suppressed but for standard error.
     close(0);
     close(1);
@@ -490,6 +612,10 @@ static int SlaveMain(int argc, char **argv) {
     open("/dev/null", O_RDONLY);
     open("/dev/null", O_WRONLY);
 
+    // Logging falls back to synchronous mode after fork(), we are a
+    // long-lived server so turn it back on.
+    ds2::SetLogAsynchronous(true);
+
     std::unique_ptr<Socket> client = server->accept();
 
     SlaveSessionImpl impl;
@@ -504,6 +630,100 @@ static int SlaveMain(int argc, char **argv) {
 }
 #endif
 
+//
+// Replays packets recorded with --record-packets against a fake inferior
+// over an in-memory channel, and reports how fast the protocol layer
+// (interpreter, session handlers, packet encoding) processed them.
+//
+static int ReplayMain(int argc, char **argv) {
+  DS2ASSERT(argv[1][0] == 'r');
+
+  ds2::OptParse opts;
+  AddSharedOptions(opts);
+  opts.addOption(ds2::OptParse::boolOption, "gdb-compat", 'g',
+                 "replay in gdb compat mode");
+  opts.addOption(ds2::OptParse::stringOption, "iterations", 'i',
+                 "number of times to replay the recording (default 1)");
+  opts.addPositional("file", "packets recorded with --record-packets");
+  opts.parse(argc, argv);
+  HandleSharedOptions(opts);
+
+  if (opts.getPositional("file").empty()) {
+    opts.usageDie("a recording is required");
+  }
+
+  int iterations = 1;
+  if (!opts.getString("iterations").empty()) {
+    iterations = std::atoi(opts.getString("iterations").c_str());
+    if (iterations <= 0) {
+      opts.usageDie("--iterations must be a positive number");
+    }
+  }
+
+  std::vector<std::string> packets;
+  if (!PacketRecorder::Load(opts.getPositional("file"), packets)) {
+    return EXIT_FAILURE;
+  }
+
+  struct HandlerTiming {
+    uint64_t count;
+    std::chrono::nanoseconds total;
+  };
+  std::map<std::string, HandlerTiming> timings;
+
+  Session session(opts.getBool("gdb-compat")
+                      ? ds2::GDBRemote::kCompatibilityModeGDB
+                      : ds2::GDBRemote::kCompatibilityModeLLDB);
+  MemoryChannel channel;
+  ReplaySessionDelegateImpl impl;
+
+  session.setDelegate(&impl);
+  session.create(&channel);
+  session.interpreter().setTimingCallback(
+      [&timings](std::string const &command,
+                 std::chrono::nanoseconds elapsed) {
+        HandlerTiming &timing =
+            timings[command.empty() ? "(unsupported)" : command];
+        timing.count++;
+        timing.total += elapsed;
+      });
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    for (auto const &packet : packets) {
+      channel.push(packet);
+      session.receive(/*cooked=*/true);
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  uint64_t npackets = static_cast<uint64_t>(packets.size()) * iterations;
+  ::fprintf(stdout, "%" PRIu64 " packets in %.3f s: %.0f packets/s, %" PRIu64
+                    " bytes sent\n",
+            npackets, elapsed.count(),
+            elapsed.count() > 0 ? npackets / elapsed.count() : 0.0,
+            channel.sentBytes());
+
+  std::vector<std::pair<std::string, HandlerTiming>> sorted(timings.begin(),
+                                                            timings.end());
+  std::sort(sorted.begin(), sorted.end(),
+            [](std::pair<std::string, HandlerTiming> const &a,
+               std::pair<std::string, HandlerTiming> const &b) {
+              return a.second.total > b.second.total;
+            });
+
+  ::fprintf(stdout, "%-24s %10s %12s %10s\n", "handler", "count", "total ms",
+            "avg us");
+  for (auto const &e : sorted) {
+    double totalMs = e.second.total.count() / 1e6;
+    ::fprintf(stdout, "%-24s %10" PRIu64 " %12.3f %10.3f\n", e.first.c_str(),
+              e.second.count, totalMs, totalMs * 1e3 / e.second.count);
+  }
+
+  return EXIT_SUCCESS;
+}
+
 static int VersionMain(int argc, char **argv) {
   std::stringstream ss;
   ss << "ds2 at ";
@@ -519,8 +739,8 @@ static int VersionMain(int argc, char **argv) {
 }
 
 [[noreturn]] static void UsageDie(char const *argv0) {
-  std::vector<std::pair<std::string, bool>> modes = {{"version", false},
-                                                     {"gdbserver", true}};
+  std::vector<std::pair<std::string, bool>> modes = {
+      {"version", false}, {"gdbserver", true}, {"replay", true}};
 #if !defined(OS_WIN32)
   modes.emplace_back("platform", true);
 #endif
@@ -571,6 +791,8 @@ int main(int argc, char **argv) {
   case 's':
     return SlaveMain(argc, argv);
 #endif
+  case 'r':
+    return ReplayMain(argc, argv);
   case 'v':
     return VersionMain(argc, argv);
   default: